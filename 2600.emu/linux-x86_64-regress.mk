@@ -0,0 +1,2 @@
+include $(IMAGINE_PATH)/make/shortcut/common-builds/linux-x86_64-release.mk
+include $(EMUFRAMEWORK_PATH)/make/regress.mk
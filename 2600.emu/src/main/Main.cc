@@ -161,7 +161,7 @@ void EmuSystem::runFrame(EmuVideo &video, bool renderGfx, bool processGfx, bool
 	}
 	auto frames = audioFramesPerVideoFrame;
 	Int16 buff[frames * soundChannels];
-	uint writtenFrames = osystem.soundGeneric().processAudio(buff, frames);
+	uint writtenFrames = osystem.soundGeneric().processAudio(renderAudio ? buff : nullptr, frames);
 	if(renderAudio)
 		writeSound(buff, writtenFrames);
 }
@@ -65,6 +65,15 @@ unsigned int SoundGeneric::processAudio(Int16* stream, unsigned int maxLength)
 		}
 	}
 
+	// without a stream only the register writes are applied, the TIA's sound
+	// counters aren't part of saved states so skipping them loses nothing
+	auto process =
+		[&](uInt32 pos, uInt32 samples)
+		{
+			if(stream)
+				myTIASound.process(stream + pos * channels, samples);
+		};
+
 	double position = 0.0;
 	double remaining = length;
 
@@ -74,8 +83,7 @@ unsigned int SoundGeneric::processAudio(Int16* stream, unsigned int maxLength)
 		{
 			// There are no more pending TIA sound register updates so we'll
 			// use the current settings to finish filling the sound fragment
-			myTIASound.process(stream + ((uInt32)position * channels),
-					length - (uInt32)position);
+			process((uInt32)position, length - (uInt32)position);
 
 			// Since we had to fill the fragment we'll reset the cycle counter
 			// to zero.  NOTE: This isn't 100% correct, however, it'll do for
@@ -103,7 +111,7 @@ unsigned int SoundGeneric::processAudio(Int16* stream, unsigned int maxLength)
 					// Process the fragment upto the next TIA register write.  We
 					// round the count passed to process up if needed.
 					double samples = (tiaSoundRate * info.delta);
-					myTIASound.process(stream + ((uInt32)position * channels),
+					process((uInt32)position,
 							(uInt32)samples + (uInt32)(position + samples) -
 							((uInt32)position + (uInt32)samples));
 
@@ -118,8 +126,7 @@ unsigned int SoundGeneric::processAudio(Int16* stream, unsigned int maxLength)
 				// The next register update occurs in the next fragment so finish
 				// this fragment with the current TIA settings and reduce the register
 				// update delay by the corresponding amount of time
-				myTIASound.process(stream + ((uInt32)position * channels),
-						length - (uInt32)position);
+				process((uInt32)position, length - (uInt32)position);
 				info.delta -= duration;
 				break;
 			}
@@ -127,6 +127,7 @@ public:
 
 	std::string name() const { return "TIASound"; }
 
+	// a null stream applies the queued register writes without synthesizing samples
 	unsigned int processAudio(Int16* stream, unsigned int maxLength);
 };
 
@@ -574,11 +574,12 @@ void EmuSystem::runFrame(EmuVideo &video, bool renderGfx, bool processGfx, bool
 	doAudio = renderAudio;
 	setCanvasSkipFrame(!processGfx);
 	execC64Frame();
-	if(renderGfx)
+	if(processGfx)
 	{
 		video.setFormat(canvasSrcPix);
 		video.writeFrame(canvasSrcPix);
-		EmuApp::updateAndDrawEmuVideo();
+		if(renderGfx)
+			EmuApp::updateAndDrawEmuVideo();
 	}
 	runningFrame = 0;
 }
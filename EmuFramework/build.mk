@@ -28,7 +28,19 @@ EmuInputView.cc \
 EmuVideoLayer.cc \
 Cheats.cc \
 Recent.cc \
-EmuLoadProgressView.cc
+EmuLoadProgressView.cc \
+BackupMemory.cc \
+AVRecorder.cc \
+InputMovie.cc \
+StateHash.cc \
+FramePacing.cc \
+RegressionFarm.cc \
+CheatPatchTable.cc \
+CheatSearch.cc \
+Netplay.cc \
+BootSnapshot.cc \
+MemoryStats.cc \
+StartupProfiler.cc
 
 ifeq ($(emuFramework_onScreenControls), 1)
  SRC += TouchConfigView.cc \
@@ -0,0 +1,45 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <imagine/fs/FS.hh>
+#include <imagine/pixmap/Pixmap.hh>
+#include <imagine/util/audio/PcmFormat.hh>
+#include <system_error>
+
+// Lossless gameplay recording. Frames and PCM are copied into a ring buffer
+// from the emulation thread and written by an encoder thread to a pair of
+// files sharing the same base path:
+//   .rgb - headerless raw video frames in the emulated pixel format
+//   .wav - PCM audio
+// Video frames are repeated as needed to stay in step with the audio so
+// both streams have the same duration. The log contains the ffmpeg
+// command line to mux them.
+
+class AVRecorder
+{
+public:
+	static std::error_code start(const char *basePath, IG::PixmapDesc videoDesc, double frameTime, Audio::PcmFormat pcmFormat);
+	static void stop();
+	static bool isRecording();
+	static void writeVideo(IG::Pixmap pix);
+	static void writeAudio(const void *samples, uint frames);
+	// frames/packets dropped because the encoder thread couldn't keep up
+	static uint droppedPackets();
+};
+
+int sprintRecordingBasePath(FS::PathString &str);
@@ -0,0 +1,71 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <imagine/fs/FS.hh>
+#include <imagine/base/baseDefs.hh>
+#include <imagine/util/DelegateFunc.hh>
+#include <vector>
+
+// Write-behind persistence of battery-backed memory (SRAM, EEPROM, Flash).
+// Cores register the memory they save with watch() and describe the files
+// to write in their OnSnapshotDelegate. Watched memory is checked for changes
+// a few pages at a time between frames and once it stops changing for a
+// while, a copy is taken on the main thread and written on a worker thread.
+
+class BackupMemory
+{
+public:
+	static constexpr uint PAGE_SIZE = 1024;
+
+	class Snapshot
+	{
+	public:
+		Snapshot() {}
+		// copies data to be appended to the file at path
+		void write(const char *path, const void *data, uint size, bool byteSwap16 = false);
+		void write(const FS::PathString &path, const void *data, uint size, bool byteSwap16 = false)
+		{
+			write(path.data(), data, size, byteSwap16);
+		}
+		bool writeFiles();
+		explicit operator bool() const { return files.size(); }
+
+	private:
+		struct File
+		{
+			FS::PathString path{};
+			std::vector<uint8> data{};
+		};
+		std::vector<File> files{};
+	};
+
+	using OnSnapshotDelegate = DelegateFunc<void (Snapshot &snapshot)>;
+
+	static void watch(const void *data, uint size);
+	static void setOnSnapshot(OnSnapshotDelegate del);
+	static void markDirty();
+	static void update(Base::FrameTimeBase time);
+	// writes changed memory now instead of waiting for it to go quiet,
+	// with wait set it also blocks until the data is on disk
+	static bool flush(bool wait = false);
+	static void finishWrites();
+	static void reset();
+	static bool isDirty();
+	static bool isActive();
+	static void setQuietTime(Base::FrameTimeBase time);
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+
+class IO;
+
+// Skips slow BIOS boots by caching a state taken a fixed number of frames
+// after power-on, as given by EmuSystem::bootSnapshotFrames(). The first
+// launch of a game captures it if no input arrived during the boot, later
+// launches and hard resets restore it instead of running the boot again.
+// Snapshots are kept in memory for the last few games and in the save path,
+// keyed by a hash of the game's content, including any patch applied to it,
+// and EmuSystem::bootSnapshotConfig() so a BIOS, patch, or option change
+// captures a new one.
+
+class BootSnapshot
+{
+public:
+	// call right after the system powers on, returns true if a snapshot was restored
+	static bool onPowerOn();
+	static void onFrame();
+	// stops a pending capture, called for input, loaded states, and anything
+	// else that makes the boot differ from a plain power-on
+	static void cancel();
+	static bool isCapturing();
+	// CRC32C of the content and size, large files are only sampled
+	static uint32 hashContent(IO &io, uint32 crc = 0);
+	// set from the loaded content, 0 hashes the game file on the next power-on
+	static void setContentKey(uint32 key);
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <array>
+#include <vector>
+
+// Per-frame memory patches for RAM cheats. Codes are added with their target
+// region and offset, then compile() sorts them, drops bytes overwritten by
+// later codes, and merges adjacent bytes into runs with pointers resolved in
+// advance, so apply() is a short list of memcpys no matter how codes are
+// written. Conditional codes only write while a compare value matches and are
+// applied after the unconditional runs in the order they were added.
+
+class CheatPatchTable
+{
+public:
+	static constexpr uint MAX_REGIONS = 4;
+
+	CheatPatchTable() {}
+	// memory a core exposes to cheats, compile() again if it moves
+	void setRegion(uint region, uint8 *mem, uint32 size);
+	// removes all codes but keeps the regions
+	void clear();
+	// returns false if the write doesn't fit in the region
+	bool addWrite(uint region, uint32 offset, const void *data, uint size);
+	bool addConditionalWrite(uint region, uint32 offset, const void *data, uint size,
+		uint32 compareOffset, const void *compare, uint compareSize, bool notEqual = false);
+	void compile();
+	void apply() const;
+	bool empty() const { return run.empty() && condRun.empty(); }
+	uint runs() const { return run.size() + condRun.size(); }
+
+private:
+	struct Code
+	{
+		uint8 region;
+		uint8 size;
+		uint8 compareSize;
+		bool notEqual;
+		uint32 offset;
+		uint32 compareOffset;
+		uint32 dataIdx; // compare bytes follow the data bytes
+	};
+
+	struct Run
+	{
+		uint8 *dest;
+		uint32 dataIdx;
+		uint32 size;
+	};
+
+	struct ConditionalRun
+	{
+		Run run;
+		const uint8 *test;
+		uint32 compareIdx;
+		uint8 compareSize;
+		bool notEqual;
+	};
+
+	struct Region
+	{
+		uint8 *mem{};
+		uint32 size{};
+	};
+
+	std::array<Region, MAX_REGIONS> region{};
+	std::vector<Code> code{};
+	std::vector<uint8> codeData{};
+	std::vector<Run> run{};
+	std::vector<ConditionalRun> condRun{};
+	std::vector<uint8> data{};
+
+	bool fitsRegion(uint region, uint32 offset, uint size) const;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <cstddef>
+
+// RAM search for finding cheat addresses. Cores register their RAM with
+// addRegion() when a game loads. Each step copies the regions into a
+// snapshot on the calling thread, which only takes a memcpy between frames,
+// then compares it on a worker thread against the previous snapshot or a
+// value. Every aligned value of the chosen size starts as a candidate and
+// each step keeps only those where the comparison holds. Candidates are a
+// bitmap so blocks of 64 that were already ruled out are skipped, and the
+// rest are compared 16 bytes at a time with SSE2 or NEON.
+
+class CheatSearch
+{
+public:
+	enum class Compare : uint8
+	{
+		EQUAL, NOT_EQUAL, LESS, GREATER, LESS_OR_EQUAL, GREATER_OR_EQUAL
+	};
+
+	struct Result
+	{
+		uint region;
+		uint32 offset;
+		int64 value;
+	};
+
+	// memory is read in host byte order
+	static void addRegion(const char *name, const void *data, size_t size);
+	static void clearRegions();
+	static bool hasRegions();
+	static const char *regionName(uint region);
+	// size is 1, 2, or 4 bytes, returns false if there are no regions or a step is running
+	static bool start(uint size, bool isSigned);
+	// compare current values to those at the last step, e.g. GREATER finds values that went up
+	static bool searchChanged(Compare compare);
+	static bool searchValue(Compare compare, int64 value);
+	// true from start() until stop()
+	static bool isActive();
+	// true while a step is running on the worker thread, results aren't valid until it's done
+	static bool isBusy();
+	static uint candidates();
+	// fills up to max results with the first candidates, returns how many were written
+	static uint results(Result *result, uint max);
+	static void stop();
+};
@@ -17,7 +17,10 @@
 
 #include <imagine/gui/TableView.hh>
 #include <imagine/gui/MenuItem.hh>
+#include <imagine/base/Timer.hh>
+#include <imagine/util/container/ArrayList.hh>
 #include <emuframework/EmuSystem.hh>
+#include <array>
 #include <vector>
 
 using RefreshCheatsDelegate = DelegateFunc<void ()>;
@@ -60,3 +63,29 @@ public:
 	BaseEditCheatView(const char *name, ViewAttachParams attach, const char *cheatName,
 		TableView::ItemsDelegate items, TableView::ItemDelegate item, TextMenuItem::SelectDelegate removed);
 };
+
+class CheatSearchView : public TableView
+{
+public:
+	CheatSearchView(ViewAttachParams attach);
+	~CheatSearchView() override;
+	void onShow() override;
+
+private:
+	static constexpr uint MAX_RESULTS = 16;
+	TextMenuItem start8, start16, start32;
+	BoolMenuItem useSigned;
+	TextMenuItem equalTo, changed, unchanged, increased, decreased, stop;
+	TextHeadingMenuItem status;
+	std::array<char, 40> statusStr{};
+	std::array<std::array<char, 48>, MAX_RESULTS> resultName{};
+	std::array<std::array<char, 32>, MAX_RESULTS> resultValue{};
+	std::array<DualTextMenuItem, MAX_RESULTS> result{};
+	StaticArrayList<MenuItem*, 11 + MAX_RESULTS> item{};
+	Base::Timer stepDoneTimer{};
+
+	void startSearch(uint size);
+	void stepStarted(bool started);
+	void loadItems();
+	void refresh();
+};
@@ -34,6 +34,8 @@ public:
 	bool inputEvent(Input::Event e) final;
 	void onAddedToController(Input::Event e) final {}
 	void resetInput();
+	// true if draw() puts any controls on screen
+	bool drawsControls() const;
 
 private:
 	void updateFastforward();
@@ -36,6 +36,9 @@ extern Byte1Option optionSoundBuffers;
 #define EMU_FRAMEWORK_STRICT_UNDERRUN_CHECK_OPTION
 extern OptionAudioHintStrictUnderrunCheck optionSoundUnderrunCheck;
 #endif
+#ifdef CONFIG_AUDIO_PULL_MODE
+extern OptionAudioHintPullMode optionSoundPullMode;
+#endif
 #ifdef CONFIG_AUDIO_MANAGER_SOLO_MIX
 using OptionAudioSoloMix = Option<OptionMethodFunc<bool, AudioManager::soloMix, AudioManager::setSoloMix>, uint8>;
 extern OptionAudioSoloMix optionAudioSoloMix;
@@ -55,6 +58,9 @@ extern Byte1Option optionHideStatusBar;
 extern OptionSwappedGamepadConfirm optionSwappedGamepadConfirm;
 extern Byte1Option optionConfirmOverwriteState;
 extern Byte1Option optionFastForwardSpeed;
+extern Byte1Option optionScreenshotCompression;
+extern Byte1Option optionScreenshotBurstSecs;
+extern Byte1Option optionStateHashInterval;
 #ifdef CONFIG_INPUT_DEVICE_HOTSWAP
 extern Byte1Option optionNotifyInputDeviceChange;
 #endif
@@ -139,6 +145,11 @@ extern Byte1Option optionDitherImage;
 #ifdef EMU_FRAMEWORK_WINDOW_PIXEL_FORMAT_OPTION
 extern Byte1Option optionWindowPixelFormat;
 #endif
+#ifdef CONFIG_BASE_X11
+// off, on, or only when GL is a software rasterizer
+static constexpr uint8 SOFTWARE_PRESENT_OFF = 0, SOFTWARE_PRESENT_ON = 1, SOFTWARE_PRESENT_AUTO = 2;
+extern Byte1Option optionSoftwarePresent;
+#endif
 
 static const char *optionSavePathDefaultToken = ":DEFAULT:";
 extern PathOption optionSavePath;
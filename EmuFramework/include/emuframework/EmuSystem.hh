@@ -24,8 +24,12 @@
 #include <imagine/input/Input.hh>
 #include <imagine/gui/View.hh>
 #include <imagine/util/audio/PcmFormat.hh>
+#include <imagine/util/audio/Resampler.hh>
 #include <imagine/util/string.h>
+#include <imagine/util/container/containerUtils.hh>
 #include <stdexcept>
+#include <memory>
+#include <vector>
 #include <experimental/optional>
 #include <emuframework/EmuVideo.hh>
 
@@ -114,6 +118,7 @@ public:
 	using OnLoadProgressDelegate = DelegateFunc<bool(int pos, int max, const char *label)>;
 
 	using Error = std::experimental::optional<std::runtime_error>;
+	class Instance;
 	using NameFilterFunc = bool(*)(const char *name);
 	static State state;
 	static FS::PathString savePath_;
@@ -145,10 +150,20 @@ public:
 	static double frameTimePAL;
 	static bool hasResetModes;
 	enum ResetMode { RESET_HARD, RESET_SOFT };
+	// runFrame() flag combinations in order of decreasing work
+	enum class FrameTier { FULL, NO_PRESENT, NO_VIDEO, NO_AUDIO };
+	struct BenchmarkResult
+	{
+		IG::Time time{};
+		uint videoFrames = 0; // frames composed into the EmuVideo
+		uint audioFrames = 0; // sound frames written
+	};
 	static bool handlesArchiveFiles;
 	static bool handlesGenericIO;
 	static bool hasCheats;
 	static bool hasSound;
+	static bool hasInstances;
+	static bool hasMemoryStates;
 	static int forcedSoundRate;
 	static bool constFrameRate;
 	static NameFilterFunc defaultFsFilter;
@@ -164,6 +179,18 @@ public:
 	static void startAutoSaveStateTimer();
 	static Error loadState(const char *path);
 	static Error saveState(const char *path);
+	// states kept in memory for rollback and boot snapshots, a buffer saved
+	// into again is reused without clearing. Cores setting hasMemoryStates
+	// serialize directly, the default implementation goes through a temporary file.
+	using MemoryState = std::vector<uint8, IG::NoInitAllocator<uint8>>;
+	static Error saveStateToMemory(MemoryState &data);
+	static Error loadStateFromMemory(const uint8 *data, size_t size);
+	static Error saveStateToMemoryWithFile(MemoryState &data);
+	static Error loadStateFromMemoryWithFile(const uint8 *data, size_t size);
+	// frames a slow BIOS boot takes from power-on, 0 if there's no boot worth skipping
+	static uint bootSnapshotFrames();
+	// everything besides the game that changes the boot, such as the BIOS file and region
+	static FS::PathString bootSnapshotConfig();
 	static bool stateExists(int slot);
 	static bool shouldOverwriteExistingState();
 	static const char *systemName();
@@ -199,7 +226,20 @@ public:
 	static FS::PathString willLoadGameFromPath(FS::PathString path);
 	static Error loadGameFromPath(const char *path, OnLoadProgressDelegate onLoadProgress);
 	static Error loadGameFromFile(GenericIO io, const char *name, OnLoadProgressDelegate onLoadProgress);
+	// Runs one frame, renderGfx implies processGfx. Whatever the flags, the
+	// emulated state must advance exactly as in a full frame since fast-forward,
+	// run-ahead, rollback and netplay mix them freely:
+	// renderGfx: compose the frame into the EmuVideo and draw it
+	// processGfx: compose the frame into the EmuVideo without drawing it
+	// neither: leave the EmuVideo untouched and skip any pixel work that
+	// doesn't feed back into emulation, like sprite collision flags do
+	// renderAudio: write sound, otherwise skip synthesis in the same way
 	[[gnu::hot]] static void runFrame(EmuVideo &video, bool renderGfx, bool processGfx, bool renderAudio);
+	static void runFrame(EmuVideo &video, FrameTier tier)
+	{
+		runFrame(video, tier == FrameTier::FULL, tier <= FrameTier::NO_PRESENT, tier <= FrameTier::NO_VIDEO);
+	}
+	static const char *frameTierName(FrameTier tier);
 	static void skipFrames(uint frames);
 	static void onPrepareVideo(EmuVideo &video);
 	static bool vidSysIsPAL();
@@ -226,13 +266,24 @@ public:
 	static void stopSound();
 	static void startSound();
 	static void writeSound(const void *samples, uint framesToWrite);
+	// resamples into the audio device's buffer when the backend provides one
+	static void writeSound(Audio::Resampler &resampler, const int16 *samples, uint frames);
+	// a buffer in the audio device to render into directly, empty when
+	// writeSound() must be used instead, always committed even with 0 frames
+	static Audio::BufferContext getSoundBuffer(uint wantedFrames);
+	static void commitSoundBuffer(Audio::BufferContext buffer, uint frames);
 	static uint advanceFramesWithTime(Base::FrameTimeBase time);
 	static void setupGamePaths(const char *filePath);
 	static void setGameSavePath(const char *path);
 	static void setupGameSavePath();
 	static void clearGamePaths();
 	static FS::PathString baseDefaultGameSavePath();
-	static IG::Time benchmark();
+	// runs 180 frames composing video without sound, the long standing
+	// benchmark whose fps is shown to the user
+	static BenchmarkResult benchmark();
+	// runs 180 frames at the tier and logs an error if the core did work the tier skips,
+	// FULL isn't allowed since it draws outside of the window's frame callback
+	static BenchmarkResult benchmark(FrameTier tier);
 	static bool gameIsRunning()
 	{
 		return !string_equal(gameName_.data(), "");
@@ -243,6 +294,8 @@ public:
 	static void start();
 	static void closeSystem();
 	static void closeGame(bool allowAutosaveState = 1);
+	// returns null if the core keeps its state in globals, see EmuSystemInstance.hh
+	static std::unique_ptr<Instance> makeInstance();
 	[[gnu::format(printf, 1, 2)]]
 	static Error makeError(const char *msg, ...);
 	static Error makeError(std::error_code ec);
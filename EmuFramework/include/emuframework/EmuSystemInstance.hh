@@ -0,0 +1,44 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <emuframework/EmuSystem.hh>
+#include <imagine/pixmap/Pixmap.hh>
+
+// A headless machine independent of the one driven by the static EmuSystem
+// API. Cores whose emulation state lives in objects instead of globals
+// implement EmuSystem::makeInstance() so any number of instances can run in
+// one process, each one on its own thread. An instance never touches the
+// app's video, audio, options, or save files beyond reading them when it's
+// created, so only one thread may use a given instance at a time but
+// separate instances need no locking.
+
+class EmuSystem::Instance
+{
+public:
+	virtual ~Instance() {}
+	virtual Error loadGame(IO &io, const char *name) = 0;
+	virtual void reset() = 0;
+	virtual void handleInputAction(uint state, uint emuKey) = 0;
+	virtual void clearInputBuffers() = 0;
+	// runs the same amount of emulated time as EmuSystem::runFrame(),
+	// returns true if a video frame completed in it
+	virtual bool runFrame(bool processGfx) = 0;
+	// last frame rendered by runFrame() with processGfx set
+	virtual IG::Pixmap videoPixmap() = 0;
+	virtual Error saveState(const char *path) = 0;
+	virtual Error loadState(const char *path) = 0;
+};
@@ -17,6 +17,7 @@
 
 #include <imagine/gfx/Gfx.hh>
 #include <imagine/gfx/Texture.hh>
+#include <emuframework/Screenshot.hh>
 
 class EmuVideo;
 
@@ -57,6 +58,14 @@ public:
 	Gfx::PixmapTexture vidImg{};
 	IG::MemPixmap memPix{};
 	bool screenshotNextFrame = false;
+	ScreenshotWriter screenshotWriter{};
+	uint screenshotBurstFrames = 0;
+	int lastScreenshotNum = -1;
+	uint burstScreenshots = 0;
+	bool burstScreenshotError = false;
+	bool softwarePresent = false;
+	bool textureIsStale = false;
+	uint framesWritten = 0; // lets the benchmark check runFrame() skipped video when asked
 
 public:
 	EmuVideo(Gfx::Renderer &r): r{r} {}
@@ -66,10 +75,18 @@ public:
 	void writeFrame(Gfx::LockedTextureBuffer texBuff);
 	void writeFrame(IG::Pixmap pix);
 	void takeGameScreenshot();
+	void takeGameScreenshotBurst(double secs);
 	bool isExternalTexture();
 	Gfx::Renderer &renderer() { return r; }
 	IG::WP size() const;
+	// frames stay in memPix for a SoftwarePresenter, uploaded only when GL draws them
+	void setSoftwarePresent(bool on);
+	bool isSoftwarePresent() const { return softwarePresent; }
+	void updateTexture();
 
 protected:
+	void initMemPixmap();
+	void updateMemoryStats();
 	void doScreenshot(IG::Pixmap pix);
+	void onScreenshotWrite(int num, bool success);
 };
@@ -0,0 +1,47 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <imagine/base/baseDefs.hh>
+
+// Estimates the real vsync period from the timestamps of screen frame
+// callbacks. A screen's reported frame time is usually its nominal rate, so
+// a 59.94Hz display running a 60Hz frame time makes advanceFramesWithTime()
+// skip or double a frame every few seconds. The estimate is the least
+// squares slope of timestamp against vsync count over the last few seconds,
+// with intervals that don't fit a whole number of vsyncs rejected so
+// stalls and missed frames don't skew it.
+
+class FramePacing
+{
+public:
+	struct Stats
+	{
+		double frameTime = 0; // estimated seconds per vsync, 0 until stable
+		double jitter = 0; // standard deviation of vsync intervals in seconds
+		uint samples = 0;
+		uint outliers = 0;
+	};
+
+	// starts over if the screen's frame time differs from the last one given
+	static void setNominalFrameTime(double frameTime);
+	// returns true when the estimate moved enough that frame rates should be re-applied
+	static bool addTimestamp(Base::FrameTimeBase timestamp);
+	// the stable estimate, or the nominal frame time until there is one
+	static double frameTime();
+	static Stats stats();
+};
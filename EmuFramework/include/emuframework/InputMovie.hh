@@ -0,0 +1,45 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <emuframework/EmuSystem.hh>
+
+// Records the input actions sent to the emulated system, stamped with the
+// emulated frame they were applied before, and plays them back in place of
+// live input. A movie begins either at power-on (the game is hard reset)
+// or from a save state stored next to the movie file. All framework input
+// goes through sendInputAction() and startFrame() is called before each
+// EmuSystem::runFrame() so playback is frame exact.
+
+class InputMovie
+{
+public:
+	enum class Origin : uint8 { POWER_ON, STATE };
+
+	static EmuSystem::Error startRecording(const char *path, Origin origin);
+	static EmuSystem::Error startPlayback(const char *path);
+	static void stop();
+	static bool isRecording();
+	static bool isPlaying();
+	static bool isActive() { return isRecording() || isPlaying(); }
+	static void sendInputAction(uint state, uint emuKey);
+	static void clearInputBuffers();
+	static void startFrame();
+	static uint frame();
+	static uint frames();
+};
+
+FS::PathString inputMovieFilename();
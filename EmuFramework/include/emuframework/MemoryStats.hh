@@ -0,0 +1,77 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <string>
+
+// Tracks memory use per subsystem so games that won't fit on low memory
+// devices show up in testing instead of as OOM kills. Subsystems report the
+// size of their large buffers with set(), the process's resident size and
+// malloc heap come from the OS where it's supported. Loading a game often
+// briefly needs far more than running it, so the peak resident size is kept
+// separately for loading and for the steady state after it.
+
+class MemoryStats
+{
+public:
+	enum Category : uint8
+	{
+		VIDEO, // emulated video textures and their backing pixmaps
+		AUDIO, // output buffer
+		ROM, // game data as loaded by the core
+		SPRITE_CACHE, // decoded graphics caches
+		STATES, // save states kept in memory, e.g. for netplay rollback
+		CATEGORIES
+	};
+
+	struct Usage
+	{
+		size_t bytes = 0;
+		size_t peak = 0;
+	};
+
+	struct Report
+	{
+		Usage category[CATEGORIES]{};
+		size_t rss = 0; // 0 when unknown
+		size_t heap = 0; // malloc'd bytes in use, 0 when unknown
+		size_t loadHeap = 0; // heap growth from loading the game, mostly the core's allocations
+		size_t loadPeakRSS = 0;
+		size_t steadyPeakRSS = 0;
+		size_t budget = 0;
+
+		size_t peakRSS() const;
+		bool overBudget() const { return peakRSS() > budget; }
+	};
+
+	static void set(Category c, size_t bytes);
+	static Usage usage(Category c);
+	static const char *name(Category c);
+	static size_t rss();
+	static size_t heapInUse();
+	// called around EmuSystem::loadGame(), category peaks restart with each game
+	static void beginLoad();
+	static void endLoad();
+	// releases the categories owned by the game on close
+	static void closeGame();
+	// updates the steady state peak, call after the game has run for a while
+	static void sampleSteadyState();
+	static Report report();
+	static void setBudget(size_t bytes);
+	static size_t budget();
+	static std::string toJSON(const Report &report);
+};
@@ -45,6 +45,48 @@ public:
 	RecentGameView(ViewAttachParams attach);
 };
 
+class MemoryUsageView : public TableView
+{
+private:
+	std::vector<std::array<char, 40>> valueStr{};
+	std::vector<DualTextMenuItem> row{};
+
+public:
+	MemoryUsageView(ViewAttachParams attach);
+};
+
+class StartupTimeView : public TableView
+{
+private:
+	std::vector<std::array<char, 24>> valueStr{};
+	std::vector<DualTextMenuItem> row{};
+
+public:
+	StartupTimeView(ViewAttachParams attach);
+};
+
+class NetplayView : public TableView
+{
+public:
+	NetplayView(ViewAttachParams attach);
+	void onShow() override;
+
+private:
+	static constexpr uint STATS = 6;
+	DualTextMenuItem remoteHost;
+	DualTextMenuItem remotePort;
+	DualTextMenuItem localPort;
+	TextMenuItem connect;
+	TextMenuItem loopback;
+	TextMenuItem stop;
+	TextHeadingMenuItem statsHeading;
+	std::array<std::array<char, 24>, STATS> statStr{};
+	std::array<DualTextMenuItem, STATS> stat{};
+	StaticArrayList<MenuItem*, 7 + STATS> item{};
+
+	void updateStats();
+};
+
 class MenuView : public TableView
 {
 public:
@@ -53,12 +95,13 @@ public:
 	void loadFileBrowserItems();
 	void loadStandardItems();
 
-	static const uint STANDARD_ITEMS = 19;
+	static const uint STANDARD_ITEMS = 26;
 	static const uint MAX_SYSTEM_ITEMS = 5;
 
 protected:
 	TextMenuItem loadGame;
 	TextMenuItem cheats;
+	TextMenuItem ramSearch;
 	TextMenuItem reset;
 	TextMenuItem loadState;
 	TextMenuItem recentGames;
@@ -70,6 +113,8 @@ protected:
 	TextMenuItem onScreenInputManager;
 	TextMenuItem inputManager;
 	TextMenuItem benchmark;
+	TextMenuItem memoryUsage;
+	TextMenuItem startupTime;
 	#if defined CONFIG_BASE_ANDROID && !defined CONFIG_MACHINE_OUYA
 	TextMenuItem addLauncherIcon;
 	#endif
@@ -84,5 +129,9 @@ protected:
 	TextMenuItem about;
 	TextMenuItem exitApp;
 	TextMenuItem screenshot;
+	TextMenuItem recordGameplay;
+	TextMenuItem recordMovie;
+	TextMenuItem playMovie;
+	TextMenuItem netplay;
 	StaticArrayList<MenuItem*, STANDARD_ITEMS + MAX_SYSTEM_ITEMS> item{};
 };
@@ -46,6 +46,7 @@ public:
 	void post(const char *prefix, const std::system_error &err, int secs = 3);
 	void post(const char *prefix, std::error_code ec, int secs = 3);
 	void draw();
+	bool isVisible() const;
 
 	[[gnu::format(printf, 4, 5)]]
 	void printf(uint secs, bool error, const char *format, ...);
@@ -0,0 +1,76 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <emuframework/EmuSystem.hh>
+#include <memory>
+
+// Rollback netplay between two instances running the same game. Each side
+// runs ahead on its own input and predicts that the other side's held
+// actions haven't changed since the last frame received from it. When the
+// real input arrives and differs, the in-memory state saved before that
+// frame is restored and the frames since are re-simulated without video or
+// audio. Packets carry the held actions of every frame the other side
+// hasn't acknowledged yet, so a lost datagram only delays input. How far a
+// side may run ahead of the other's input is capped by the measured cost of
+// re-simulating a frame so a rollback fits in half a frame's time.
+
+class Netplay
+{
+public:
+	class Transport
+	{
+	public:
+		virtual ~Transport() {}
+		// datagrams may be dropped or reordered
+		virtual void send(const void *data, uint size) = 0;
+		// returns the size of the next waiting datagram, or 0 if none
+		virtual uint receive(void *data, uint maxSize) = 0;
+	};
+
+	struct Stats
+	{
+		uint rollbacks = 0;
+		uint resimulatedFrames = 0;
+		uint stalls = 0; // updates spent waiting for the other side
+		uint maxRollbackFrames = 0; // current cap on frames run ahead of remote input
+		double lastRollbackTime = 0; // seconds
+		double avgRollbackTime = 0;
+		double resimulateFrameTime = 0; // average seconds to restore and re-run one frame
+	};
+
+	// hard resets the game, both sides must start from the same game and options
+	static EmuSystem::Error start(std::unique_ptr<Transport> transport, uint inputDelay = 1);
+	static EmuSystem::Error startUdp(uint16 localPort, const char *remoteHost, uint16 remotePort, uint inputDelay = 1);
+	// plays against a stand-in that echoes local input back as its own after
+	// the given number of frames, for exercising rollback without a network
+	static EmuSystem::Error startLoopback(uint latencyFrames, uint lossPercent = 0);
+	// handles "--netplay <local port> <remote host> <remote port>" at the
+	// start of the arguments, returns how many were used
+	static uint parseArgs(int argc, char** argv);
+	// starts netplay requested on the command line once a game is loaded
+	static void startPending();
+	static void stop();
+	static bool isActive();
+	// receives remote input, rolling back if a prediction was wrong, and
+	// returns how many of the frames due may run before waiting on the other side
+	static uint update(uint frames);
+	static void sendInputAction(uint state, uint emuKey);
+	static void clearInputBuffers();
+	static void startFrame();
+	static Stats stats();
+};
@@ -246,6 +246,9 @@ using OptionTouchCtrlScaledCoordinates = Option<OptionMethodFunc<bool, vControll
 #ifdef CONFIG_AUDIO_OPENSL_ES
 using OptionAudioHintStrictUnderrunCheck = Option<OptionMethodFunc<bool, Audio::hintStrictUnderrunCheck, Audio::setHintStrictUnderrunCheck>, uint8>;
 #endif
+#ifdef CONFIG_AUDIO_PULL_MODE
+using OptionAudioHintPullMode = Option<OptionMethodFunc<bool, Audio::hintPullMode, Audio::setHintPullMode>, uint8>;
+#endif
 #ifdef CONFIG_BLUETOOTH_SCAN_CACHE_USAGE
 using OptionBlueToothScanCache = Option<OptionMethodFunc<bool, BluetoothAdapter::scanCacheUsage, BluetoothAdapter::setScanCacheUsage>, uint8>;
 #endif
@@ -290,7 +293,10 @@ enum { CFGKEY_SOUND = 0, CFGKEY_TOUCH_CONTROL_DISPLAY = 1,
 	CFGKEY_CHECK_SAVE_PATH_WRITE_ACCESS = 74, CFGKEY_IMAGE_EFFECT_PIXEL_FORMAT = 75,
 	CFGKEY_SKIP_LATE_FRAMES = 76, CFGKEY_FRAME_RATE = 77,
 	CFGKEY_FRAME_RATE_PAL = 78, CFGKEY_TIME_FRAMES_WITH_SCREEN_REFRESH = 79,
-	CFGKEY_FAKE_USER_ACTIVITY = 80, CFGKEY_SHOW_BLUETOOTH_SCAN = 81
+	CFGKEY_FAKE_USER_ACTIVITY = 80, CFGKEY_SHOW_BLUETOOTH_SCAN = 81,
+	CFGKEY_SCREENSHOT_COMPRESSION = 82, CFGKEY_SCREENSHOT_BURST_SECS = 83,
+	CFGKEY_STATE_HASH_INTERVAL = 84, CFGKEY_SOUND_PULL_MODE = 85,
+	CFGKEY_SOFTWARE_PRESENT = 86
 	// 256+ is reserved
 };
 
@@ -66,6 +66,10 @@ protected:
 	TextMenuItem windowPixelFormatItem[5];
 	MultiChoiceMenuItem windowPixelFormat;
 	#endif
+	#ifdef CONFIG_BASE_X11
+	TextMenuItem softwarePresentItem[3];
+	MultiChoiceMenuItem softwarePresent;
+	#endif
 	#if defined CONFIG_BASE_MULTI_WINDOW && defined CONFIG_BASE_X11
 	BoolMenuItem secondDisplay;
 	#endif
@@ -93,6 +97,9 @@ protected:
 	#ifdef CONFIG_AUDIO_OPENSL_ES
 	BoolMenuItem sndUnderrunCheck;
 	#endif
+	#ifdef CONFIG_AUDIO_PULL_MODE
+	BoolMenuItem sndPullMode;
+	#endif
 	#ifdef CONFIG_AUDIO_MANAGER_SOLO_MIX
 	BoolMenuItem audioSoloMix;
 	#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <imagine/pixmap/Pixmap.hh>
+
+// Batch regression runner started with --regress on the command line, see
+// EmuFramework/make/regress.mk. Each manifest line is tab separated:
+//
+//   rom path <TAB> frames [<TAB> input movie path]
+//
+// With a movie and 0 frames the movie's length is used. Games are loaded with
+// EmuSystem::loadGameFromPath() and run through EmuSystem::runFrame() into
+// the app's EmuVideo, so the timings cover the same path as normal play. A
+// CRC32C of the video frame is taken every checkpoint interval and on the
+// last frame, written to the results file, and compared to the baseline
+// (a results file from a known good build) when one is given. Games are
+// split across processes with --shard since most cores can only run one
+// game per process. On cores with EmuSystem::hasInstances, --threads N runs
+// games without a movie on N - 1 EmuSystem::Instance threads alongside the
+// app's machine, hashing each instance's own frame. With --json, a line with the timings and MemoryStats
+// report of each game is written so memory use can be compared with the
+// budget given by --memory-budget in MiB.
+
+class RegressionFarm
+{
+public:
+	struct Config
+	{
+		const char *manifestPath{};
+		const char *baselinePath{};
+		const char *resultsPath{};
+		const char *saveDir{};
+		const char *jsonPath{};
+		uint memoryBudgetMiB = 0;
+		uint checkpointInterval = 60;
+		uint threads = 1;
+		uint shard = 0;
+		uint shards = 1;
+	};
+
+	// returns the number of arguments used, 0 if argv doesn't start with --regress
+	static uint parseArgs(int argc, char **argv, Config &config);
+	// returns the number of games that failed to load or didn't match the baseline
+	static uint run(Config config);
+	static bool isHashingFrame();
+	static void hashFrame(IG::Pixmap pix);
+};
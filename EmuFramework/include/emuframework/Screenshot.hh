@@ -17,6 +17,54 @@
 
 #include <imagine/pixmap/Pixmap.hh>
 #include <imagine/fs/FS.hh>
+#include <imagine/base/Pipe.hh>
+#include <imagine/thread/Semaphore.hh>
+#include <imagine/util/DelegateFunc.hh>
+#include <array>
+#include <atomic>
 
-bool writeScreenshot(const IG::Pixmap &vidPix, const char *fname);
-int sprintScreenshotFilename(FS::PathString &str);
+// compressionLevel is 0-9 or -1 for the encoder's default
+bool writeScreenshot(const IG::Pixmap &vidPix, const char *fname, int compressionLevel = -1);
+int sprintScreenshotFilename(FS::PathString &str, int startNum = 0);
+
+// Encodes screenshots on a worker thread so image compression doesn't
+// stall frame rendering. Frames are copied into a small pool of buffers
+// and the result of each write is reported back on the main thread.
+class ScreenshotWriter
+{
+public:
+	static constexpr uint MAX_QUEUED = 8;
+	using OnWriteDelegate = DelegateFunc<void (int num, bool success)>;
+
+	ScreenshotWriter() {}
+	void setOnWrite(OnWriteDelegate del);
+	// copies pix and queues it for writing, returns false if all buffers are in use
+	bool write(IG::Pixmap pix, const FS::PathString &path, int num, int compressionLevel = -1);
+	bool hasPendingWrites() const;
+
+private:
+	struct Job
+	{
+		IG::MemPixmap pix{};
+		FS::PathString path{};
+		int num = 0;
+		int compressionLevel = -1;
+		std::atomic_bool inUse{};
+	};
+	struct Result
+	{
+		int num;
+		bool success;
+	};
+
+	std::array<Job, MAX_QUEUED> job{};
+	std::array<uint8, MAX_QUEUED> queue{}; // job indexes in submission order
+	uint queueWritePos = 0;
+	IG::Semaphore queueSem{0};
+	Base::Pipe resultPipe{};
+	OnWriteDelegate onWrite{};
+	bool workerRunning = false;
+
+	void startWorker();
+	Job *freeJob();
+};
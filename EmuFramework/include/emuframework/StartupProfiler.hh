@@ -0,0 +1,53 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <imagine/time/Time.hh>
+#include <string>
+
+// Times the phases of a cold start up to the first emulated frame when a
+// game is given on the command line, or up to the main menu otherwise. Each
+// mark() ends the phase it names, phases that never run (e.g. the game
+// load when there's no game to launch) are reported as skipped.
+
+class StartupProfiler
+{
+public:
+	enum Phase : uint8
+	{
+		OPTIONS, // option defaults, command line and config file
+		RENDERER, // renderer creation and UI shader programs
+		FONTS,
+		WINDOW, // main window, popup, on-screen controls and the main menu if shown
+		GAME_LOAD, // loading the command line game up to starting emulation
+		FIRST_FRAME, // the first emulated frame drawn
+		PHASES
+	};
+
+	// called first thing in app init
+	static void start();
+	static void mark(Phase p);
+	// logs the summary once, later calls do nothing
+	static void finish();
+	static bool isFinished();
+	// 0 if the phase didn't run
+	static IG::Time phaseTime(Phase p);
+	static bool phaseRan(Phase p);
+	static IG::Time total();
+	static const char *name(Phase p);
+	static std::string toJSON();
+};
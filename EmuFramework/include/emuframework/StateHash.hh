@@ -0,0 +1,44 @@
+#pragma once
+
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <cstddef>
+
+// Determinism checker for input movies. While a movie records, the emulated
+// state is hashed every few frames into a hash track saved beside the movie.
+// Playback compares against the track and reports the first frame where the
+// state diverges. Cores register their RAM with addRegion() so hashing is a
+// CRC over memory; otherwise EmuSystem::saveStateToMemory() output is
+// hashed, which is slower but covers the whole system.
+
+class StateHash
+{
+public:
+	static void addRegion(const void *data, size_t size);
+	static void clearRegions();
+	static uint32 hashState();
+
+	static void startRecording(uint interval);
+	static bool startChecking(const char *trackPath);
+	static void onFrame(uint frame);
+	static bool writeTrack(const char *trackPath);
+	static void stop();
+	static bool isChecking();
+	// -1 if no divergence was found
+	static int firstDivergentFrame();
+	static uint hashesChecked();
+};
@@ -107,6 +107,7 @@ public:
 	std::array<int, 2> getCenterBtnInput(IG::WP pos) const;
 	std::array<int, 2> getBtnInput(IG::WP pos) const;
 	void draw(Gfx::Renderer &r, bool showHidden) const;
+	bool hasVisibleElements() const;
 
 private:
 	IG::WindowRect centerBtnBound[MAX_CENTER_BTNS]{};
@@ -173,6 +174,8 @@ public:
 	void applyInput(Input::Event e);
 	void draw(bool emuSystemControls, bool activeFF, bool showHidden = false);
 	void draw(bool emuSystemControls, bool activeFF, bool showHidden, float alpha);
+	// true if draw() would put anything on screen
+	bool hasVisibleElements(bool emuSystemControls) const;
 	int numElements() const;
 	IG::WindowRect bounds(int elemIdx) const;
 	void setPos(int elemIdx, IG::Point2D<int> pos);
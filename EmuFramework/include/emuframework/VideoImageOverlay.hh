@@ -23,6 +23,8 @@ class VideoImageOverlay
 	Gfx::Sprite spr{};
 	uint effect = NO_EFFECT;
 
+	void initTexture(Gfx::Renderer &r);
+
 public:
 	Gfx::GC intensity = 0.25;
 
@@ -37,7 +39,7 @@ public:
 	};
 
 	constexpr	VideoImageOverlay() {}
-	void setEffect(Gfx::Renderer &r, uint effect);
-	void place(const Gfx::Sprite &disp, uint lines);
+	void setEffect(uint effect);
+	void place(Gfx::Renderer &r, const Gfx::Sprite &disp, uint lines);
 	void draw(Gfx::Renderer &r);
 };
@@ -0,0 +1,47 @@
+# Runs the app over a ROM manifest to check frame hashes & timings against
+# a baseline, see include/emuframework/RegressionFarm.hh for the manifest format.
+# Included after a system's build.mk, e.g. from linux-x86_64-regress.mk:
+#
+#  make -f linux-x86_64-regress.mk regress-baseline  # record a known good build
+#  make -f linux-x86_64-regress.mk regress           # compare against it
+#
+# Games are split over REGRESS_JOBS processes running in parallel. Timings and
+# memory use of each game are also written as JSON lines to
+# $(targetDir)/regress/benchmark.jsonl, peak resident sizes over
+# REGRESS_MEMORY_BUDGET MiB are flagged. On cores with EmuSystem instances,
+# REGRESS_THREADS > 1 also runs games without a movie on threads in each process.
+
+REGRESS_MANIFEST ?= regress/manifest.txt
+REGRESS_BASELINE ?= $(basename $(REGRESS_MANIFEST)).baseline
+REGRESS_CHECKPOINT ?= 60
+REGRESS_JOBS ?= $(shell nproc 2>/dev/null || echo 1)
+REGRESS_MEMORY_BUDGET ?= 192
+REGRESS_THREADS ?= 1
+regressDir := $(targetDir)/regress
+regressExec := $(targetDir)/$(targetFile)
+
+# $1 = baseline path or empty, $2 = output path
+define runRegressShards
+	@mkdir -p $(regressDir)
+	@rm -rf $(regressDir)/saves-* $(regressDir)/results-* $(regressDir)/benchmark-*
+	@fail=0; pids=; \
+	for i in `seq 0 $$(($(REGRESS_JOBS) - 1))`; do \
+		$(regressExec) --regress $(REGRESS_MANIFEST) --baseline "$1" --checkpoint $(REGRESS_CHECKPOINT) \
+		--shard $$i/$(REGRESS_JOBS) --save-dir $(regressDir)/saves-$$i --results $(regressDir)/results-$$i.txt \
+		--json $(regressDir)/benchmark-$$i.jsonl --memory-budget $(REGRESS_MEMORY_BUDGET) --threads $(REGRESS_THREADS) & \
+		pids="$$pids $$!"; \
+	done; \
+	for pid in $$pids; do wait $$pid || fail=1; done; \
+	cat $(regressDir)/results-*.txt > $2; \
+	cat $(regressDir)/benchmark-*.jsonl > $(regressDir)/benchmark.jsonl; \
+	grep "^#" $2; \
+	exit $$fail
+endef
+
+.PHONY: regress regress-baseline
+
+regress : main
+	$(call runRegressShards,$(REGRESS_BASELINE),$(regressDir)/results.txt)
+
+regress-baseline : main
+	$(call runRegressShards,,$(REGRESS_BASELINE))
@@ -0,0 +1,341 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "AVRecorder"
+#include <emuframework/AVRecorder.hh>
+#include <emuframework/EmuSystem.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/thread/Thread.hh>
+#include <imagine/thread/Semaphore.hh>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/string.h>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#if defined __linux__
+#include <imagine/util/ringbuffer/LinuxRingBuffer.hh>
+using RingBufferType = StaticLinuxRingBuffer<>;
+#elif defined __APPLE__
+#include <imagine/util/ringbuffer/MachRingBuffer.hh>
+using RingBufferType = StaticMachRingBuffer<>;
+#else
+#include <imagine/util/ringbuffer/RingBuffer.hh>
+using RingBufferType = StaticRingBuffer<>;
+#endif
+
+enum PacketType : uint8 { PACKET_VIDEO, PACKET_AUDIO, PACKET_END };
+
+struct PacketHeader
+{
+	uint32 size;
+	uint32 silenceFrames; // audio frames dropped before this packet, written as silence
+	uint16 repeat;
+	PacketType type;
+};
+
+struct WavHeader
+{
+	char riff[4]{'R', 'I', 'F', 'F'};
+	uint32 riffSize = 36;
+	char wave[4]{'W', 'A', 'V', 'E'};
+	char fmt[4]{'f', 'm', 't', ' '};
+	uint32 fmtSize = 16;
+	uint16 format = 1; // PCM
+	uint16 channels = 0;
+	uint32 rate = 0;
+	uint32 byteRate = 0;
+	uint16 blockAlign = 0;
+	uint16 bitsPerSample = 0;
+	char data[4]{'d', 'a', 't', 'a'};
+	uint32 dataSize = 0;
+};
+static_assert(sizeof(WavHeader) == 44, "WAV header must be packed");
+
+// enough for several frames of the largest video formats
+static constexpr uint MIN_RING_BUFFER_SIZE = 16 * 1024 * 1024;
+// limit on repeated frames after a stall so a long pause doesn't write minutes of video
+static constexpr uint MAX_REPEAT_FRAMES = 60;
+static RingBufferType ringBuff{};
+static IG::Semaphore packetSem{0};
+static IG::Semaphore finishedSem{0};
+static IG::Semaphore spaceSem{0};
+static std::atomic_bool waitingForSpace{};
+static std::atomic_bool recording{};
+static IG::PixmapDesc videoDesc{};
+static Audio::PcmFormat pcmFormat{};
+static double videoFramesPerAudioFrame = 0;
+static uint64_t videoFrames = 0, audioFrames = 0;
+static std::atomic_uint dropped{};
+static uint32 pendingSilenceFrames = 0;
+static FileIO videoFile{}, audioFile{};
+
+static const char *ffmpegPixelFormatName(IG::PixelFormat format)
+{
+	switch(format.id())
+	{
+		case IG::PIXEL_RGB565: return "rgb565le";
+		case IG::PIXEL_RGBA8888: return "rgba";
+		case IG::PIXEL_BGRA8888: return "bgra";
+		default: return format.name();
+	}
+}
+
+static bool pushPacket(PacketType type, uint repeat, uint size, const void *data, uint rows = 1, uint pitch = 0)
+{
+	PacketHeader header{size, type == PACKET_AUDIO ? pendingSilenceFrames : 0, (uint16)repeat, type};
+	if(ringBuff.freeSpace() < sizeof(header) + size)
+	{
+		dropped++;
+		return false;
+	}
+	if(type == PACKET_AUDIO)
+		pendingSilenceFrames = 0;
+	ringBuff.write(&header, sizeof(header));
+	if(rows == 1)
+	{
+		ringBuff.write(data, size);
+	}
+	else
+	{
+		auto rowBytes = size / rows;
+		auto src = (const char*)data;
+		iterateTimes(rows, i)
+		{
+			ringBuff.write(src, rowBytes);
+			src += pitch;
+		}
+	}
+	packetSem.notify();
+	return true;
+}
+
+static void writeWavSizes(uint32 dataSize)
+{
+	WavHeader header;
+	header.channels = pcmFormat.channels;
+	header.rate = pcmFormat.rate;
+	header.bitsPerSample = pcmFormat.sample.toBits();
+	header.blockAlign = pcmFormat.framesToBytes(1);
+	header.byteRate = pcmFormat.rate * header.blockAlign;
+	header.dataSize = dataSize;
+	header.riffSize = 36 + dataSize;
+	audioFile.seekS(0);
+	audioFile.write(&header, sizeof(header));
+}
+
+static void writeSilence(uint32 frames, uint32 &audioBytes, std::error_code &ec)
+{
+	char silence[4096];
+	// WAV 8-bit samples are unsigned
+	memset(silence, pcmFormat.sample.toBits() == 8 ? 0x80 : 0, sizeof(silence));
+	auto bytes = pcmFormat.framesToBytes(frames);
+	while(bytes && !ec)
+	{
+		auto size = std::min(bytes, (uint)sizeof(silence));
+		audioFile.write(silence, size, &ec);
+		audioBytes += size;
+		bytes -= size;
+	}
+}
+
+static void runEncoder()
+{
+	std::vector<char> data;
+	uint32 audioBytes = 0;
+	bool writeError = false;
+	while(1)
+	{
+		packetSem.wait();
+		PacketHeader header;
+		ringBuff.read(&header, sizeof(header));
+		if(header.silenceFrames && !writeError)
+		{
+			// keep the audio in sync with the video for packets dropped while the buffer was full
+			std::error_code ec{};
+			writeSilence(header.silenceFrames, audioBytes, ec);
+			if(ec)
+			{
+				logErr("error writing recording: %s", ec.message().c_str());
+				writeError = true;
+			}
+		}
+		if(header.type == PACKET_END)
+			break;
+		data.resize(header.size);
+		ringBuff.read(data.data(), header.size);
+		if(waitingForSpace.exchange(false))
+			spaceSem.notify();
+		if(writeError)
+			continue;
+		std::error_code ec{};
+		if(header.type == PACKET_VIDEO)
+		{
+			iterateTimes(header.repeat, i)
+			{
+				videoFile.write(data.data(), data.size(), &ec);
+			}
+		}
+		else
+		{
+			if(pcmFormat.sample.toBits() == 8)
+			{
+				// WAV 8-bit samples are unsigned
+				for(auto &s : data)
+					s ^= 0x80;
+			}
+			audioFile.write(data.data(), data.size(), &ec);
+			audioBytes += data.size();
+		}
+		if(ec)
+		{
+			logErr("error writing recording: %s", ec.message().c_str());
+			writeError = true;
+		}
+	}
+	writeWavSizes(audioBytes);
+	videoFile.close();
+	audioFile.close();
+	logMsg("recording finished with %u bytes of audio, %u dropped packets", audioBytes, dropped.load());
+	finishedSem.notify();
+}
+
+std::error_code AVRecorder::start(const char *basePath, IG::PixmapDesc desc, double frameTime, Audio::PcmFormat format)
+{
+	if(recording)
+		stop();
+	auto videoPath = FS::makePathStringPrintf("%s.rgb", basePath);
+	auto audioPath = FS::makePathStringPrintf("%s.wav", basePath);
+	if(auto ec = videoFile.create(videoPath);
+		ec)
+	{
+		logErr("error creating %s", videoPath.data());
+		return ec;
+	}
+	if(auto ec = audioFile.create(audioPath);
+		ec)
+	{
+		logErr("error creating %s", audioPath.data());
+		videoFile.close();
+		FS::remove(videoPath);
+		return ec;
+	}
+	videoDesc = desc;
+	pcmFormat = format;
+	writeWavSizes(0);
+	if(!ringBuff.init(std::max(MIN_RING_BUFFER_SIZE, (uint)desc.pixelBytes() * 8)))
+	{
+		videoFile.close();
+		audioFile.close();
+		FS::remove(videoPath);
+		FS::remove(audioPath);
+		return {ENOMEM, std::system_category()};
+	}
+	videoFramesPerAudioFrame = 1. / (format.rate * frameTime);
+	videoFrames = audioFrames = 0;
+	dropped = 0;
+	pendingSilenceFrames = 0;
+	IG::makeDetachedThread(runEncoder);
+	recording = true;
+	logMsg("started recording %dx%d %s video at %f fps, %d Hz audio to %s",
+		desc.w(), desc.h(), desc.format().name(), 1. / frameTime, format.rate, basePath);
+	logMsg("mux with: ffmpeg -f rawvideo -pixel_format %s -video_size %dx%d -framerate %f -i \"%s\" -i \"%s\" -c:v ffv1 out.mkv",
+		ffmpegPixelFormatName(desc.format()), desc.w(), desc.h(), 1. / frameTime, videoPath.data(), audioPath.data());
+	return {};
+}
+
+void AVRecorder::stop()
+{
+	if(!recording)
+		return;
+	recording = false;
+	PacketHeader header{0, pendingSilenceFrames, 0, PACKET_END};
+	// the encoder is draining the buffer, wait for it to make room for the end marker
+	while(ringBuff.freeSpace() < sizeof(header))
+	{
+		waitingForSpace = true;
+		// re-check in case the encoder read a packet before seeing the flag
+		if(ringBuff.freeSpace() >= sizeof(header))
+			break;
+		spaceSem.wait();
+	}
+	waitingForSpace = false;
+	ringBuff.write(&header, sizeof(header));
+	packetSem.notify();
+	finishedSem.wait();
+	ringBuff.deinit();
+}
+
+bool AVRecorder::isRecording()
+{
+	return recording;
+}
+
+void AVRecorder::writeVideo(IG::Pixmap pix)
+{
+	if(!recording)
+		return;
+	if((IG::PixmapDesc)pix != videoDesc)
+	{
+		logWarn("video format changed, stopping recording");
+		stop();
+		return;
+	}
+	// repeat the frame if the audio indicates emulated frames were skipped
+	uint64_t framesForAudio = std::llround(audioFrames * videoFramesPerAudioFrame);
+	uint repeat = 1;
+	if(framesForAudio > videoFrames + 1)
+		repeat = std::min(framesForAudio - videoFrames, (uint64_t)MAX_REPEAT_FRAMES);
+	uint rowBytes = pix.format().pixelBytes(pix.w());
+	bool packed = pix.pitchBytes() == rowBytes;
+	if(pushPacket(PACKET_VIDEO, repeat, rowBytes * pix.h(), pix.pixel({}),
+		packed ? 1 : pix.h(), pix.pitchBytes()))
+	{
+		videoFrames += repeat;
+	}
+}
+
+void AVRecorder::writeAudio(const void *samples, uint frames)
+{
+	if(!recording)
+		return;
+	if(!pushPacket(PACKET_AUDIO, 1, pcmFormat.framesToBytes(frames), samples))
+	{
+		// written as silence before the next audio packet
+		pendingSilenceFrames += frames;
+	}
+	audioFrames += frames;
+}
+
+uint AVRecorder::droppedPackets()
+{
+	return dropped;
+}
+
+int sprintRecordingBasePath(FS::PathString &str)
+{
+	const int maxNum = 999;
+	iterateTimes(maxNum, i)
+	{
+		string_printf(str, "%s/%s.%.3d", EmuSystem::savePath(), EmuSystem::gameName().data(), i);
+		if(!FS::exists(FS::makePathStringPrintf("%s.rgb", str.data())))
+		{
+			return i;
+		}
+	}
+	logMsg("no recording filenames left");
+	return -1;
+}
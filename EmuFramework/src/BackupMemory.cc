@@ -0,0 +1,239 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "BackupMem"
+#include <emuframework/BackupMemory.hh>
+#include <emuframework/FileUtils.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/thread/Thread.hh>
+#include <imagine/thread/Semaphore.hh>
+#include <imagine/util/hash.hh>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/string.h>
+#include <atomic>
+#include <memory>
+
+struct WatchedRegion
+{
+	const uint8 *data{};
+	uint size{};
+	std::vector<uint32> pageHash{};
+
+	WatchedRegion() {}
+	WatchedRegion(const void *data, uint size):
+		data{(const uint8*)data}, size{size}, pageHash((size + BackupMemory::PAGE_SIZE - 1) / BackupMemory::PAGE_SIZE)
+	{
+		iterateTimes(pages(), i)
+		{
+			pageHash[i] = hashPage(i);
+		}
+	}
+
+	uint pages() const
+	{
+		return pageHash.size();
+	}
+
+	uint32 hashPage(uint page) const
+	{
+		uint offset = page * BackupMemory::PAGE_SIZE;
+		return IG::hashBytes(data + offset, std::min(BackupMemory::PAGE_SIZE, size - offset));
+	}
+};
+
+// pages hashed per update, spreads the cost of a full pass over several frames
+static constexpr uint PAGES_PER_UPDATE = 16;
+static std::vector<WatchedRegion> region{};
+static uint totalPages = 0;
+static uint scanRegion = 0, scanPage = 0;
+static BackupMemory::OnSnapshotDelegate onSnapshot{};
+static bool dirty = false;
+static std::atomic_bool dirtyMarked{};
+static Base::FrameTimeBase lastChangeTime{};
+static Base::FrameTimeBase quietTime = Base::frameTimeBaseFromSecs(2);
+static std::atomic_bool writeInProgress{};
+static IG::Semaphore writeSem{1};
+
+void BackupMemory::Snapshot::write(const char *path, const void *data, uint size, bool byteSwap16)
+{
+	auto file = std::find_if(files.begin(), files.end(),
+		[path](const File &f){ return string_equal(f.path.data(), path); });
+	if(file == files.end())
+	{
+		files.emplace_back();
+		file = files.end() - 1;
+		string_copy(file->path, path);
+	}
+	auto &buff = file->data;
+	auto startIdx = buff.size();
+	buff.insert(buff.end(), (const uint8*)data, (const uint8*)data + size);
+	if(byteSwap16)
+	{
+		for(auto i = startIdx; i + 1 < buff.size(); i += 2)
+		{
+			std::swap(buff[i], buff[i+1]);
+		}
+	}
+}
+
+bool BackupMemory::Snapshot::writeFiles()
+{
+	bool success = true;
+	for(auto &f : files)
+	{
+		// write to a temporary file first so a failed write never truncates the last good save
+		auto tempPath = FS::makePathStringPrintf("%s.tmp", f.path.data());
+		fixFilePermissions(f.path);
+		if(auto ec = writeToNewFile(tempPath.data(), f.data.data(), f.data.size());
+			ec)
+		{
+			logErr("error writing %s: %s", tempPath.data(), ec.message().c_str());
+			FS::remove(tempPath);
+			success = false;
+			continue;
+		}
+		std::error_code ec{};
+		FS::rename(tempPath.data(), f.path.data(), ec);
+		if(ec)
+		{
+			logErr("error renaming %s: %s", tempPath.data(), ec.message().c_str());
+			success = false;
+			continue;
+		}
+		logMsg("wrote %u bytes to %s", (uint)f.data.size(), f.path.data());
+	}
+	return success;
+}
+
+void BackupMemory::watch(const void *data, uint size)
+{
+	assert(data && size);
+	region.emplace_back(data, size);
+	totalPages += region.back().pages();
+	logMsg("watching %u bytes at %p", size, data);
+}
+
+void BackupMemory::setOnSnapshot(OnSnapshotDelegate del)
+{
+	onSnapshot = del;
+}
+
+void BackupMemory::markDirty()
+{
+	dirtyMarked = true;
+}
+
+void BackupMemory::update(Base::FrameTimeBase time)
+{
+	if(!onSnapshot)
+		return;
+	if(dirtyMarked.exchange(false))
+	{
+		dirty = true;
+		lastChangeTime = time;
+	}
+	if(totalPages)
+	{
+		iterateTimes(std::min(PAGES_PER_UPDATE, totalPages), i)
+		{
+			auto &r = region[scanRegion];
+			auto hash = r.hashPage(scanPage);
+			if(hash != r.pageHash[scanPage])
+			{
+				r.pageHash[scanPage] = hash;
+				dirty = true;
+				lastChangeTime = time;
+			}
+			if(++scanPage == r.pages())
+			{
+				scanPage = 0;
+				scanRegion = (scanRegion + 1) % region.size();
+			}
+		}
+	}
+	if(dirty && time - lastChangeTime >= quietTime)
+	{
+		flush();
+	}
+}
+
+bool BackupMemory::flush(bool wait)
+{
+	if(dirtyMarked.exchange(false))
+		dirty = true;
+	if(!dirty || !onSnapshot)
+	{
+		if(wait)
+			finishWrites();
+		return false;
+	}
+	if(writeInProgress && !wait)
+	{
+		// previous write still running, try again on a later update
+		return false;
+	}
+	auto snapshot = std::make_unique<Snapshot>();
+	onSnapshot(*snapshot);
+	dirty = false;
+	if(!*snapshot)
+		return true;
+	writeSem.wait();
+	writeInProgress = true;
+	auto snapshotPtr = snapshot.release();
+	IG::makeDetachedThread(
+		[snapshotPtr]()
+		{
+			std::unique_ptr<Snapshot> snapshot{snapshotPtr};
+			snapshot->writeFiles();
+			writeInProgress = false;
+			writeSem.notify();
+		});
+	if(wait)
+		finishWrites();
+	return true;
+}
+
+void BackupMemory::finishWrites()
+{
+	writeSem.wait();
+	writeSem.notify();
+}
+
+void BackupMemory::reset()
+{
+	finishWrites();
+	region.clear();
+	totalPages = 0;
+	scanRegion = scanPage = 0;
+	onSnapshot = {};
+	dirty = false;
+	dirtyMarked = false;
+}
+
+bool BackupMemory::isDirty()
+{
+	return dirty || dirtyMarked;
+}
+
+bool BackupMemory::isActive()
+{
+	return (bool)onSnapshot;
+}
+
+void BackupMemory::setQuietTime(Base::FrameTimeBase time)
+{
+	quietTime = time;
+}
@@ -0,0 +1,261 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "BootSnapshot"
+#include <emuframework/BootSnapshot.hh>
+#include <emuframework/EmuSystem.hh>
+#include <emuframework/FileUtils.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/hash.hh>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+struct SnapshotHeader
+{
+	static constexpr char MAGIC[8]{'E', 'M', 'U', 'B', 'O', 'O', 'T', 'S'};
+	static constexpr uint16 VERSION = 3; // 2: uncompressed MD states, 3: keyed by content hash
+
+	char magic[8]{};
+	uint16 version = VERSION;
+	uint16 padding{};
+	uint32 key = 0;
+	uint32 size = 0;
+};
+
+struct CacheEntry
+{
+	FS::PathString gamePath{};
+	uint32 key = 0;
+	EmuSystem::MemoryState state{};
+};
+
+static constexpr uint MAX_CACHED = 4;
+static std::vector<CacheEntry> cache{}; // most recently used first
+static bool capturing = false;
+static uint framesLeft = 0;
+static uint32 captureKey = 0;
+static uint32 contentKey = 0;
+
+constexpr char SnapshotHeader::MAGIC[8];
+
+static FS::PathString snapshotFilename()
+{
+	return FS::makePathStringPrintf("%s/%s.boot", EmuSystem::savePath(), EmuSystem::gameName().data());
+}
+
+static uint32 configKey(uint frames)
+{
+	if(!contentKey)
+	{
+		// cores loading from a path never pass an IO to hash during the load
+		FileIO file;
+		file.open(EmuSystem::fullGamePath());
+		if(file)
+			contentKey = BootSnapshot::hashContent(file);
+	}
+	auto systemName = EmuSystem::systemName();
+	auto config = EmuSystem::bootSnapshotConfig();
+	uint32 key = IG::crc32c(systemName, strlen(systemName));
+	key = IG::crc32c(config.data(), strlen(config.data()), key);
+	key = IG::crc32c(&frames, sizeof(frames), key);
+	return IG::crc32c(&contentKey, sizeof(contentKey), key);
+}
+
+static CacheEntry *findCached(uint32 key)
+{
+	for(auto it = cache.begin(); it != cache.end(); ++it)
+	{
+		if(it->key == key && string_equal(it->gamePath.data(), EmuSystem::fullGamePath()))
+		{
+			std::rotate(cache.begin(), it, it + 1);
+			return &cache.front();
+		}
+	}
+	return nullptr;
+}
+
+static CacheEntry &addCached(uint32 key, EmuSystem::MemoryState state)
+{
+	if(cache.size() == MAX_CACHED)
+		cache.pop_back();
+	CacheEntry entry;
+	string_copy(entry.gamePath, EmuSystem::fullGamePath());
+	entry.key = key;
+	entry.state = std::move(state);
+	cache.insert(cache.begin(), std::move(entry));
+	return cache.front();
+}
+
+static CacheEntry *readSnapshotFile(uint32 key)
+{
+	auto path = snapshotFilename();
+	FileIO file;
+	file.open(path);
+	if(!file)
+		return nullptr;
+	SnapshotHeader header;
+	if(file.read(&header, sizeof(header)) != sizeof(header)
+		|| memcmp(header.magic, SnapshotHeader::MAGIC, sizeof(header.magic)) != 0
+		|| header.version != SnapshotHeader::VERSION)
+	{
+		logWarn("ignoring invalid snapshot:%s", path.data());
+		return nullptr;
+	}
+	if(header.key != key)
+	{
+		logMsg("snapshot:%s is from a different configuration", path.data());
+		return nullptr;
+	}
+	EmuSystem::MemoryState state(header.size);
+	if(file.read(state.data(), state.size()) != (ssize_t)state.size())
+	{
+		logWarn("snapshot:%s is truncated", path.data());
+		return nullptr;
+	}
+	return &addCached(key, std::move(state));
+}
+
+static void writeSnapshotFile(uint32 key, const EmuSystem::MemoryState &state)
+{
+	auto path = snapshotFilename();
+	fixFilePermissions(path);
+	FileIO file;
+	file.create(path);
+	if(!file)
+	{
+		logErr("error creating snapshot:%s", path.data());
+		return;
+	}
+	SnapshotHeader header;
+	memcpy(header.magic, SnapshotHeader::MAGIC, sizeof(header.magic));
+	header.key = key;
+	header.size = state.size();
+	file.write(&header, sizeof(header));
+	file.write(state.data(), state.size());
+}
+
+uint32 BootSnapshot::hashContent(IO &io, uint32 crc)
+{
+	static constexpr size_t FULL_HASH_LIMIT = 64 * 1024 * 1024;
+	static constexpr size_t SAMPLE_SIZE = 1024 * 1024;
+	uint64 size = io.size();
+	crc = IG::crc32c(&size, sizeof(size), crc);
+	auto data = io.mmapConst();
+	std::vector<char> buff;
+	auto hashRange =
+		[&](size_t offset, size_t bytes)
+		{
+			if(data)
+			{
+				crc = IG::crc32c(data + offset, bytes, crc);
+				return;
+			}
+			buff.resize(std::min(bytes, SAMPLE_SIZE));
+			while(bytes)
+			{
+				auto chunk = std::min(bytes, buff.size());
+				if(io.readAtPos(buff.data(), chunk, offset) != (ssize_t)chunk)
+					return;
+				crc = IG::crc32c(buff.data(), chunk, crc);
+				offset += chunk;
+				bytes -= chunk;
+			}
+		};
+	if(size <= FULL_HASH_LIMIT)
+	{
+		hashRange(0, size);
+	}
+	else
+	{
+		// large disc images are sampled at the start, middle, and end
+		hashRange(0, SAMPLE_SIZE);
+		hashRange(size / 2, SAMPLE_SIZE);
+		hashRange(size - SAMPLE_SIZE, SAMPLE_SIZE);
+	}
+	return crc;
+}
+
+void BootSnapshot::setContentKey(uint32 key)
+{
+	contentKey = key;
+}
+
+bool BootSnapshot::onPowerOn()
+{
+	capturing = false;
+	uint frames = EmuSystem::bootSnapshotFrames();
+	if(!frames)
+		return false;
+	auto key = configKey(frames);
+	auto entry = findCached(key);
+	if(!entry)
+		entry = readSnapshotFile(key);
+	if(entry)
+	{
+		if(auto err = EmuSystem::loadStateFromMemory(entry->state.data(), entry->state.size());
+			!err)
+		{
+			logMsg("restored snapshot, skipped %u boot frames", frames);
+			return true;
+		}
+		else
+		{
+			logErr("error restoring snapshot: %s", err->what());
+			cache.erase(cache.begin());
+			// the system may be left in any state, start the boot over
+			EmuSystem::reset(EmuSystem::RESET_HARD);
+		}
+	}
+	logMsg("capturing snapshot after %u boot frames", frames);
+	framesLeft = frames;
+	captureKey = key;
+	capturing = true;
+	return false;
+}
+
+void BootSnapshot::onFrame()
+{
+	if(framesLeft)
+	{
+		framesLeft--;
+		return;
+	}
+	capturing = false;
+	EmuSystem::MemoryState state;
+	if(auto err = EmuSystem::saveStateToMemory(state);
+		err)
+	{
+		logErr("error capturing snapshot: %s", err->what());
+		return;
+	}
+	writeSnapshotFile(captureKey, state);
+	addCached(captureKey, std::move(state));
+	logMsg("captured snapshot");
+}
+
+void BootSnapshot::cancel()
+{
+	if(!capturing)
+		return;
+	logMsg("boot was interrupted, not capturing snapshot");
+	capturing = false;
+}
+
+bool BootSnapshot::isCapturing()
+{
+	return capturing;
+}
@@ -0,0 +1,145 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "CheatPatch"
+#include <emuframework/CheatPatchTable.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/utility.h>
+#include <algorithm>
+#include <cstring>
+
+void CheatPatchTable::setRegion(uint region_, uint8 *mem, uint32 size)
+{
+	assert(region_ < MAX_REGIONS);
+	region[region_] = {mem, size};
+}
+
+void CheatPatchTable::clear()
+{
+	code.clear();
+	codeData.clear();
+	run.clear();
+	condRun.clear();
+	data.clear();
+}
+
+bool CheatPatchTable::fitsRegion(uint region_, uint32 offset, uint size) const
+{
+	return region_ < MAX_REGIONS && region[region_].mem
+		&& offset < region[region_].size && size <= region[region_].size - offset;
+}
+
+bool CheatPatchTable::addWrite(uint region, uint32 offset, const void *data, uint size)
+{
+	return addConditionalWrite(region, offset, data, size, 0, nullptr, 0);
+}
+
+bool CheatPatchTable::addConditionalWrite(uint region, uint32 offset, const void *data, uint size,
+	uint32 compareOffset, const void *compare, uint compareSize, bool notEqual)
+{
+	if(!size || size > 0xFF || compareSize > 0xFF || !fitsRegion(region, offset, size)
+		|| (compareSize && !fitsRegion(region, compareOffset, compareSize)))
+	{
+		logErr("patch of %u bytes at 0x%X doesn't fit region %u", size, offset, region);
+		return false;
+	}
+	Code c;
+	c.region = region;
+	c.size = size;
+	c.compareSize = compareSize;
+	c.notEqual = notEqual;
+	c.offset = offset;
+	c.compareOffset = compareOffset;
+	c.dataIdx = codeData.size();
+	codeData.insert(codeData.end(), (const uint8*)data, (const uint8*)data + size);
+	codeData.insert(codeData.end(), (const uint8*)compare, (const uint8*)compare + compareSize);
+	code.push_back(c);
+	return true;
+}
+
+void CheatPatchTable::compile()
+{
+	run.clear();
+	condRun.clear();
+	data.clear();
+	struct BytePatch
+	{
+		uint32 region;
+		uint32 offset;
+		uint8 val;
+	};
+	std::vector<BytePatch> bytes;
+	for(const auto &c : code)
+	{
+		if(c.compareSize)
+			continue;
+		for(uint i = 0; i < c.size; i++)
+		{
+			bytes.push_back({c.region, c.offset + i, codeData[c.dataIdx + i]});
+		}
+	}
+	// stable so the last code written to an address is last among equal keys
+	std::stable_sort(bytes.begin(), bytes.end(),
+		[](const BytePatch &a, const BytePatch &b)
+		{
+			return a.region != b.region ? a.region < b.region : a.offset < b.offset;
+		});
+	for(size_t i = 0; i < bytes.size(); i++)
+	{
+		auto &b = bytes[i];
+		if(i + 1 < bytes.size() && bytes[i + 1].region == b.region && bytes[i + 1].offset == b.offset)
+			continue; // overwritten by a later code
+		auto dest = region[b.region].mem + b.offset;
+		if(!run.empty() && run.back().dest + run.back().size == dest)
+		{
+			run.back().size++;
+		}
+		else
+		{
+			run.push_back({dest, (uint32)data.size(), 1});
+		}
+		data.push_back(b.val);
+	}
+	for(const auto &c : code)
+	{
+		if(!c.compareSize)
+			continue;
+		ConditionalRun r;
+		r.run = {region[c.region].mem + c.offset, (uint32)data.size(), c.size};
+		data.insert(data.end(), &codeData[c.dataIdx], &codeData[c.dataIdx] + c.size);
+		r.test = region[c.region].mem + c.compareOffset;
+		r.compareIdx = data.size();
+		r.compareSize = c.compareSize;
+		r.notEqual = c.notEqual;
+		data.insert(data.end(), &codeData[c.dataIdx + c.size], &codeData[c.dataIdx + c.size] + c.compareSize);
+		condRun.push_back(r);
+	}
+	logMsg("compiled %u codes into %u runs, %u conditional",
+		(uint)code.size(), (uint)run.size(), (uint)condRun.size());
+}
+
+void CheatPatchTable::apply() const
+{
+	auto d = data.data();
+	for(const auto &r : run)
+	{
+		memcpy(r.dest, d + r.dataIdx, r.size);
+	}
+	for(const auto &c : condRun)
+	{
+		if((memcmp(c.test, d + c.compareIdx, c.compareSize) == 0) != c.notEqual)
+			memcpy(c.run.dest, d + c.run.dataIdx, c.run.size);
+	}
+}
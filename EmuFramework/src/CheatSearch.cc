@@ -0,0 +1,395 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "CheatSearch"
+#include <emuframework/CheatSearch.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/thread/Thread.hh>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/utility.h>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#if defined __SSE2__
+#include <emmintrin.h>
+#elif defined __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+// bitmap words hold 64 candidates, regions are padded so a word never spans two
+static constexpr uint BLOCK_BYTES = 64 * 4;
+
+struct SearchRegion
+{
+	const char *name;
+	const uint8 *data;
+	size_t size;
+	size_t snapOffset;
+};
+
+struct LaneMasks
+{
+	uint eq;
+	uint gt;
+};
+
+using Compare = CheatSearch::Compare;
+
+static std::vector<SearchRegion> region{};
+static std::vector<uint8> refSnap{}, curSnap{};
+static std::vector<uint64> candidate{};
+alignas(16) static uint8 valueBlock[BLOCK_BYTES]{};
+static uint elemSize = 0;
+static bool elemSigned = false;
+static uint candidateCount = 0;
+static std::atomic_bool busy{};
+static IG::thread worker{};
+
+template <class T>
+static LaneMasks compareLanes(const uint8 *a, const uint8 *b)
+{
+	#if defined __SSE2__
+	__m128i va = _mm_loadu_si128((const __m128i*)a);
+	__m128i vb = _mm_loadu_si128((const __m128i*)b);
+	__m128i flip;
+	if constexpr(sizeof(T) == 1)
+		flip = _mm_set1_epi8((char)0x80);
+	else if constexpr(sizeof(T) == 2)
+		flip = _mm_set1_epi16((short)0x8000);
+	else
+		flip = _mm_set1_epi32((int)0x80000000);
+	if constexpr(std::is_unsigned<T>::value)
+	{
+		// only signed compares exist, offset both sides
+		va = _mm_xor_si128(va, flip);
+		vb = _mm_xor_si128(vb, flip);
+	}
+	if constexpr(sizeof(T) == 1)
+	{
+		return {(uint)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)),
+			(uint)_mm_movemask_epi8(_mm_cmpgt_epi8(va, vb))};
+	}
+	else if constexpr(sizeof(T) == 2)
+	{
+		__m128i zero = _mm_setzero_si128();
+		return {(uint)_mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(va, vb), zero)),
+			(uint)_mm_movemask_epi8(_mm_packs_epi16(_mm_cmpgt_epi16(va, vb), zero))};
+	}
+	else
+	{
+		return {(uint)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, vb))),
+			(uint)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(va, vb)))};
+	}
+	#elif defined __ARM_NEON
+	if constexpr(sizeof(T) == 1)
+	{
+		static const uint8 weight[16]{1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+		auto laneBits = [](uint8x16_t m)
+			{
+				uint64x2_t s = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vandq_u8(m, vld1q_u8(weight)))));
+				return (uint)(vgetq_lane_u64(s, 0) | (vgetq_lane_u64(s, 1) << 8));
+			};
+		if constexpr(std::is_unsigned<T>::value)
+		{
+			uint8x16_t va = vld1q_u8(a), vb = vld1q_u8(b);
+			return {laneBits(vceqq_u8(va, vb)), laneBits(vcgtq_u8(va, vb))};
+		}
+		else
+		{
+			int8x16_t va = vld1q_s8((const int8*)a), vb = vld1q_s8((const int8*)b);
+			return {laneBits(vceqq_s8(va, vb)), laneBits(vcgtq_s8(va, vb))};
+		}
+	}
+	else if constexpr(sizeof(T) == 2)
+	{
+		static const uint16 weight[8]{1, 2, 4, 8, 16, 32, 64, 128};
+		auto laneBits = [](uint16x8_t m)
+			{
+				uint64x2_t s = vpaddlq_u32(vpaddlq_u16(vandq_u16(m, vld1q_u16(weight))));
+				return (uint)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+			};
+		if constexpr(std::is_unsigned<T>::value)
+		{
+			uint16x8_t va = vld1q_u16((const uint16*)a), vb = vld1q_u16((const uint16*)b);
+			return {laneBits(vceqq_u16(va, vb)), laneBits(vcgtq_u16(va, vb))};
+		}
+		else
+		{
+			int16x8_t va = vld1q_s16((const int16*)a), vb = vld1q_s16((const int16*)b);
+			return {laneBits(vceqq_s16(va, vb)), laneBits(vcgtq_s16(va, vb))};
+		}
+	}
+	else
+	{
+		static const uint32 weight[4]{1, 2, 4, 8};
+		auto laneBits = [](uint32x4_t m)
+			{
+				uint64x2_t s = vpaddlq_u32(vandq_u32(m, vld1q_u32(weight)));
+				return (uint)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+			};
+		if constexpr(std::is_unsigned<T>::value)
+		{
+			uint32x4_t va = vld1q_u32((const uint32*)a), vb = vld1q_u32((const uint32*)b);
+			return {laneBits(vceqq_u32(va, vb)), laneBits(vcgtq_u32(va, vb))};
+		}
+		else
+		{
+			int32x4_t va = vld1q_s32((const int32*)a), vb = vld1q_s32((const int32*)b);
+			return {laneBits(vceqq_s32(va, vb)), laneBits(vcgtq_s32(va, vb))};
+		}
+	}
+	#else
+	constexpr uint LANES = 16 / sizeof(T);
+	T va[LANES], vb[LANES];
+	memcpy(va, a, 16);
+	memcpy(vb, b, 16);
+	LaneMasks m{};
+	iterateTimes(LANES, i)
+	{
+		m.eq |= (uint)(va[i] == vb[i]) << i;
+		m.gt |= (uint)(va[i] > vb[i]) << i;
+	}
+	return m;
+	#endif
+}
+
+// one bit per value in a block of 64, set where a <compare> b
+template <class T>
+static uint64 blockMask(const uint8 *a, const uint8 *b, Compare compare)
+{
+	constexpr uint LANES = 16 / sizeof(T);
+	constexpr uint ALL = (1 << LANES) - 1;
+	uint64 mask = 0;
+	for(uint i = 0; i < 64; i += LANES)
+	{
+		auto m = compareLanes<T>(a + i * sizeof(T), b + i * sizeof(T));
+		uint bits;
+		switch(compare)
+		{
+			default:
+			case Compare::EQUAL: bits = m.eq; break;
+			case Compare::NOT_EQUAL: bits = ~m.eq & ALL; break;
+			case Compare::LESS: bits = ~(m.gt | m.eq) & ALL; break;
+			case Compare::GREATER: bits = m.gt; break;
+			case Compare::LESS_OR_EQUAL: bits = ~m.gt & ALL; break;
+			case Compare::GREATER_OR_EQUAL: bits = m.gt | m.eq; break;
+		}
+		mask |= (uint64)bits << i;
+	}
+	return mask;
+}
+
+template <class T>
+static void filterCandidates(Compare compare, bool againstValue)
+{
+	auto cur = curSnap.data();
+	auto ref = againstValue ? valueBlock : refSnap.data();
+	size_t refStride = againstValue ? 0 : 64 * sizeof(T);
+	size_t words = curSnap.size() / (64 * sizeof(T));
+	iterateTimes(words, w)
+	{
+		if(!candidate[w])
+			continue;
+		candidate[w] &= blockMask<T>(cur + w * 64 * sizeof(T), ref + w * refStride, compare);
+	}
+}
+
+static void runFilter(Compare compare, bool againstValue)
+{
+	switch(elemSize)
+	{
+		case 1: return elemSigned ? filterCandidates<int8>(compare, againstValue) : filterCandidates<uint8>(compare, againstValue);
+		case 2: return elemSigned ? filterCandidates<int16>(compare, againstValue) : filterCandidates<uint16>(compare, againstValue);
+		case 4: return elemSigned ? filterCandidates<int32>(compare, againstValue) : filterCandidates<uint32>(compare, againstValue);
+	}
+}
+
+static uint countCandidates()
+{
+	uint count = 0;
+	for(auto w : candidate)
+	{
+		count += __builtin_popcountll(w);
+	}
+	return count;
+}
+
+static void takeSnapshot(std::vector<uint8> &snap)
+{
+	for(const auto &r : region)
+	{
+		memcpy(&snap[r.snapOffset], r.data, r.size);
+	}
+}
+
+static void waitForWorker()
+{
+	if(worker.joinable())
+		worker.join();
+}
+
+void CheatSearch::addRegion(const char *name, const void *data, size_t size)
+{
+	stop();
+	region.push_back({name, (const uint8*)data, size, 0});
+}
+
+void CheatSearch::clearRegions()
+{
+	stop();
+	region.clear();
+}
+
+bool CheatSearch::hasRegions()
+{
+	return region.size();
+}
+
+const char *CheatSearch::regionName(uint idx)
+{
+	return idx < region.size() ? region[idx].name : "";
+}
+
+bool CheatSearch::start(uint size, bool isSigned)
+{
+	assert(size == 1 || size == 2 || size == 4);
+	if(busy || region.empty())
+		return false;
+	waitForWorker();
+	elemSize = size;
+	elemSigned = isSigned;
+	size_t snapSize = 0;
+	for(auto &r : region)
+	{
+		r.snapOffset = snapSize;
+		snapSize += (r.size + BLOCK_BYTES - 1) / BLOCK_BYTES * BLOCK_BYTES;
+	}
+	refSnap.assign(snapSize, 0);
+	curSnap.assign(snapSize, 0);
+	candidate.assign(snapSize / size / 64, 0);
+	for(const auto &r : region)
+	{
+		size_t first = r.snapOffset / size;
+		size_t values = r.size / size;
+		iterateTimes(values, i)
+		{
+			candidate[(first + i) / 64] |= (uint64)1 << ((first + i) % 64);
+		}
+	}
+	takeSnapshot(refSnap);
+	candidateCount = countCandidates();
+	logMsg("started %u-bit %s search with %u values", size * 8, isSigned ? "signed" : "unsigned", candidateCount);
+	return true;
+}
+
+static bool startStep(Compare compare, bool againstValue)
+{
+	if(busy || !elemSize)
+		return false;
+	waitForWorker();
+	takeSnapshot(curSnap);
+	busy = true;
+	worker = IG::thread{
+		[compare, againstValue]()
+		{
+			runFilter(compare, againstValue);
+			std::swap(refSnap, curSnap);
+			candidateCount = countCandidates();
+			logMsg("%u values left", candidateCount);
+			busy.store(false, std::memory_order_release);
+		}};
+	return true;
+}
+
+bool CheatSearch::searchChanged(Compare compare)
+{
+	return startStep(compare, false);
+}
+
+bool CheatSearch::searchValue(Compare compare, int64 value)
+{
+	if(busy)
+		return false;
+	iterateTimes(64, i)
+	{
+		// values are compared in host byte order, like the snapshot
+		switch(elemSize)
+		{
+			case 1: { uint8 v = value; memcpy(&valueBlock[i], &v, 1); break; }
+			case 2: { uint16 v = value; memcpy(&valueBlock[i * 2], &v, 2); break; }
+			case 4: { uint32 v = value; memcpy(&valueBlock[i * 4], &v, 4); break; }
+		}
+	}
+	return startStep(compare, true);
+}
+
+bool CheatSearch::isActive()
+{
+	return elemSize;
+}
+
+bool CheatSearch::isBusy()
+{
+	return busy.load(std::memory_order_acquire);
+}
+
+uint CheatSearch::candidates()
+{
+	return isBusy() ? 0 : candidateCount;
+}
+
+static int64 readValue(const uint8 *p)
+{
+	switch(elemSize)
+	{
+		case 1: return elemSigned ? (int64)(int8)*p : (int64)*p;
+		case 2: { uint16 v; memcpy(&v, p, 2); return elemSigned ? (int64)(int16)v : (int64)v; }
+		default: { uint32 v; memcpy(&v, p, 4); return elemSigned ? (int64)(int32)v : (int64)v; }
+	}
+}
+
+uint CheatSearch::results(Result *result, uint max)
+{
+	if(isBusy())
+		return 0;
+	uint written = 0;
+	uint regionIdx = 0;
+	for(size_t w = 0; w < candidate.size() && written < max; w++)
+	{
+		auto bits = candidate[w];
+		while(bits && written < max)
+		{
+			size_t snapOffset = (w * 64 + __builtin_ctzll(bits)) * elemSize;
+			bits &= bits - 1;
+			while(regionIdx + 1 < region.size() && snapOffset >= region[regionIdx + 1].snapOffset)
+				regionIdx++;
+			result[written++] = {regionIdx, (uint32)(snapOffset - region[regionIdx].snapOffset),
+				readValue(&refSnap[snapOffset])};
+		}
+	}
+	return written;
+}
+
+void CheatSearch::stop()
+{
+	waitForWorker();
+	busy = false;
+	elemSize = 0;
+	candidateCount = 0;
+	refSnap.clear();
+	curSnap.clear();
+	candidate.clear();
+}
@@ -15,7 +15,10 @@
 
 #include <emuframework/Cheats.hh>
 #include <emuframework/EmuApp.hh>
+#include <emuframework/CheatSearch.hh>
 #include <imagine/gui/TextEntry.hh>
+#include <imagine/util/string.h>
+#include <cstdlib>
 
 static StaticArrayList<RefreshCheatsDelegate*, 2> onRefreshCheatsList;
 
@@ -138,3 +141,206 @@ void EmuApp::refreshCheatViews()
 		(*e)();
 	}
 }
+
+CheatSearchView::CheatSearchView(ViewAttachParams attach):
+	TableView{"RAM Search", attach, item},
+	start8
+	{
+		"Start 8-bit Search",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			startSearch(1);
+		}
+	},
+	start16
+	{
+		"Start 16-bit Search",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			startSearch(2);
+		}
+	},
+	start32
+	{
+		"Start 32-bit Search",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			startSearch(4);
+		}
+	},
+	useSigned
+	{
+		"Signed Values",
+		false,
+		[this](BoolMenuItem &item, View &, Input::Event e)
+		{
+			item.flipBoolValue(*this);
+		}
+	},
+	equalTo
+	{
+		"Equal To Value",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			EmuApp::pushAndShowNewCollectTextInputView(attachParams(), e, "Input value (0x for hex)", "",
+				[this](CollectTextInputView &view, const char *str)
+				{
+					if(str && strlen(str))
+					{
+						char *end;
+						auto value = strtoll(str, &end, 0);
+						if(*end)
+						{
+							EmuApp::postMessage(true, "Invalid input");
+							window().postDraw();
+							return 1;
+						}
+						stepStarted(CheatSearch::searchValue(CheatSearch::Compare::EQUAL, value));
+					}
+					view.dismiss();
+					return 0;
+				});
+		}
+	},
+	changed
+	{
+		"Changed",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			stepStarted(CheatSearch::searchChanged(CheatSearch::Compare::NOT_EQUAL));
+		}
+	},
+	unchanged
+	{
+		"Unchanged",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			stepStarted(CheatSearch::searchChanged(CheatSearch::Compare::EQUAL));
+		}
+	},
+	increased
+	{
+		"Increased",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			stepStarted(CheatSearch::searchChanged(CheatSearch::Compare::GREATER));
+		}
+	},
+	decreased
+	{
+		"Decreased",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			stepStarted(CheatSearch::searchChanged(CheatSearch::Compare::LESS));
+		}
+	},
+	stop
+	{
+		"Stop Search",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			CheatSearch::stop();
+			refresh();
+		}
+	},
+	status{statusStr.data()}
+{
+	iterateTimes(MAX_RESULTS, i)
+	{
+		result[i] = {resultName[i].data(), resultValue[i].data()};
+	}
+	loadItems();
+}
+
+CheatSearchView::~CheatSearchView()
+{
+	stepDoneTimer.deinit();
+}
+
+void CheatSearchView::onShow()
+{
+	refresh();
+}
+
+void CheatSearchView::startSearch(uint size)
+{
+	if(!CheatSearch::start(size, useSigned.boolValue()))
+	{
+		EmuApp::postMessage(true, "No memory to search");
+		return;
+	}
+	refresh();
+}
+
+void CheatSearchView::stepStarted(bool started)
+{
+	if(!started)
+		return;
+	refresh();
+	// results come from the worker thread, check back until it's done
+	stepDoneTimer.callbackAfterMSec(
+		[this]()
+		{
+			if(CheatSearch::isBusy())
+				return;
+			stepDoneTimer.cancel();
+			refresh();
+		}, 16, 16, {});
+}
+
+void CheatSearchView::loadItems()
+{
+	bool active = CheatSearch::isActive();
+	bool busy = CheatSearch::isBusy();
+	start8.setActive(!busy);
+	start16.setActive(!busy);
+	start32.setActive(!busy);
+	for(auto i : {&equalTo, &changed, &unchanged, &increased, &decreased, &stop})
+	{
+		i->setActive(active && !busy);
+	}
+	if(busy)
+		string_copy(statusStr, "Searching...");
+	else if(active)
+		string_printf(statusStr, "%u Values Left", CheatSearch::candidates());
+	else
+		string_copy(statusStr, "Not Searching");
+	CheatSearch::Result res[MAX_RESULTS];
+	uint results = active && !busy ? CheatSearch::results(res, MAX_RESULTS) : 0;
+	iterateTimes(results, i)
+	{
+		string_printf(resultName[i], "%s+0x%X", CheatSearch::regionName(res[i].region), res[i].offset);
+		string_printf(resultValue[i], "%lld (0x%llX)", (long long)res[i].value, (unsigned long long)res[i].value);
+	}
+	item.clear();
+	if(!active)
+	{
+		item.emplace_back(&start8);
+		item.emplace_back(&start16);
+		item.emplace_back(&start32);
+		item.emplace_back(&useSigned);
+	}
+	else
+	{
+		item.emplace_back(&equalTo);
+		item.emplace_back(&changed);
+		item.emplace_back(&unchanged);
+		item.emplace_back(&increased);
+		item.emplace_back(&decreased);
+		item.emplace_back(&stop);
+	}
+	item.emplace_back(&status);
+	iterateTimes(results, i)
+	{
+		item.emplace_back(&result[i]);
+	}
+}
+
+void CheatSearchView::refresh()
+{
+	loadItems();
+	if(selected >= (int)item.size())
+		highlightCell(item.size() - 1);
+	place();
+	postDraw();
+}
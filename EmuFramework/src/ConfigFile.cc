@@ -229,6 +229,9 @@ static bool readConfig2(IO &io)
 			bcase CFGKEY_HIDE_STATUS_BAR: optionHideStatusBar.readFromIO(io, size);
 			bcase CFGKEY_CONFIRM_OVERWRITE_STATE: optionConfirmOverwriteState.readFromIO(io, size);
 			bcase CFGKEY_FAST_FORWARD_SPEED: optionFastForwardSpeed.readFromIO(io, size);
+			bcase CFGKEY_SCREENSHOT_COMPRESSION: optionScreenshotCompression.readFromIO(io, size);
+			bcase CFGKEY_SCREENSHOT_BURST_SECS: optionScreenshotBurstSecs.readFromIO(io, size);
+			bcase CFGKEY_STATE_HASH_INTERVAL: optionStateHashInterval.readFromIO(io, size);
 			#ifdef CONFIG_INPUT_DEVICE_HOTSWAP
 			bcase CFGKEY_NOTIFY_INPUT_DEVICE_CHANGE: optionNotifyInputDeviceChange.readFromIO(io, size);
 			#endif
@@ -256,6 +259,9 @@ static bool readConfig2(IO &io)
 			#ifdef EMU_FRAMEWORK_STRICT_UNDERRUN_CHECK_OPTION
 			bcase CFGKEY_SOUND_UNDERRUN_CHECK: optionSoundUnderrunCheck.readFromIO(io, size);
 			#endif
+			#ifdef CONFIG_AUDIO_PULL_MODE
+			bcase CFGKEY_SOUND_PULL_MODE: optionSoundPullMode.readFromIO(io, size);
+			#endif
 			#ifdef CONFIG_AUDIO_MANAGER_SOLO_MIX
 			bcase CFGKEY_AUDIO_SOLO_MIX: optionAudioSoloMix.readFromIO(io, size);
 			#endif
@@ -269,6 +275,9 @@ static bool readConfig2(IO &io)
 			#ifdef EMU_FRAMEWORK_WINDOW_PIXEL_FORMAT_OPTION
 			bcase CFGKEY_WINDOW_PIXEL_FORMAT: optionWindowPixelFormat.readFromIO(io, size);
 			#endif
+			#ifdef CONFIG_BASE_X11
+			bcase CFGKEY_SOFTWARE_PRESENT: optionSoftwarePresent.readFromIO(io, size);
+			#endif
 			bcase CFGKEY_INPUT_KEY_CONFIGS:
 			{
 				if(!readKeyConfig(io, size))
@@ -461,6 +470,9 @@ static OptionBase *cfgFileOption[] =
 	&optionSwappedGamepadConfirm,
 	&optionConfirmOverwriteState,
 	&optionFastForwardSpeed,
+	&optionScreenshotCompression,
+	&optionScreenshotBurstSecs,
+	&optionStateHashInterval,
 	#ifdef CONFIG_INPUT_DEVICE_HOTSWAP
 	&optionNotifyInputDeviceChange,
 	#endif
@@ -504,12 +516,18 @@ static OptionBase *cfgFileOption[] =
 	#ifdef EMU_FRAMEWORK_STRICT_UNDERRUN_CHECK_OPTION
 	&optionSoundUnderrunCheck,
 	#endif
+	#ifdef CONFIG_AUDIO_PULL_MODE
+	&optionSoundPullMode,
+	#endif
 	#ifdef CONFIG_AUDIO_MANAGER_SOLO_MIX
 	&optionAudioSoloMix,
 	#endif
 	#ifdef EMU_FRAMEWORK_WINDOW_PIXEL_FORMAT_OPTION
 	&optionWindowPixelFormat,
 	#endif
+	#ifdef CONFIG_BASE_X11
+	&optionSoftwarePresent,
+	#endif
 	&optionShowBundledGames,
 	&optionCheckSavePathWriteAccess
 };
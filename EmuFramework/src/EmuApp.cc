@@ -21,10 +21,21 @@
 #include <emuframework/EmuView.hh>
 #include <emuframework/EmuLoadProgressView.hh>
 #include <emuframework/FileUtils.hh>
+#include <emuframework/BackupMemory.hh>
+#include <emuframework/InputMovie.hh>
+#include <emuframework/RegressionFarm.hh>
+#include <emuframework/FramePacing.hh>
+#include <emuframework/Netplay.hh>
+#include <emuframework/BootSnapshot.hh>
+#include <emuframework/MemoryStats.hh>
+#include <emuframework/StartupProfiler.hh>
 #include <imagine/gui/AlertView.hh>
 #include <imagine/util/utility.h>
 #include <imagine/util/ScopeGuard.hh>
 #include <imagine/base/Pipe.hh>
+#ifdef CONFIG_BASE_X11
+#include <imagine/base/SoftwarePresenter.hh>
+#endif
 #include <imagine/thread/Thread.hh>
 #include <cmath>
 #include "private.hh"
@@ -75,6 +86,9 @@ BluetoothAdapter *bta{};
 #ifdef __ANDROID__
 std::unique_ptr<Base::UserActivityFaker> userActivityFaker{};
 #endif
+#ifdef CONFIG_BASE_X11
+static Base::SoftwarePresenter softwarePresenter{};
+#endif
 static EmuApp::OnMainMenuOptionChanged onMainMenuOptionChanged_{};
 FS::PathString lastLoadPath{};
 #ifdef CONFIG_EMUFRAMEWORK_VCONTROLS
@@ -98,7 +112,7 @@ static Gfx::PixmapTexture assetBuffImg[IG::size(assetFilename)];
 
 static void updateProjection(AppWindowData &appWin, const Gfx::Viewport &viewport);
 static Gfx::Viewport makeViewport(const Base::Window &win);
-void mainInitWindowCommon(Base::Window &win);
+void mainInitWindowCommon(Base::Window &win, bool showMainMenu);
 void handleOpenFileCommand(const char *filename);
 
 Gfx::PixmapTexture &getAsset(Gfx::Renderer &r, AssetID assetID)
@@ -128,8 +142,44 @@ void postDrawToEmuWindows()
 	emuWin->win.postDraw();
 }
 
+#ifdef CONFIG_BASE_X11
+static bool presentEmuVideoInSoftware()
+{
+	if(!softwarePresenter || emuWin != &mainWin || !emuView.hasLayer() || !EmuSystem::isActive()
+		|| popup.isVisible() || emuInputView.drawsControls()
+		|| optionImgEffect || optionOverlayEffect)
+	{
+		softwarePresenter.invalidate();
+		return false;
+	}
+	if(!softwarePresenter.present(emuVideo.memPix, emuVideoLayer.gameRect()))
+	{
+		softwarePresenter.invalidate();
+		return false;
+	}
+	return true;
+}
+#endif
+
+void updateSoftwarePresent()
+{
+	#ifdef CONFIG_BASE_X11
+	bool on = optionSoftwarePresent == SOFTWARE_PRESENT_ON
+		|| (optionSoftwarePresent == SOFTWARE_PRESENT_AUTO && renderer.isSoftwareRasterizer());
+	if(on && !softwarePresenter)
+		softwarePresenter.init(mainWin.win);
+	else if(!on)
+		softwarePresenter.deinit();
+	emuVideo.setSoftwarePresent(on);
+	#endif
+}
+
 static void drawEmuVideo(Gfx::Renderer &r)
 {
+	#ifdef CONFIG_BASE_X11
+	if(emuVideo.isSoftwarePresent() && presentEmuVideoInSoftware())
+		return;
+	#endif
 	if(emuView.hasLayer())
 		emuView.draw();
 	else if(emuView2.hasLayer())
@@ -181,18 +231,26 @@ void setCPUNeedsLowLatency(bool needed)
 	#endif
 }
 
+// set when FramePacing has a new estimate, applied when emulation next
+// starts or pauses since re-configuring audio mid-game can glitch it
+static bool frameRatesPending = false;
+
 static void applyFrameRates()
 {
+	frameRatesPending = false;
+	FramePacing::setNominalFrameTime(emuWin->win.screen()->frameTime());
 	EmuSystem::setFrameTime(EmuSystem::VIDSYS_NATIVE_NTSC,
-		optionFrameRate.val ? optionFrameRate.val : emuWin->win.screen()->frameTime());
+		optionFrameRate.val ? optionFrameRate.val : FramePacing::frameTime());
 	EmuSystem::setFrameTime(EmuSystem::VIDSYS_PAL,
-		optionFrameRatePAL.val ? optionFrameRatePAL.val : emuWin->win.screen()->frameTime());
+		optionFrameRatePAL.val ? optionFrameRatePAL.val : FramePacing::frameTime());
 	EmuSystem::configFrameTime();
 }
 
 static void startEmulation()
 {
 	setCPUNeedsLowLatency(true);
+	if(frameRatesPending)
+		applyFrameRates();
 	EmuSystem::start();
 	emuWin->win.screen()->addOnFrameOnce(onFrameUpdate);
 }
@@ -202,6 +260,8 @@ static void pauseEmulation()
 	EmuSystem::pause();
 	emuWin->win.screen()->removeOnFrame(onFrameUpdate);
 	setCPUNeedsLowLatency(false);
+	if(frameRatesPending)
+		applyFrameRates();
 }
 
 void closeGame(bool allowAutosaveState)
@@ -227,8 +287,14 @@ static void drawEmuFrame(Gfx::Renderer &r)
 	if(EmuSystem::runFrameOnDraw)
 	{
 		bool renderAudio = optionSound;
+		InputMovie::startFrame();
 		EmuSystem::runFrame(emuVideo, true, true, renderAudio);
 		EmuSystem::runFrameOnDraw = false;
+		if(unlikely(!StartupProfiler::isFinished()))
+		{
+			StartupProfiler::mark(StartupProfiler::FIRST_FRAME);
+			StartupProfiler::finish();
+		}
 	}
 	else
 	{
@@ -392,6 +458,7 @@ void startGameFromMenu()
 	emuWin->win.screen()->setFrameInterval(optionFrameInterval);
 	#endif
 	logMsg("running game");
+	StartupProfiler::mark(StartupProfiler::GAME_LOAD);
 	menuViewIsActive = 0;
 	viewStack.navView()->showRightBtn(true);
 	emuInputView.resetInput();
@@ -409,6 +476,16 @@ void startGameFromMenu()
 	emuView2.place();
 }
 
+// the main menu is only built when first needed so a game launched from the
+// command line reaches its first frame without it
+static void pushMainMenu()
+{
+	if(viewStack.size())
+		return;
+	auto mMenu = EmuSystem::makeView({mainWin.win, renderer}, EmuSystem::ViewID::MAIN_MENU);
+	viewStack.pushAndShow(*mMenu, Input::defaultEvent());
+}
+
 void EmuApp::restoreMenuFromGame()
 {
 	menuViewIsActive = 1;
@@ -420,6 +497,7 @@ void EmuApp::restoreMenuFromGame()
 	#endif
 	renderer.setWindowValidOrientations(mainWin.win, optionMenuOrientation);
 	Input::setKeyRepeat(true);
+	pushMainMenu();
 	if(!optionRememberLastMenu)
 		viewStack.popToRoot();
 	mainWin.win.screen()->setFrameRate(Base::Screen::DISPLAY_RATE_DEFAULT);
@@ -429,19 +507,38 @@ void EmuApp::restoreMenuFromGame()
 	viewStack.show();
 }
 
+static RegressionFarm::Config regressionConfig{};
+
 static const char *parseCmdLineArgs(int argc, char** argv)
 {
 	if(argc < 2)
 	{
 		return nullptr;
 	}
-	auto launchGame = argv[1];
+	if(RegressionFarm::parseArgs(argc, argv, regressionConfig))
+	{
+		logMsg("running regression manifest: %s", regressionConfig.manifestPath);
+		return nullptr;
+	}
+	uint netplayArgs = Netplay::parseArgs(argc, argv);
+	if(1 + netplayArgs >= (uint)argc)
+	{
+		return nullptr;
+	}
+	auto launchGame = argv[1 + netplayArgs];
 	logMsg("starting game from command line: %s", launchGame);
 	return launchGame;
 }
 
+static bool isLoadableFile(const char *path)
+{
+	return FS::status(path).type() == FS::file_type::regular &&
+		(EmuApp::hasArchiveExtension(path) || EmuSystem::defaultFsFilter(path));
+}
+
 void mainInitCommon(int argc, char** argv)
 {
+	StartupProfiler::start();
 	Base::registerInstance(appID(), argc, argv);
 	Base::setAcceptIPC(appID(), true);
 	Base::setOnInterProcessMessage(
@@ -460,6 +557,7 @@ void mainInitCommon(int argc, char** argv)
 		Base::exitWithErrorMessagePrintf(-1, "%s", err->what());
 		return;
 	}
+	StartupProfiler::mark(StartupProfiler::OPTIONS);
 	AudioManager::setMusicVolumeControlHint();
 	AudioManager::startSession();
 	Base::setIdleDisplayPowerSave(optionIdleDisplayPowerSave);
@@ -488,6 +586,7 @@ void mainInitCommon(int argc, char** argv)
 	{
 		renderer.setDither(optionDitherImage);
 	}
+	StartupProfiler::mark(StartupProfiler::RENDERER);
 
 	#ifdef __ANDROID__
 	if((int8)optionProcessPriority != 0)
@@ -507,6 +606,7 @@ void mainInitCommon(int argc, char** argv)
 
 	View::defaultFace = Gfx::GlyphTextureSet::makeSystem(renderer, IG::FontSettings{});
 	View::defaultBoldFace = Gfx::GlyphTextureSet::makeBoldSystem(renderer, IG::FontSettings{});
+	StartupProfiler::mark(StartupProfiler::FONTS);
 
 	#ifdef CONFIG_INPUT_ANDROID_MOGA
 	if(optionMOGAInputSystem)
@@ -581,6 +681,8 @@ void mainInitCommon(int argc, char** argv)
 			Audio::closePcm();
 			AudioManager::endSession();
 			renderer.restoreBind();
+			// the process may be killed once in the background, get pending saves on disk first
+			BackupMemory::flush(true);
 			if(backgrounded)
 			{
 				pauseEmulation();
@@ -669,19 +771,30 @@ void mainInitCommon(int argc, char** argv)
 
 	onFrameUpdate = [](Base::Screen::FrameParams params)
 		{
+			if(FramePacing::addTimestamp(params.timestamp())
+				&& (!optionFrameRate.val || !optionFrameRatePAL.val))
+			{
+				frameRatesPending = true;
+			}
+			#ifdef CONFIG_INPUT_EVDEV
+			Input::flushEvents();
+			#endif
 			commonUpdateInput();
-			if(unlikely(fastForwardActive))
+			if(unlikely(fastForwardActive && !Netplay::isActive()))
 			{
 				EmuSystem::runFrameOnDraw = true;
 				postDrawToEmuWindows();
 				iterateTimes((uint)optionFastForwardSpeed, i)
 				{
+					InputMovie::startFrame();
 					EmuSystem::runFrame(emuVideo, false, false, false);
 				}
 			}
 			else
 			{
 				uint frames = EmuSystem::advanceFramesWithTime(params.timestamp());
+				if(unlikely(Netplay::isActive()))
+					frames = Netplay::update(frames);
 				//logDMsg("%d frames elapsed (%fs)", frames, Base::frameTimeBaseToSecsDec(params.frameTimeDiff()));
 				if(frames)
 				{
@@ -701,11 +814,13 @@ void mainInitCommon(int argc, char** argv)
 						bool renderAudio = optionSound;
 						iterateTimes(framesToSkip, i)
 						{
+							InputMovie::startFrame();
 							EmuSystem::runFrame(emuVideo, false, false, renderAudio);
 						}
 					}
 				}
 			}
+			BackupMemory::update(params.timestamp());
 			params.readdOnFrame();
 		};
 
@@ -768,7 +883,7 @@ void mainInitCommon(int argc, char** argv)
 				emuView.draw();
 				if(modalViewController.hasView())
 					modalViewController.draw();
-				else if(menuViewIsActive)
+				else if(menuViewIsActive && viewStack.size())
 					viewStack.draw();
 				popup.draw();
 				renderer.setClipRect(false);
@@ -782,8 +897,10 @@ void mainInitCommon(int argc, char** argv)
 	{
 		logMsg("requested external storage write permissions");
 	}
+	bool directLaunch = launchGame && !regressionConfig.manifestPath && isLoadableFile(launchGame);
 	renderer.initWindow(mainWin.win, winConf);
-	mainInitWindowCommon(mainWin.win);
+	mainInitWindowCommon(mainWin.win, !directLaunch);
+	updateSoftwarePresent();
 	EmuApp::onMainWindowCreated({mainWin.win, renderer}, Input::defaultEvent());
 
 	if(optionShowOnSecondScreen && Base::Screen::screens() > 1)
@@ -792,10 +909,31 @@ void mainInitCommon(int argc, char** argv)
 	}
 
 	applyFrameRates();
+	StartupProfiler::mark(StartupProfiler::WINDOW);
 
-	if(launchGame)
+	if(regressionConfig.manifestPath)
+	{
+		auto failures = RegressionFarm::run(regressionConfig);
+		Base::exit(failures ? 1 : 0);
+		return;
+	}
+
+	if(directLaunch)
+	{
+		logMsg("opening file %s directly from command line", launchGame);
+		onSelectFileFromPicker(renderer, launchGame, Input::defaultEvent());
+		if(!modalViewController.hasView() && !EmuSystem::gameIsRunning())
+		{
+			// the system didn't start loading, show the menu instead
+			pushMainMenu();
+			StartupProfiler::finish();
+		}
+	}
+	else
 	{
-		handleOpenFileCommand(launchGame);
+		if(launchGame)
+			handleOpenFileCommand(launchGame);
+		StartupProfiler::finish();
 	}
 
 	#ifdef __ANDROID__
@@ -806,7 +944,7 @@ void mainInitCommon(int argc, char** argv)
 	#endif
 }
 
-void mainInitWindowCommon(Base::Window &win)
+void mainInitWindowCommon(Base::Window &win, bool showMainMenu)
 {
 	updateProjection(mainWin, makeViewport(win));
 
@@ -829,6 +967,12 @@ void mainInitWindowCommon(Base::Window &win)
 			{
 				startGameFromMenu();
 			}
+			else if(!EmuSystem::gameIsRunning())
+			{
+				// a game launched without the menu failed to load
+				pushMainMenu();
+				StartupProfiler::finish();
+			}
 		};
 	viewStack.showNavView(optionTitleBar);
 	//logMsg("setting menu orientation");
@@ -849,8 +993,8 @@ void mainInitWindowCommon(Base::Window &win)
 	#endif
 
 	placeElements();
-	auto mMenu = EmuSystem::makeView({win, renderer}, EmuSystem::ViewID::MAIN_MENU);
-	viewStack.pushAndShow(*mMenu, Input::defaultEvent());
+	if(showMainMenu)
+		pushMainMenu();
 
 	win.show();
 	win.postDraw();
@@ -874,6 +1018,7 @@ bool handleInputEvent(Base::Window &win, Input::Event e)
 		return modalViewController.inputEvent(e);
 	else if(menuViewIsActive)
 	{
+		pushMainMenu();
 		if(e.pushed() && e.isDefaultCancelButton())
 		{
 			if(viewStack.size() == 1)
@@ -983,17 +1128,21 @@ void EmuApp::setOnMainMenuItemOptionChanged(OnMainMenuOptionChanged func)
 
 void loadGameComplete(bool tryAutoState, bool addToRecent)
 {
+	bool loadedState = false;
 	if(tryAutoState)
 	{
-		EmuApp::loadAutoState();
+		loadedState = EmuApp::loadAutoState();
 		if(!EmuSystem::gameIsRunning())
 		{
 			logErr("game was closed while trying to load auto-state");
 			return;
 		}
 	}
+	if(!loadedState)
+		BootSnapshot::onPowerOn();
 	if(addToRecent)
 		addRecentGame();
+	Netplay::startPending();
 	startGameFromMenu();
 }
 
@@ -1041,9 +1190,36 @@ void loadGameCompleteFromBenchmarkFilePicker(uint result, Input::Event e)
 	if(result)
 	{
 		logMsg("starting benchmark");
-		IG::Time time = EmuSystem::benchmark();
-		EmuSystem::closeGame(0);
+		// sound is still synthesized but has nowhere to go
+		Audio::closePcm();
+		// every tier starts from the same point in the game
+		EmuSystem::MemoryState startState;
+		if(auto err = EmuSystem::saveStateToMemory(startState);
+			err)
+		{
+			logWarn("tiers won't start from the same frame: %s", err->what());
+		}
+		// the shown fps stays the original video without sound run so results compare across versions
+		auto time = EmuSystem::benchmark().time;
+		MemoryStats::sampleSteadyState();
 		logMsg("done in: %f", double(time));
+		using FrameTier = EmuSystem::FrameTier;
+		const FrameTier tier[]{FrameTier::NO_PRESENT, FrameTier::NO_VIDEO, FrameTier::NO_AUDIO};
+		EmuSystem::BenchmarkResult res[IG::size(tier)];
+		std::string tierJSON;
+		iterateTimes(IG::size(tier), i)
+		{
+			if(startState.size())
+				EmuSystem::loadStateFromMemory(startState.data(), startState.size());
+			res[i] = EmuSystem::benchmark(tier[i]);
+			logMsg("%s: %f secs, %.2fx, %u video frames, %u sound frames", EmuSystem::frameTierName(tier[i]),
+				double(res[i].time), double(res[0].time) / double(res[i].time), res[i].videoFrames, res[i].audioFrames);
+			tierJSON += string_makePrintf<128>("%s{\"tier\":\"%s\",\"secs\":%f,\"videoFrames\":%u,\"audioFrames\":%u}",
+				i ? "," : "", EmuSystem::frameTierName(tier[i]), double(res[i].time), res[i].videoFrames, res[i].audioFrames).data();
+		}
+		logMsg("tiers:[%s]", tierJSON.c_str());
+		logMsg("memory:%s", MemoryStats::toJSON(MemoryStats::report()).c_str());
+		EmuSystem::closeGame(0);
 		popup.printf(2, 0, "%.2f fps", double(180.)/double(time));
 	}
 }
@@ -1302,6 +1478,12 @@ EmuSystem::Error EmuApp::loadState(const char *path)
 		return EmuSystem::makeError("File doesn't exist");
 	}
 	fixFilePermissions(path);
+	BootSnapshot::cancel();
+	if(InputMovie::isActive())
+	{
+		logMsg("loading state ends input movie");
+		InputMovie::stop();
+	}
 	logMsg("loading state %s", path);
 	return EmuSystem::loadState(path);
 }
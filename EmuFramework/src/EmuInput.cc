@@ -21,6 +21,7 @@
 #include <emuframework/EmuOptions.hh>
 #include <emuframework/EmuApp.hh>
 #include <emuframework/InputManagerView.hh>
+#include <emuframework/InputMovie.hh>
 #include "private.hh"
 #include "privateInput.hh"
 
@@ -196,7 +197,7 @@ void processRelPtr(Input::Event e)
 	{
 		//logMsg("reversed trackball X direction");
 		relPtr.x = e.pos().x;
-		EmuSystem::handleInputAction(Input::RELEASED, relPtr.xAction);
+		InputMovie::sendInputAction(Input::RELEASED, relPtr.xAction);
 	}
 	else
 		relPtr.x += e.pos().x;
@@ -204,14 +205,14 @@ void processRelPtr(Input::Event e)
 	if(e.pos().x)
 	{
 		relPtr.xAction = EmuSystem::translateInputAction(e.pos().x > 0 ? EmuControls::systemKeyMapStart+1 : EmuControls::systemKeyMapStart+3);
-		EmuSystem::handleInputAction(Input::PUSHED, relPtr.xAction);
+		InputMovie::sendInputAction(Input::PUSHED, relPtr.xAction);
 	}
 
 	if(relPtr.y != 0 && sign(relPtr.y) != sign(e.pos().y))
 	{
 		//logMsg("reversed trackball Y direction");
 		relPtr.y = e.pos().y;
-		EmuSystem::handleInputAction(Input::RELEASED, relPtr.yAction);
+		InputMovie::sendInputAction(Input::RELEASED, relPtr.yAction);
 	}
 	else
 		relPtr.y += e.pos().y;
@@ -219,7 +220,7 @@ void processRelPtr(Input::Event e)
 	if(e.pos().y)
 	{
 		relPtr.yAction = EmuSystem::translateInputAction(e.pos().y > 0 ? EmuControls::systemKeyMapStart+2 : EmuControls::systemKeyMapStart);
-		EmuSystem::handleInputAction(Input::PUSHED, relPtr.yAction);
+		InputMovie::sendInputAction(Input::PUSHED, relPtr.yAction);
 	}
 
 	//logMsg("trackball event %d,%d, rel ptr %d,%d", e.x, e.y, relPtr.x, relPtr.y);
@@ -245,12 +246,12 @@ void commonUpdateInput()
 			if(turboClock == 0)
 			{
 				//logMsg("turbo push for player %d, action %d", e.player, e.action);
-				EmuSystem::handleInputAction(Input::PUSHED, e.action);
+				InputMovie::sendInputAction(Input::PUSHED, e.action);
 			}
 			else if(turboClock == turboFrames/2)
 			{
 				//logMsg("turbo release for player %d, action %d", e.player, e.action);
-				EmuSystem::handleInputAction(Input::RELEASED, e.action);
+				InputMovie::sendInputAction(Input::RELEASED, e.action);
 			}
 		}
 	}
@@ -268,13 +269,13 @@ void commonUpdateInput()
 	{
 		relPtr.x = applyRelPointerDecel(relPtr.x);
 		if(!relPtr.x)
-			EmuSystem::handleInputAction(Input::RELEASED, relPtr.xAction);
+			InputMovie::sendInputAction(Input::RELEASED, relPtr.xAction);
 	}
 	if(relPtr.y)
 	{
 		relPtr.y = applyRelPointerDecel(relPtr.y);
 		if(!relPtr.y)
-			EmuSystem::handleInputAction(Input::RELEASED, relPtr.yAction);
+			InputMovie::sendInputAction(Input::RELEASED, relPtr.yAction);
 	}
 #endif
 }
@@ -747,7 +748,7 @@ void setActiveFaceButtons(uint btns)
 	vController.gp.activeFaceBtns = btns;
 	setupVControllerVars();
 	vController.place();
-	EmuSystem::clearInputBuffers(emuInputView);
+	InputMovie::clearInputBuffers();
 	#endif
 }
 
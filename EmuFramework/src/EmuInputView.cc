@@ -17,6 +17,7 @@
 #include <emuframework/VController.hh>
 #include <emuframework/EmuApp.hh>
 #include <emuframework/EmuOptions.hh>
+#include <emuframework/InputMovie.hh>
 #include <imagine/gui/AlertView.hh>
 #include <emuframework/FilePicker.hh>
 #include "private.hh"
@@ -29,6 +30,11 @@ void EmuInputView::draw()
 	vController.draw(touchControlsAreOn && EmuSystem::touchControlsApplicable(), ffKeyPushed || ffToggleActive);
 }
 
+bool EmuInputView::drawsControls() const
+{
+	return vController.hasVisibleElements(touchControlsAreOn && EmuSystem::touchControlsApplicable());
+}
+
 void EmuInputView::place()
 {
 	#ifdef CONFIG_EMUFRAMEWORK_VCONTROLS
@@ -58,7 +64,8 @@ bool EmuInputView::inputEvent(Input::Event e)
 		auto &layoutPos = vControllerLayoutPos[mainWin.viewport().isPortrait() ? 1 : 0];
 		if(e.pushed() && layoutPos[VCTRL_LAYOUT_MENU_IDX].state != 0 && vController.menuBound.overlaps(e.pos()))
 		{
-			viewStack.top().clearSelection();
+			if(viewStack.size())
+				viewStack.top().clearSelection();
 			EmuApp::restoreMenuFromGame();
 			return true;
 		}
@@ -259,7 +266,7 @@ bool EmuInputView::inputEvent(Input::Event e)
 								turboActions.removeEvent(sysAction);
 							}
 						}
-						EmuSystem::handleInputAction(e.state(), sysAction);
+						InputMovie::sendInputAction(e.state(), sysAction);
 					}
 				}
 			}
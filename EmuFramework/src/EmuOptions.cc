@@ -59,6 +59,10 @@ Byte1Option optionSoundBuffers(CFGKEY_SOUND_BUFFERS,
 OptionAudioHintStrictUnderrunCheck optionSoundUnderrunCheck(CFGKEY_SOUND_UNDERRUN_CHECK, 1);
 #endif
 
+#ifdef CONFIG_AUDIO_PULL_MODE
+OptionAudioHintPullMode optionSoundPullMode(CFGKEY_SOUND_PULL_MODE, 0);
+#endif
+
 #ifdef CONFIG_AUDIO_MANAGER_SOLO_MIX
 OptionAudioSoloMix optionAudioSoloMix(CFGKEY_AUDIO_SOLO_MIX, 1);
 #endif
@@ -94,6 +98,9 @@ Byte1Option optionHideStatusBar(CFGKEY_HIDE_STATUS_BAR, 1, (!Config::envIsAndroi
 OptionSwappedGamepadConfirm optionSwappedGamepadConfirm(CFGKEY_SWAPPED_GAMEPAD_CONFIM, Input::SWAPPED_GAMEPAD_CONFIRM_DEFAULT);
 Byte1Option optionConfirmOverwriteState(CFGKEY_CONFIRM_OVERWRITE_STATE, 1, 0);
 Byte1Option optionFastForwardSpeed(CFGKEY_FAST_FORWARD_SPEED, 4, 0, optionIsValidWithMinMax<2, 7>);
+Byte1Option optionScreenshotCompression(CFGKEY_SCREENSHOT_COMPRESSION, 6, 0, optionIsValidWithMax<9>);
+Byte1Option optionScreenshotBurstSecs(CFGKEY_SCREENSHOT_BURST_SECS, 0, 0, optionIsValidWithMax<60>);
+Byte1Option optionStateHashInterval(CFGKEY_STATE_HASH_INTERVAL, 0, 0);
 #ifdef CONFIG_INPUT_DEVICE_HOTSWAP
 Byte1Option optionNotifyInputDeviceChange(CFGKEY_NOTIFY_INPUT_DEVICE_CHANGE, Config::Input::DEVICE_HOTSWAP, !Config::Input::DEVICE_HOTSWAP);
 #endif
@@ -250,6 +257,10 @@ bool windowPixelFormatIsValid(uint8 val)
 Byte1Option optionWindowPixelFormat(CFGKEY_WINDOW_PIXEL_FORMAT, IG::PIXEL_NONE, 0, windowPixelFormatIsValid);
 #endif
 
+#ifdef CONFIG_BASE_X11
+Byte1Option optionSoftwarePresent(CFGKEY_SOFTWARE_PRESENT, SOFTWARE_PRESENT_AUTO, 0, optionIsValidWithMax<SOFTWARE_PRESENT_AUTO>);
+#endif
+
 PathOption optionSavePath(CFGKEY_SAVE_PATH, EmuSystem::savePath_, "");
 PathOption optionLastLoadPath(CFGKEY_LAST_DIR, lastLoadPath, "");
 Byte1Option optionCheckSavePathWriteAccess{CFGKEY_CHECK_SAVE_PATH_WRITE_ACCESS, 1};
@@ -14,11 +14,21 @@
 	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
 
 #include <emuframework/EmuSystem.hh>
+#include <emuframework/EmuSystemInstance.hh>
 #include <emuframework/EmuOptions.hh>
 #include <emuframework/EmuApp.hh>
 #include <emuframework/FileUtils.hh>
 #include <emuframework/FilePicker.hh>
+#include <emuframework/BackupMemory.hh>
+#include <emuframework/AVRecorder.hh>
+#include <emuframework/InputMovie.hh>
+#include <emuframework/StateHash.hh>
+#include <emuframework/CheatSearch.hh>
+#include <emuframework/Netplay.hh>
+#include <emuframework/BootSnapshot.hh>
+#include <emuframework/MemoryStats.hh>
 #include <imagine/fs/ArchiveFS.hh>
+#include <imagine/io/PatchIO.hh>
 #include <imagine/audio/Audio.hh>
 #include <imagine/util/utility.h>
 #include <imagine/util/math/int.hh>
@@ -55,6 +65,8 @@ double EmuSystem::frameTimePAL = 1./50.;
 [[gnu::weak]] bool EmuSystem::handlesGenericIO = true;
 [[gnu::weak]] bool EmuSystem::hasCheats = false;
 [[gnu::weak]] bool EmuSystem::hasSound = true;
+[[gnu::weak]] bool EmuSystem::hasInstances = false;
+[[gnu::weak]] bool EmuSystem::hasMemoryStates = false;
 [[gnu::weak]] int EmuSystem::forcedSoundRate = 0;
 [[gnu::weak]] bool EmuSystem::constFrameRate = false;
 
@@ -92,6 +104,7 @@ void EmuSystem::startSound()
 			Audio::setHintOutputLatency(wantedLatency);
 			#endif
 			Audio::openPcm(pcmFormat);
+			MemoryStats::set(MemoryStats::AUDIO, Audio::isOpen() ? pcmFormat.framesToBytes(Audio::framesFree()) : 0);
 		}
 		else if(Audio::framesFree() <= (int)audioFramesPerVideoFrame)
 			Audio::resumePcm();
@@ -107,16 +120,94 @@ void EmuSystem::stopSound()
 	}
 }
 
-void EmuSystem::writeSound(const void *samples, uint framesToWrite)
+static uint soundFramesWritten = 0;
+
+static void startSoundIfBuffered()
 {
-	Audio::writePcm(samples, framesToWrite);
-	if(!Audio::isPlaying() && Audio::framesFree() <= (int)audioFramesPerVideoFrame)
+	if(!Audio::isPlaying() && Audio::framesFree() <= (int)EmuSystem::audioFramesPerVideoFrame)
 	{
 		logMsg("starting audio playback with %d frames free in buffer", Audio::framesFree());
 		Audio::resumePcm();
 	}
 }
 
+void EmuSystem::writeSound(const void *samples, uint framesToWrite)
+{
+	soundFramesWritten += framesToWrite;
+	Audio::writePcm(samples, framesToWrite);
+	if(AVRecorder::isRecording())
+	{
+		AVRecorder::writeAudio(samples, framesToWrite);
+	}
+	startSoundIfBuffered();
+}
+
+// nudges the output rate by up to 0.5% to hold the device's queue at its
+// latency hint, so drift between the emulated and device rates doesn't
+// slowly under or overrun the buffer
+static void adjustResampleRatio(Audio::Resampler &resampler)
+{
+	static constexpr double MAX_ADJUST = .005;
+	static double avgError = 0;
+	if(!Audio::isPlaying())
+	{
+		avgError = 0;
+		return;
+	}
+	double target = Audio::hintOutputLatency() / 1000000. * resampler.outputRate();
+	if(!target)
+		return;
+	double error = IG::clamp((Audio::frameDelay() - target) / target, -1., 1.);
+	avgError = avgError * .95 + error * .05;
+	resampler.setRatioAdjust(1. - avgError * MAX_ADJUST);
+}
+
+void EmuSystem::writeSound(Audio::Resampler &resampler, const int16 *samples, uint frames)
+{
+	adjustResampleRatio(resampler);
+	uint maxFrames = resampler.maxOutputFrames(frames);
+	auto buffer = getSoundBuffer(maxFrames);
+	if(buffer.frames >= maxFrames)
+	{
+		commitSoundBuffer(buffer, resampler.resample((int16*)buffer.data, samples, frames));
+		return;
+	}
+	// no buffer or it wraps around the end of the device's ring buffer
+	if(buffer)
+		commitSoundBuffer(buffer, 0);
+	static constexpr uint BUFF_FRAMES = 2048;
+	int16 resampled[BUFF_FRAMES * Audio::Resampler::MAX_CHANNELS];
+	while(frames)
+	{
+		// the resampler keeps its position so splitting the input changes nothing
+		uint inputFrames = frames;
+		while(inputFrames > 1 && resampler.maxOutputFrames(inputFrames) > BUFF_FRAMES)
+			inputFrames /= 2;
+		uint resampledFrames = resampler.resample(resampled, samples, inputFrames);
+		writeSound(resampled, resampledFrames);
+		samples += inputFrames * resampler.channelCount();
+		frames -= inputFrames;
+	}
+}
+
+Audio::BufferContext EmuSystem::getSoundBuffer(uint wantedFrames)
+{
+	return Audio::getPlayBuffer(wantedFrames);
+}
+
+void EmuSystem::commitSoundBuffer(Audio::BufferContext buffer, uint frames)
+{
+	if(!buffer)
+		return;
+	soundFramesWritten += frames;
+	if(frames && AVRecorder::isRecording())
+	{
+		AVRecorder::writeAudio(buffer.data, frames);
+	}
+	Audio::commitPlayBuffer(buffer, frames);
+	startSoundIfBuffered();
+}
+
 bool EmuSystem::stateExists(int slot)
 {
 	auto saveStr = sprintStateFilename(slot);
@@ -322,7 +413,15 @@ void EmuSystem::closeGame(bool allowAutosaveState)
 		if(allowAutosaveState)
 			EmuApp::saveAutoState();
 		logMsg("closing game %s", gameName_.data());
+		AVRecorder::stop();
+		BootSnapshot::cancel();
+		Netplay::stop();
+		InputMovie::stop();
+		BackupMemory::reset();
 		closeSystem();
+		StateHash::clearRegions();
+		CheatSearch::clearRegions();
+		MemoryStats::closeGame();
 		cancelAutoSaveStateTimer();
 		viewStack.navView()->showRightBtn(false);
 		state = State::OFF;
@@ -339,6 +438,7 @@ void EmuSystem::pause()
 {
 	if(isActive())
 		state = State::PAUSED;
+	BackupMemory::flush();
 	stopSound();
 	cancelAutoSaveStateTimer();
 }
@@ -346,21 +446,54 @@ void EmuSystem::pause()
 void EmuSystem::start()
 {
 	state = State::ACTIVE;
-	clearInputBuffers(emuInputView);
+	InputMovie::clearInputBuffers();
 	resetFrameTime();
 	startSound();
 	startAutoSaveStateTimer();
 }
 
-IG::Time EmuSystem::benchmark()
+const char *EmuSystem::frameTierName(FrameTier tier)
+{
+	switch(tier)
+	{
+		case FrameTier::FULL: return "full";
+		case FrameTier::NO_PRESENT: return "no present";
+		case FrameTier::NO_VIDEO: return "no video";
+		case FrameTier::NO_AUDIO: return "no audio";
+	}
+	return "";
+}
+
+static EmuSystem::BenchmarkResult runBenchmarkFrames(bool processGfx, bool renderAudio)
 {
+	auto videoFrames = emuVideo.framesWritten;
+	auto audioFrames = soundFramesWritten;
 	auto now = IG::Time::now();
 	iterateTimes(180, i)
 	{
-		runFrame(emuVideo, false, true, false);
+		InputMovie::startFrame();
+		EmuSystem::runFrame(emuVideo, false, processGfx, renderAudio);
 	}
 	auto after = IG::Time::now();
-	return after-now;
+	return {after - now, emuVideo.framesWritten - videoFrames, soundFramesWritten - audioFrames};
+}
+
+EmuSystem::BenchmarkResult EmuSystem::benchmark()
+{
+	return runBenchmarkFrames(true, false);
+}
+
+EmuSystem::BenchmarkResult EmuSystem::benchmark(FrameTier tier)
+{
+	assert(tier != FrameTier::FULL);
+	auto result = runBenchmarkFrames(tier <= FrameTier::NO_PRESENT, tier <= FrameTier::NO_VIDEO);
+	if(tier >= FrameTier::NO_VIDEO && result.videoFrames)
+		logErr("%s frames composed %u video frames", frameTierName(tier), result.videoFrames);
+	if(tier >= FrameTier::NO_AUDIO && result.audioFrames)
+		logErr("%s frames wrote %u sound frames", frameTierName(tier), result.audioFrames);
+	if(tier == FrameTier::NO_PRESENT && !result.videoFrames)
+		logWarn("%s frames composed no video frames", frameTierName(tier));
+	return result;
 }
 
 void EmuSystem::skipFrames(uint frames)
@@ -369,6 +502,7 @@ void EmuSystem::skipFrames(uint frames)
 		return;
 	iterateTimes(frames, i)
 	{
+		InputMovie::startFrame();
 		runFrame(emuVideo, false, false, false);
 	}
 }
@@ -456,6 +590,8 @@ static void closeAndSetupNew(const char *path)
 {
 	EmuSystem::closeGame();
 	EmuSystem::setupGamePaths(path);
+	BootSnapshot::setContentKey(0);
+	MemoryStats::beginLoad();
 }
 
 void EmuSystem::createWithMedia(GenericIO io, const char *path, const char *name, Error &err, OnLoadProgressDelegate onLoadProgress)
@@ -473,6 +609,7 @@ EmuSystem::Error EmuSystem::loadGameFromPath(const char *pathStr, OnLoadProgress
 	{
 		closeAndSetupNew(path.data());
 		auto err = loadGame(GenericIO{}, onLoadProgress);
+		MemoryStats::endLoad();
 		if(err)
 		{
 			clearGamePaths();
@@ -489,6 +626,49 @@ EmuSystem::Error EmuSystem::loadGameFromPath(const char *pathStr, OnLoadProgress
 	return loadGameFromFile(io.makeGeneric(), path.data(), onLoadProgress);
 }
 
+static EmuSystem::Error loadGameAndKeyContent(IO &io, uint32 patchKey, EmuSystem::OnLoadProgressDelegate onLoadProgress)
+{
+	auto err = EmuSystem::loadGame(io, onLoadProgress);
+	if(!err && EmuSystem::bootSnapshotFrames())
+		BootSnapshot::setContentKey(BootSnapshot::hashContent(io, patchKey));
+	return err;
+}
+
+// loads the game through a PatchIO if an IPS/UPS/BPS patch with the game's name
+// is in its directory or the save directory
+static EmuSystem::Error loadGameWithPatches(GenericIO io, EmuSystem::OnLoadProgressDelegate onLoadProgress)
+{
+	for(auto dir : {EmuSystem::gamePath(), EmuSystem::savePath()})
+	{
+		if(!strlen(dir))
+			continue;
+		for(auto ext : {"ips", "ups", "bps"})
+		{
+			auto patchPath = FS::makePathStringPrintf("%s/%s.%s", dir, EmuSystem::gameName().data(), ext);
+			if(!FS::exists(patchPath.data()))
+				continue;
+			logMsg("applying patch:%s", patchPath.data());
+			FileIO patchFile{};
+			PatchIO patchIO{};
+			std::error_code ec = patchFile.open(patchPath);
+			if(!ec)
+				ec = patchIO.open(io, patchFile);
+			if(ec)
+			{
+				return EmuSystem::makeError("Error applying patch %s: %s",
+					FS::basename(patchPath).data(), ec.message().c_str());
+			}
+			// the patched content is hashed too, but only sampled for large files
+			auto patchKey = BootSnapshot::hashContent(patchFile, (uint32)patchIO.format());
+			patchFile.close();
+			MemoryStats::set(MemoryStats::ROM, patchIO.size());
+			return loadGameAndKeyContent(patchIO, patchKey, onLoadProgress);
+		}
+	}
+	MemoryStats::set(MemoryStats::ROM, io.size());
+	return loadGameAndKeyContent(io, 0, onLoadProgress);
+}
+
 EmuSystem::Error EmuSystem::loadGameFromFile(GenericIO file, const char *name, OnLoadProgressDelegate onLoadProgress)
 {
 	Error err;
@@ -524,13 +704,14 @@ EmuSystem::Error EmuSystem::loadGameFromFile(GenericIO file, const char *name, O
 		}
 		closeAndSetupNew(name);
 		originalGameName_ = originalName;
-		err = EmuSystem::loadGame(io, onLoadProgress);
+		err = loadGameWithPatches(io.makeGeneric(), onLoadProgress);
 	}
 	else
 	{
 		closeAndSetupNew(name);
-		err = EmuSystem::loadGame(file, onLoadProgress);
+		err = loadGameWithPatches(std::move(file), onLoadProgress);
 	}
+	MemoryStats::endLoad();
 	if(err)
 	{
 		clearGamePaths();
@@ -620,6 +801,59 @@ char EmuSystem::saveSlotCharUpper(int slot)
 
 [[gnu::weak]] void EmuSystem::onPrepareVideo(EmuVideo &video) {}
 
+[[gnu::weak]] std::unique_ptr<EmuSystem::Instance> EmuSystem::makeInstance() { return {}; }
+
+static FS::PathString memoryStateFilename()
+{
+	return FS::makePathStringPrintf("%s/.memstate.tmp", EmuSystem::savePath());
+}
+
+EmuSystem::Error EmuSystem::saveStateToMemoryWithFile(MemoryState &data)
+{
+	auto path = memoryStateFilename();
+	if(auto err = saveState(path.data());
+		err)
+	{
+		return err;
+	}
+	FileIO file;
+	file.open(path);
+	data.resize(file.size());
+	bool success = file.read(data.data(), data.size()) == (ssize_t)data.size();
+	file.close();
+	FS::remove(path);
+	if(!success)
+		return makeFileReadError();
+	return {};
+}
+
+[[gnu::weak]] uint EmuSystem::bootSnapshotFrames() { return 0; }
+
+[[gnu::weak]] FS::PathString EmuSystem::bootSnapshotConfig() { return {}; }
+
+EmuSystem::Error EmuSystem::loadStateFromMemoryWithFile(const uint8 *data, size_t size)
+{
+	auto path = memoryStateFilename();
+	if(auto ec = writeToNewFile(path.data(), (void*)data, size);
+		ec)
+	{
+		return makeError(ec);
+	}
+	auto err = loadState(path.data());
+	FS::remove(path);
+	return err;
+}
+
+[[gnu::weak]] EmuSystem::Error EmuSystem::saveStateToMemory(MemoryState &data)
+{
+	return saveStateToMemoryWithFile(data);
+}
+
+[[gnu::weak]] EmuSystem::Error EmuSystem::loadStateFromMemory(const uint8 *data, size_t size)
+{
+	return loadStateFromMemoryWithFile(data, size);
+}
+
 [[gnu::weak]] FS::FileString EmuSystem::fullGameNameForPath(const char *path)
 {
 	return fullGameNameForPathDefaultImpl(path);
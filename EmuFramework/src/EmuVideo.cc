@@ -18,6 +18,9 @@
 #include <emuframework/EmuOptions.hh>
 #include <emuframework/EmuApp.hh>
 #include <emuframework/Screenshot.hh>
+#include <emuframework/AVRecorder.hh>
+#include <emuframework/RegressionFarm.hh>
+#include <emuframework/MemoryStats.hh>
 #include "private.hh"
 
 void EmuVideo::resetImage()
@@ -34,6 +37,7 @@ void EmuVideo::setFormat(IG::PixmapDesc desc)
 		return; // no change to format
 	}
 	memPix = {};
+	textureIsStale = false;
 	if(!vidImg)
 	{
 		Gfx::TextureConfig conf{desc};
@@ -45,6 +49,7 @@ void EmuVideo::setFormat(IG::PixmapDesc desc)
 		vidImg.setFormat(desc, 1);
 	}
 	logMsg("resized to:%dx%d", desc.w(), desc.h());
+	updateMemoryStats();
 	// update all EmuVideoLayers
 	#ifdef CONFIG_GFX_OPENGL_SHADER_PIPELINE
 	emuVideoLayer.setEffect(optionImgEffect);
@@ -57,13 +62,19 @@ void EmuVideo::setFormat(IG::PixmapDesc desc)
 
 EmuVideoImage EmuVideo::startFrame()
 {
+	if(softwarePresent)
+	{
+		if(!memPix)
+			initMemPixmap();
+		return {*this, (IG::Pixmap)memPix};
+	}
 	auto lockedTex = vidImg.lock(0);
 	if(!lockedTex)
 	{
 		if(!memPix)
 		{
 			logMsg("created backing memory pixmap");
-			memPix = {vidImg.usedPixmapDesc()};
+			initMemPixmap();
 		}
 		return {*this, (IG::Pixmap)memPix};
 	}
@@ -72,46 +83,150 @@ EmuVideoImage EmuVideo::startFrame()
 
 void EmuVideo::writeFrame(Gfx::LockedTextureBuffer texBuff)
 {
+	framesWritten++;
 	if(screenshotNextFrame)
 	{
 		doScreenshot(texBuff.pixmap());
 	}
+	if(AVRecorder::isRecording())
+	{
+		AVRecorder::writeVideo(texBuff.pixmap());
+	}
+	if(RegressionFarm::isHashingFrame())
+	{
+		RegressionFarm::hashFrame(texBuff.pixmap());
+	}
 	vidImg.unlock(texBuff);
 }
 
 void EmuVideo::writeFrame(IG::Pixmap pix)
 {
+	framesWritten++;
 	if(screenshotNextFrame)
 	{
 		doScreenshot(pix);
 	}
+	if(AVRecorder::isRecording())
+	{
+		AVRecorder::writeVideo(pix);
+	}
+	if(RegressionFarm::isHashingFrame())
+	{
+		RegressionFarm::hashFrame(pix);
+	}
+	if(softwarePresent)
+	{
+		if(!memPix)
+			initMemPixmap();
+		if(pix.pixel({}) != memPix.pixel({}))
+			memPix.write(pix);
+		textureIsStale = true;
+		return;
+	}
 	vidImg.write(0, pix, {}, vidImg.bestAlignment(pix));
 }
 
+void EmuVideo::setSoftwarePresent(bool on)
+{
+	if(on == softwarePresent)
+		return;
+	logMsg("%s software presentation", on ? "using" : "stopped");
+	if(!on)
+		updateTexture();
+	softwarePresent = on;
+}
+
+void EmuVideo::updateTexture()
+{
+	if(!textureIsStale)
+		return;
+	textureIsStale = false;
+	vidImg.write(0, memPix, {}, vidImg.bestAlignment(memPix));
+}
+
+void EmuVideo::initMemPixmap()
+{
+	memPix = {vidImg.usedPixmapDesc()};
+	updateMemoryStats();
+}
+
+void EmuVideo::updateMemoryStats()
+{
+	size_t bytes = vidImg ? vidImg.usedPixmapDesc().pixelBytes() : 0;
+	if(memPix)
+		bytes += ((IG::Pixmap)memPix).bytes();
+	MemoryStats::set(MemoryStats::VIDEO, bytes);
+}
+
 void EmuVideo::takeGameScreenshot()
 {
+	if(optionScreenshotBurstSecs)
+	{
+		takeGameScreenshotBurst(optionScreenshotBurstSecs);
+		return;
+	}
+	burstScreenshots = 0;
+	screenshotNextFrame = true;
+}
+
+void EmuVideo::takeGameScreenshotBurst(double secs)
+{
+	screenshotBurstFrames = std::max(1., secs / EmuSystem::frameTime());
+	burstScreenshots = 0;
+	burstScreenshotError = false;
+	logMsg("capturing %u frames", screenshotBurstFrames);
 	screenshotNextFrame = true;
 }
 
 void EmuVideo::doScreenshot(IG::Pixmap pix)
 {
-	screenshotNextFrame = false;
+	bool inBurst = screenshotBurstFrames;
+	if(inBurst)
+		screenshotBurstFrames--;
+	screenshotNextFrame = screenshotBurstFrames;
 	FS::PathString path;
-	int screenshotNum = sprintScreenshotFilename(path);
+	// files of queued screenshots may not exist yet, so continue numbering after the last one
+	int startNum = screenshotWriter.hasPendingWrites() ? lastScreenshotNum + 1 : 0;
+	int screenshotNum = sprintScreenshotFilename(path, startNum);
 	if(screenshotNum == -1)
 	{
+		screenshotBurstFrames = 0;
+		screenshotNextFrame = false;
 		popup.postError("Too many screenshots");
+		return;
+	}
+	screenshotWriter.setOnWrite(
+		[this](int num, bool success)
+		{
+			onScreenshotWrite(num, success);
+		});
+	if(!screenshotWriter.write(pix, path, screenshotNum, optionScreenshotCompression))
+	{
+		// encoder can't keep up, skip this frame
+		if(!inBurst)
+			popup.postError("Screenshot already in progress");
+		return;
+	}
+	lastScreenshotNum = screenshotNum;
+	if(inBurst)
+		burstScreenshots++;
+}
+
+void EmuVideo::onScreenshotWrite(int num, bool success)
+{
+	if(!success)
+	{
+		burstScreenshotError = true;
+		popup.printf(2, 1, "Error writing screenshot #%d", num);
+	}
+	else if(burstScreenshots)
+	{
+		if(!screenshotBurstFrames && !screenshotWriter.hasPendingWrites() && !burstScreenshotError)
+			popup.printf(2, 0, "Wrote %u screenshots", burstScreenshots);
 	}
 	else
 	{
-		if(!writeScreenshot(pix, path.data()))
-		{
-			popup.printf(2, 1, "Error writing screenshot #%d", screenshotNum);
-		}
-		else
-		{
-			popup.printf(2, 0, "Wrote screenshot #%d", screenshotNum);
-		}
+		popup.printf(2, 0, "Wrote screenshot #%d", num);
 	}
 }
 
@@ -231,6 +231,7 @@ void EmuVideoLayer::draw(const Gfx::ProjectionPlane &projP)
 	auto &r = video.renderer();
 	if(EmuSystem::isStarted())
 	{
+		video.updateTexture();
 		bool videoActive = true;
 		if(unlikely(!EmuSystem::isActive()))
 		{
@@ -268,7 +269,7 @@ void EmuVideoLayer::draw(const Gfx::ProjectionPlane &projP)
 
 void EmuVideoLayer::setOverlay(uint effect)
 {
-	vidImgOverlay.setEffect(video.renderer(), effect);
+	vidImgOverlay.setEffect(effect);
 }
 
 void EmuVideoLayer::setOverlayIntensity(Gfx::GC intensity)
@@ -278,7 +279,7 @@ void EmuVideoLayer::setOverlayIntensity(Gfx::GC intensity)
 
 void EmuVideoLayer::placeOverlay()
 {
-	vidImgOverlay.place(disp, video.size().y);
+	vidImgOverlay.place(video.renderer(), disp, video.size().y);
 }
 
 void EmuVideoLayer::setEffectBitDepth(uint bits)
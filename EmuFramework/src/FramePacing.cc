@@ -0,0 +1,149 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "FramePacing"
+#include <emuframework/FramePacing.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/utility.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+static constexpr uint WINDOW = 256; // points in the regression, about 4 seconds at 60Hz
+static constexpr uint MIN_POINTS = 120;
+static constexpr uint UPDATE_INTERVAL = 60;
+static constexpr double OUTLIER_TOLERANCE = .15; // of a vsync period
+static constexpr uint MAX_VSYNCS_PER_CALLBACK = 4;
+static constexpr double MAX_NOMINAL_DIFF = .05;
+// 200ppm, a 60Hz frame time this far off doubles or drops a frame every ~80 seconds
+static constexpr double APPLY_THRESHOLD = .0002;
+
+struct Point
+{
+	double vsync;
+	double secs;
+};
+
+static double nominalFrameTime = 0;
+static double estimate = 0;
+static double appliedFrameTime = 0;
+static double variance = 0;
+static Base::FrameTimeBase startTimestamp = 0, lastTimestamp = 0;
+static double vsyncs = 0;
+static std::array<Point, WINDOW> point{};
+static uint points = 0, pointsSinceUpdate = 0;
+static uint samples = 0, outliers = 0;
+
+static void restartSeries(Base::FrameTimeBase timestamp)
+{
+	startTimestamp = lastTimestamp = timestamp;
+	vsyncs = 0;
+	point[0] = {};
+	points = 1;
+	pointsSinceUpdate = 0;
+}
+
+static double regressionSlope()
+{
+	uint n = std::min(points, WINDOW);
+	double sumX = 0, sumY = 0;
+	iterateTimes(n, i)
+	{
+		sumX += point[i].vsync;
+		sumY += point[i].secs;
+	}
+	double meanX = sumX / n, meanY = sumY / n;
+	double sXY = 0, sXX = 0;
+	iterateTimes(n, i)
+	{
+		double dx = point[i].vsync - meanX;
+		sXY += dx * (point[i].secs - meanY);
+		sXX += dx * dx;
+	}
+	return sXX ? sXY / sXX : 0;
+}
+
+void FramePacing::setNominalFrameTime(double frameTime)
+{
+	if(frameTime == nominalFrameTime)
+		return;
+	logMsg("estimating from nominal frame time %.6fs", frameTime);
+	nominalFrameTime = frameTime;
+	estimate = appliedFrameTime = variance = 0;
+	startTimestamp = lastTimestamp = 0;
+	points = samples = outliers = 0;
+}
+
+bool FramePacing::addTimestamp(Base::FrameTimeBase timestamp)
+{
+	if(unlikely(!nominalFrameTime))
+		return false;
+	if(unlikely(!lastTimestamp || timestamp <= lastTimestamp))
+	{
+		restartSeries(timestamp);
+		return false;
+	}
+	double ref = estimate ? estimate : nominalFrameTime;
+	double interval = Base::frameTimeBaseToSecsDec(timestamp - lastTimestamp);
+	double intervalVsyncs = std::round(interval / ref);
+	if(intervalVsyncs < 1 || intervalVsyncs > MAX_VSYNCS_PER_CALLBACK
+		|| std::abs(interval - intervalVsyncs * ref) > ref * OUTLIER_TOLERANCE)
+	{
+		// a stall or a pause, the vsync count is lost so start a new series
+		outliers++;
+		restartSeries(timestamp);
+		return false;
+	}
+	lastTimestamp = timestamp;
+	samples++;
+	double residual = interval / intervalVsyncs - ref;
+	variance = variance ? variance * .99 + residual * residual * .01 : residual * residual;
+	vsyncs += intervalVsyncs;
+	point[points % WINDOW] = {vsyncs, Base::frameTimeBaseToSecsDec(timestamp - startTimestamp)};
+	points++;
+	if(points < MIN_POINTS || ++pointsSinceUpdate < UPDATE_INTERVAL)
+		return false;
+	pointsSinceUpdate = 0;
+	double slope = regressionSlope();
+	if(std::abs(slope - nominalFrameTime) > nominalFrameTime * MAX_NOMINAL_DIFF)
+	{
+		logWarn("ignoring estimate %.6fs too far from nominal %.6fs", slope, nominalFrameTime);
+		return false;
+	}
+	estimate = slope;
+	double current = appliedFrameTime ? appliedFrameTime : nominalFrameTime;
+	if(std::abs(estimate - current) <= current * APPLY_THRESHOLD)
+		return false;
+	appliedFrameTime = estimate;
+	logMsg("measured %.4fHz (nominal %.4fHz), jitter %.3fms, %u outliers in %u samples",
+		1. / estimate, 1. / nominalFrameTime, std::sqrt(variance) * 1000., outliers, samples);
+	return true;
+}
+
+double FramePacing::frameTime()
+{
+	return appliedFrameTime ? appliedFrameTime : nominalFrameTime;
+}
+
+FramePacing::Stats FramePacing::stats()
+{
+	Stats s;
+	s.frameTime = estimate;
+	s.jitter = std::sqrt(variance);
+	s.samples = samples;
+	s.outliers = outliers;
+	return s;
+}
@@ -0,0 +1,298 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "InputMovie"
+#include <emuframework/InputMovie.hh>
+#include <emuframework/EmuApp.hh>
+#include <emuframework/EmuInputView.hh>
+#include <emuframework/FileUtils.hh>
+#include <emuframework/StateHash.hh>
+#include <emuframework/Netplay.hh>
+#include <emuframework/BootSnapshot.hh>
+#include <emuframework/EmuOptions.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/logger/logger.h>
+#include <cstring>
+#include <vector>
+#include "private.hh"
+
+struct MovieHeader
+{
+	static constexpr char MAGIC[8]{'E', 'M', 'U', 'I', 'N', 'M', 'O', 'V'};
+	static constexpr uint16 VERSION = 1;
+
+	char magic[8]{};
+	uint16 version = VERSION;
+	InputMovie::Origin origin{};
+	uint8 padding{};
+	uint32 frames = 0;
+	uint32 events = 0;
+};
+
+struct MovieEvent
+{
+	static constexpr uint32 PUSHED_BIT = 1u << 31;
+	static constexpr uint32 CLEAR_BIT = 1u << 30;
+	static constexpr uint32 KEY_MASK = CLEAR_BIT - 1;
+
+	uint32 frame;
+	uint32 action;
+};
+
+enum class Mode : uint8 { OFF, RECORD, PLAY };
+
+static Mode mode = Mode::OFF;
+static FS::PathString moviePath{};
+static InputMovie::Origin movieOrigin{};
+static std::vector<MovieEvent> event{};
+static uint nextEvent = 0;
+static uint frameNow = 0, totalFrames = 0;
+
+constexpr char MovieHeader::MAGIC[8];
+
+static FS::PathString stateFilename(const char *moviePath)
+{
+	return FS::makePathStringPrintf("%s.state", moviePath);
+}
+
+static FS::PathString hashTrackFilename(const char *moviePath)
+{
+	return FS::makePathStringPrintf("%s.hash", moviePath);
+}
+
+static EmuSystem::Error setupOrigin(const char *path, InputMovie::Origin origin, bool recording)
+{
+	BootSnapshot::cancel();
+	if(origin == InputMovie::Origin::POWER_ON)
+	{
+		EmuSystem::reset(EmuSystem::RESET_HARD);
+		return {};
+	}
+	auto statePath = stateFilename(path);
+	if(recording)
+	{
+		fixFilePermissions(statePath);
+		return EmuSystem::saveState(statePath.data());
+	}
+	else
+	{
+		if(!FS::exists(statePath))
+			return EmuSystem::makeError("Movie's save state is missing");
+		return EmuSystem::loadState(statePath.data());
+	}
+}
+
+EmuSystem::Error InputMovie::startRecording(const char *path, Origin origin)
+{
+	if(!EmuSystem::gameIsRunning())
+		return EmuSystem::makeError("System not running");
+	stop();
+	if(auto err = setupOrigin(path, origin, true);
+		err)
+	{
+		return err;
+	}
+	EmuSystem::clearInputBuffers(emuInputView);
+	string_copy(moviePath, path);
+	movieOrigin = origin;
+	event.clear();
+	frameNow = totalFrames = 0;
+	mode = Mode::RECORD;
+	if(optionStateHashInterval)
+		StateHash::startRecording(optionStateHashInterval);
+	logMsg("recording movie:%s from %s", path, origin == Origin::STATE ? "state" : "power-on");
+	return {};
+}
+
+EmuSystem::Error InputMovie::startPlayback(const char *path)
+{
+	if(!EmuSystem::gameIsRunning())
+		return EmuSystem::makeError("System not running");
+	stop();
+	FileIO file;
+	file.open(path);
+	if(!file)
+		return EmuSystem::makeFileReadError();
+	MovieHeader header;
+	if(file.read(&header, sizeof(header)) != sizeof(header)
+		|| memcmp(header.magic, MovieHeader::MAGIC, sizeof(header.magic)) != 0)
+	{
+		return EmuSystem::makeError("Invalid movie file");
+	}
+	if(header.version != MovieHeader::VERSION)
+	{
+		return EmuSystem::makeError("Unsupported movie version %u", (uint)header.version);
+	}
+	event.resize(header.events);
+	if(header.events && file.read(event.data(), header.events * sizeof(MovieEvent))
+		!= (ssize_t)(header.events * sizeof(MovieEvent)))
+	{
+		event.clear();
+		return EmuSystem::makeError("Movie file is truncated");
+	}
+	if(auto err = setupOrigin(path, header.origin, false);
+		err)
+	{
+		event.clear();
+		return err;
+	}
+	EmuSystem::clearInputBuffers(emuInputView);
+	string_copy(moviePath, path);
+	movieOrigin = header.origin;
+	nextEvent = 0;
+	frameNow = 0;
+	totalFrames = header.frames;
+	mode = Mode::PLAY;
+	StateHash::startChecking(hashTrackFilename(path).data());
+	logMsg("playing movie:%s with %u frames, %u events", path, totalFrames, header.events);
+	return {};
+}
+
+static void writeMovie()
+{
+	MovieHeader header;
+	memcpy(header.magic, MovieHeader::MAGIC, sizeof(header.magic));
+	header.origin = movieOrigin;
+	header.frames = frameNow;
+	header.events = event.size();
+	fixFilePermissions(moviePath);
+	FileIO file;
+	file.create(moviePath);
+	if(!file)
+	{
+		logErr("error creating movie:%s", moviePath.data());
+		return;
+	}
+	file.write(&header, sizeof(header));
+	file.write(event.data(), event.size() * sizeof(MovieEvent));
+	logMsg("wrote movie:%s with %u frames, %u events", moviePath.data(), frameNow, (uint)event.size());
+}
+
+void InputMovie::stop()
+{
+	if(mode == Mode::RECORD)
+	{
+		writeMovie();
+		auto trackPath = hashTrackFilename(moviePath.data());
+		if(!StateHash::writeTrack(trackPath.data()) && FS::exists(trackPath))
+		{
+			// don't leave a track from an older recording
+			FS::remove(trackPath);
+		}
+	}
+	else if(mode == Mode::PLAY)
+	{
+		logMsg("stopped movie playback at frame %u", frameNow);
+		// drop any actions still held by the movie
+		EmuSystem::clearInputBuffers(emuInputView);
+	}
+	mode = Mode::OFF;
+	event.clear();
+	event.shrink_to_fit();
+	StateHash::stop();
+}
+
+bool InputMovie::isRecording()
+{
+	return mode == Mode::RECORD;
+}
+
+bool InputMovie::isPlaying()
+{
+	return mode == Mode::PLAY;
+}
+
+void InputMovie::sendInputAction(uint state, uint emuKey)
+{
+	if(unlikely(Netplay::isActive()))
+		return Netplay::sendInputAction(state, emuKey);
+	if(unlikely(BootSnapshot::isCapturing()))
+		BootSnapshot::cancel();
+	if(mode == Mode::PLAY)
+		return; // live input is ignored during playback
+	if(mode == Mode::RECORD)
+	{
+		assumeExpr(emuKey <= MovieEvent::KEY_MASK);
+		event.push_back({frameNow, (state == Input::PUSHED ? MovieEvent::PUSHED_BIT : 0) | emuKey});
+	}
+	EmuSystem::handleInputAction(state, emuKey);
+}
+
+void InputMovie::clearInputBuffers()
+{
+	if(unlikely(Netplay::isActive()))
+		return Netplay::clearInputBuffers();
+	if(mode == Mode::PLAY)
+		return;
+	if(mode == Mode::RECORD)
+	{
+		event.push_back({frameNow, MovieEvent::CLEAR_BIT});
+	}
+	EmuSystem::clearInputBuffers(emuInputView);
+}
+
+void InputMovie::startFrame()
+{
+	if(likely(mode == Mode::OFF))
+	{
+		if(unlikely(Netplay::isActive()))
+			Netplay::startFrame();
+		if(unlikely(BootSnapshot::isCapturing()))
+			BootSnapshot::onFrame();
+		frameNow++;
+		return;
+	}
+	StateHash::onFrame(frameNow);
+	if(mode == Mode::RECORD)
+	{
+		frameNow++;
+		return;
+	}
+	while(nextEvent < event.size() && event[nextEvent].frame == frameNow)
+	{
+		auto action = event[nextEvent++].action;
+		if(action & MovieEvent::CLEAR_BIT)
+			EmuSystem::clearInputBuffers(emuInputView);
+		else
+			EmuSystem::handleInputAction((action & MovieEvent::PUSHED_BIT) ? Input::PUSHED : Input::RELEASED,
+				action & MovieEvent::KEY_MASK);
+	}
+	frameNow++;
+	if(frameNow >= totalFrames)
+	{
+		bool checkedHashes = StateHash::isChecking();
+		uint hashes = StateHash::hashesChecked();
+		stop();
+		if(checkedHashes)
+			EmuApp::printfMessage(3, false, "Movie playback finished, %u state hashes matched", hashes);
+		else if(StateHash::firstDivergentFrame() == -1)
+			EmuApp::postMessage("Movie playback finished");
+	}
+}
+
+uint InputMovie::frame()
+{
+	return frameNow;
+}
+
+uint InputMovie::frames()
+{
+	return mode == Mode::PLAY ? totalFrames : frameNow;
+}
+
+FS::PathString inputMovieFilename()
+{
+	return FS::makePathStringPrintf("%s/%s.emm", EmuSystem::savePath(), EmuSystem::gameName().data());
+}
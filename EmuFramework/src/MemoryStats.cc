@@ -0,0 +1,228 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "MemoryStats"
+#include <emuframework/MemoryStats.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/utility.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#if defined __linux__
+#include <malloc.h>
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined __APPLE__
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#endif
+
+static constexpr size_t MiB = 1024 * 1024;
+// leaves room for the system and other apps on 512MB devices
+static size_t budget_ = 192 * MiB;
+static MemoryStats::Usage usage_[MemoryStats::CATEGORIES]{};
+static size_t loadStartHeap = 0, loadHeap = 0;
+static size_t loadPeakRSS = 0, steadyPeakRSS = 0;
+static bool canResetPeakRSS = false;
+
+static const char *categoryName[MemoryStats::CATEGORIES]
+{
+	"Video", "Audio", "ROM", "Sprite Cache", "States"
+};
+
+static const char *categoryKey[MemoryStats::CATEGORIES]
+{
+	"video", "audio", "rom", "spriteCache", "states"
+};
+
+#if defined __linux__
+// resets the kernel's peak resident size (VmHWM) so it can be read per phase
+static bool resetPeakRSS()
+{
+	int fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+	if(fd == -1)
+		return false;
+	bool success = write(fd, "5", 1) == 1;
+	close(fd);
+	return success;
+}
+
+static size_t peakRSSSinceReset()
+{
+	FILE *f = fopen("/proc/self/status", "re");
+	if(!f)
+		return 0;
+	char line[128];
+	unsigned long kb = 0;
+	while(fgets(line, sizeof(line), f))
+	{
+		if(sscanf(line, "VmHWM: %lu kB", &kb) == 1)
+			break;
+	}
+	fclose(f);
+	return kb * 1024;
+}
+#else
+static bool resetPeakRSS() { return false; }
+static size_t peakRSSSinceReset() { return 0; }
+#endif
+
+// without a resettable peak only the points where it's sampled are seen
+static size_t phasePeakRSS()
+{
+	return std::max(MemoryStats::rss(), canResetPeakRSS ? peakRSSSinceReset() : 0);
+}
+
+void MemoryStats::set(Category c, size_t bytes)
+{
+	assert(c < CATEGORIES);
+	usage_[c].bytes = bytes;
+	usage_[c].peak = std::max(usage_[c].peak, bytes);
+}
+
+MemoryStats::Usage MemoryStats::usage(Category c)
+{
+	assert(c < CATEGORIES);
+	return usage_[c];
+}
+
+const char *MemoryStats::name(Category c)
+{
+	assert(c < CATEGORIES);
+	return categoryName[c];
+}
+
+size_t MemoryStats::rss()
+{
+	#if defined __linux__
+	FILE *f = fopen("/proc/self/statm", "re");
+	if(!f)
+		return 0;
+	unsigned long pages = 0;
+	if(fscanf(f, "%*u %lu", &pages) != 1)
+		pages = 0;
+	fclose(f);
+	return pages * sysconf(_SC_PAGESIZE);
+	#elif defined __APPLE__
+	mach_task_basic_info info{};
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+		return 0;
+	return info.resident_size;
+	#else
+	return 0;
+	#endif
+}
+
+size_t MemoryStats::heapInUse()
+{
+	#if defined __GLIBC__ && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	auto info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+	#elif defined __linux__
+	auto info = mallinfo();
+	return (size_t)info.uordblks + (size_t)info.hblkhd;
+	#elif defined __APPLE__
+	malloc_statistics_t stats{};
+	malloc_zone_statistics(nullptr, &stats);
+	return stats.size_in_use;
+	#else
+	return 0;
+	#endif
+}
+
+void MemoryStats::beginLoad()
+{
+	for(auto &u : usage_)
+	{
+		u.peak = u.bytes;
+	}
+	loadStartHeap = heapInUse();
+	loadHeap = 0;
+	canResetPeakRSS = resetPeakRSS();
+	loadPeakRSS = rss();
+	steadyPeakRSS = 0;
+}
+
+void MemoryStats::endLoad()
+{
+	loadPeakRSS = std::max(loadPeakRSS, phasePeakRSS());
+	auto heap = heapInUse();
+	loadHeap = heap > loadStartHeap ? heap - loadStartHeap : 0;
+	canResetPeakRSS = resetPeakRSS();
+	steadyPeakRSS = rss();
+	logMsg("load peak RSS:%zuKiB, heap growth:%zuKiB, ROM:%zuKiB", loadPeakRSS / 1024, loadHeap / 1024,
+		usage_[ROM].bytes / 1024);
+	if(loadPeakRSS > budget_)
+		logWarn("load peak RSS over budget of %zuMiB", budget_ / MiB);
+}
+
+void MemoryStats::closeGame()
+{
+	set(ROM, 0);
+	set(SPRITE_CACHE, 0);
+	set(STATES, 0);
+}
+
+void MemoryStats::sampleSteadyState()
+{
+	steadyPeakRSS = std::max(steadyPeakRSS, phasePeakRSS());
+}
+
+MemoryStats::Report MemoryStats::report()
+{
+	Report r;
+	std::copy_n(usage_, CATEGORIES, r.category);
+	r.rss = rss();
+	r.heap = heapInUse();
+	r.loadHeap = loadHeap;
+	r.loadPeakRSS = loadPeakRSS;
+	r.steadyPeakRSS = steadyPeakRSS;
+	r.budget = budget_;
+	return r;
+}
+
+size_t MemoryStats::Report::peakRSS() const
+{
+	return std::max(loadPeakRSS, steadyPeakRSS);
+}
+
+void MemoryStats::setBudget(size_t bytes)
+{
+	budget_ = bytes;
+}
+
+size_t MemoryStats::budget()
+{
+	return budget_;
+}
+
+std::string MemoryStats::toJSON(const Report &r)
+{
+	char buff[256];
+	snprintf(buff, sizeof(buff), "{\"rss\":%zu,\"heap\":%zu,\"loadHeap\":%zu,\"loadPeakRSS\":%zu,"
+		"\"steadyPeakRSS\":%zu,\"budget\":%zu,\"overBudget\":%s,\"categories\":{",
+		r.rss, r.heap, r.loadHeap, r.loadPeakRSS, r.steadyPeakRSS, r.budget, r.overBudget() ? "true" : "false");
+	std::string json{buff};
+	iterateTimes(CATEGORIES, i)
+	{
+		snprintf(buff, sizeof(buff), "%s\"%s\":{\"bytes\":%zu,\"peak\":%zu}",
+			i ? "," : "", categoryKey[i], r.category[i].bytes, r.category[i].peak);
+		json += buff;
+	}
+	json += "}}";
+	return json;
+}
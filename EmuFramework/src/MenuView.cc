@@ -26,6 +26,14 @@
 #include <emuframework/InputManagerView.hh>
 #include <emuframework/TouchConfigView.hh>
 #include <emuframework/BundledGamesView.hh>
+#include <emuframework/AVRecorder.hh>
+#include <emuframework/InputMovie.hh>
+#include <emuframework/BootSnapshot.hh>
+#include <emuframework/Netplay.hh>
+#include <emuframework/Cheats.hh>
+#include <emuframework/CheatSearch.hh>
+#include <emuframework/MemoryStats.hh>
+#include <emuframework/StartupProfiler.hh>
 #include "private.hh"
 #ifdef CONFIG_BLUETOOTH
 #include <imagine/bluetooth/sys.hh>
@@ -71,6 +79,7 @@ public:
 			{
 				dismiss();
 				EmuSystem::reset(EmuSystem::RESET_HARD);
+				BootSnapshot::onPowerOn();
 				startGameFromMenu();
 			}
 		},
@@ -186,12 +195,21 @@ void MenuView::onShow()
 	logMsg("refreshing main menu state");
 	recentGames.setActive(recentGameList.size());
 	cheats.setActive(EmuSystem::gameIsRunning());
+	ramSearch.setActive(EmuSystem::gameIsRunning() && CheatSearch::hasRegions());
 	reset.setActive(EmuSystem::gameIsRunning());
 	saveState.setActive(EmuSystem::gameIsRunning());
 	loadState.setActive(EmuSystem::gameIsRunning() && EmuSystem::stateExists(EmuSystem::saveStateSlot));
 	stateSlotText[12] = saveSlotChar(EmuSystem::saveStateSlot);
 	stateSlot.compile(renderer(), projP);
 	screenshot.setActive(EmuSystem::gameIsRunning());
+	recordGameplay.setActive(EmuSystem::gameIsRunning());
+	recordGameplay.t.setString(AVRecorder::isRecording() ? "Stop Recording" : "Record Gameplay");
+	recordGameplay.compile(renderer(), projP);
+	recordMovie.setActive(EmuSystem::gameIsRunning());
+	recordMovie.t.setString(InputMovie::isActive() ? "Stop Input Movie" : "Record Input Movie");
+	recordMovie.compile(renderer(), projP);
+	playMovie.setActive(EmuSystem::gameIsRunning() && FS::exists(inputMovieFilename()));
+	netplay.setActive(EmuSystem::gameIsRunning());
 	#if defined CONFIG_BASE_ANDROID && !defined CONFIG_MACHINE_OUYA
 	addLauncherIcon.setActive(EmuSystem::gameIsRunning());
 	#endif
@@ -216,6 +234,7 @@ void MenuView::loadStandardItems()
 	{
 		item.emplace_back(&cheats);
 	}
+	item.emplace_back(&ramSearch);
 	item.emplace_back(&reset);
 	item.emplace_back(&loadState);
 	item.emplace_back(&saveState);
@@ -241,7 +260,19 @@ void MenuView::loadStandardItems()
 	item.emplace_back(&addLauncherIcon);
 	#endif
 	item.emplace_back(&benchmark);
+	if(Config::DEBUG_BUILD)
+	{
+		item.emplace_back(&memoryUsage);
+		item.emplace_back(&startupTime);
+	}
 	item.emplace_back(&screenshot);
+	item.emplace_back(&recordGameplay);
+	item.emplace_back(&recordMovie);
+	item.emplace_back(&playMovie);
+	if(EmuSystem::hasMemoryStates)
+	{
+		item.emplace_back(&netplay);
+	}
 	item.emplace_back(&about);
 	item.emplace_back(&exitApp);
 }
@@ -269,6 +300,18 @@ MenuView::MenuView(ViewAttachParams attach, bool customMenu):
 			}
 		}
 	},
+	ramSearch
+	{
+		"RAM Search",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			if(EmuSystem::gameIsRunning())
+			{
+				auto &searchMenu = *new CheatSearchView{attachParams()};
+				pushAndShow(searchMenu, e);
+			}
+		}
+	},
 	reset
 	{
 		"Reset",
@@ -424,6 +467,24 @@ MenuView::MenuView(ViewAttachParams attach, bool customMenu):
 			modalViewController.pushAndShow(*EmuFilePicker::makeForBenchmarking(attachParams()), e);
 		}
 	},
+	memoryUsage
+	{
+		"Memory Usage",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			auto &memMenu = *new MemoryUsageView{attachParams()};
+			pushAndShow(memMenu, e);
+		}
+	},
+	startupTime
+	{
+		"Startup Time",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			auto &startupMenu = *new StartupTimeView{attachParams()};
+			pushAndShow(startupMenu, e);
+		}
+	},
 	#if defined CONFIG_BASE_ANDROID && !defined CONFIG_MACHINE_OUYA
 	addLauncherIcon
 	{
@@ -564,9 +625,116 @@ MenuView::MenuView(ViewAttachParams attach, bool customMenu):
 			if(EmuSystem::gameIsRunning())
 			{
 				emuVideo.takeGameScreenshot();
+				InputMovie::startFrame();
 				EmuSystem::runFrame(emuVideo, false, true, false);
 			}
 		}
+	},
+	recordGameplay
+	{
+		"Record Gameplay",
+		[this](TextMenuItem &item, View &, Input::Event e)
+		{
+			if(!EmuSystem::gameIsRunning())
+				return;
+			if(AVRecorder::isRecording())
+			{
+				AVRecorder::stop();
+				if(auto dropped = AVRecorder::droppedPackets();
+					dropped)
+				{
+					EmuApp::printfMessage(3, true, "Recording stopped, %u packets dropped", dropped);
+				}
+				else
+				{
+					EmuApp::postMessage("Recording stopped");
+				}
+			}
+			else
+			{
+				FS::PathString basePath;
+				if(sprintRecordingBasePath(basePath) == -1)
+				{
+					EmuApp::postMessage(true, "Too many recordings");
+					return;
+				}
+				if(auto ec = AVRecorder::start(basePath.data(), emuVideo.vidImg.usedPixmapDesc(),
+					EmuSystem::frameTime(), EmuSystem::pcmFormat);
+					ec)
+				{
+					EmuApp::printfMessage(3, true, "Error starting recording: %s", ec.message().c_str());
+					return;
+				}
+				EmuApp::postMessage("Recording starts when the game resumes");
+			}
+			item.t.setString(AVRecorder::isRecording() ? "Stop Recording" : "Record Gameplay");
+			item.compile(renderer(), projP);
+		}
+	},
+	recordMovie
+	{
+		"Record Input Movie",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			if(!EmuSystem::gameIsRunning())
+				return;
+			if(InputMovie::isActive())
+			{
+				bool wasRecording = InputMovie::isRecording();
+				InputMovie::stop();
+				EmuApp::postMessage(wasRecording ? "Input movie saved" : "Input movie stopped");
+				onShow();
+				return;
+			}
+			static auto startRecording =
+				[](InputMovie::Origin origin)
+				{
+					if(auto err = InputMovie::startRecording(inputMovieFilename().data(), origin);
+						err)
+					{
+						popup.printf(4, true, "Record Input Movie: %s", err->what());
+					}
+					else
+						startGameFromMenu();
+				};
+			auto &ynAlertView = *new YesNoAlertView{attachParams(), "Start the movie from:", "Current State", "Power On",
+				[](TextMenuItem &, View &view, Input::Event e)
+				{
+					view.dismiss();
+					startRecording(InputMovie::Origin::STATE);
+				},
+				[](TextMenuItem &, View &view, Input::Event e)
+				{
+					view.dismiss();
+					startRecording(InputMovie::Origin::POWER_ON);
+				}};
+			modalViewController.pushAndShow(ynAlertView, e);
+		}
+	},
+	playMovie
+	{
+		"Play Input Movie",
+		[](TextMenuItem &, View &, Input::Event e)
+		{
+			if(!EmuSystem::gameIsRunning())
+				return;
+			if(auto err = InputMovie::startPlayback(inputMovieFilename().data());
+				err)
+			{
+				popup.printf(4, true, "Play Input Movie: %s", err->what());
+			}
+			else
+				startGameFromMenu();
+		}
+	},
+	netplay
+	{
+		"Netplay",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			auto &netplayMenu = *new NetplayView{attachParams()};
+			pushAndShow(netplayMenu, e);
+		}
 	}
 {
 	if(!customMenu)
@@ -689,3 +857,251 @@ RecentGameView::RecentGameView(ViewAttachParams attach):
 	}
 	clear.setActive(recentGameList.size());
 }
+
+static double toMiB(size_t bytes)
+{
+	return bytes / (1024. * 1024.);
+}
+
+MemoryUsageView::MemoryUsageView(ViewAttachParams attach):
+	TableView
+	{
+		"Memory Usage",
+		attach,
+		[this](const TableView &)
+		{
+			return row.size();
+		},
+		[this](const TableView &, uint idx) -> MenuItem&
+		{
+			return row[idx];
+		}
+	}
+{
+	MemoryStats::sampleSteadyState();
+	auto report = MemoryStats::report();
+	const char *name[MemoryStats::CATEGORIES + 6];
+	iterateTimes(MemoryStats::CATEGORIES, i)
+	{
+		auto &usage = report.category[i];
+		name[i] = MemoryStats::name((MemoryStats::Category)i);
+		valueStr.emplace_back();
+		string_printf(valueStr.back(), "%.1f MiB (peak %.1f)", toMiB(usage.bytes), toMiB(usage.peak));
+	}
+	auto addValue =
+		[&](const char *rowName, size_t bytes)
+		{
+			name[valueStr.size()] = rowName;
+			valueStr.emplace_back();
+			if(bytes)
+				string_printf(valueStr.back(), "%.1f MiB", toMiB(bytes));
+			else
+				string_copy(valueStr.back(), "Unknown");
+		};
+	addValue("Resident", report.rss);
+	addValue("Heap", report.heap);
+	addValue("Heap From Loading", report.loadHeap);
+	addValue("Peak While Loading", report.loadPeakRSS);
+	addValue("Peak After Loading", report.steadyPeakRSS);
+	name[valueStr.size()] = "Budget";
+	valueStr.emplace_back();
+	string_printf(valueStr.back(), "%.0f MiB%s", toMiB(report.budget), report.overBudget() ? ", Exceeded" : "");
+	row.reserve(valueStr.size());
+	iterateTimes(valueStr.size(), i)
+	{
+		row.emplace_back(name[i], valueStr[i].data());
+	}
+}
+
+StartupTimeView::StartupTimeView(ViewAttachParams attach):
+	TableView
+	{
+		"Startup Time",
+		attach,
+		[this](const TableView &)
+		{
+			return row.size();
+		},
+		[this](const TableView &, uint idx) -> MenuItem&
+		{
+			return row[idx];
+		}
+	}
+{
+	valueStr.resize(StartupProfiler::PHASES + 1);
+	row.reserve(valueStr.size());
+	iterateTimes(StartupProfiler::PHASES, i)
+	{
+		auto p = (StartupProfiler::Phase)i;
+		if(StartupProfiler::phaseRan(p))
+			string_printf(valueStr[i], "%.3fs", double(StartupProfiler::phaseTime(p)));
+		else
+			string_copy(valueStr[i], "Skipped");
+		row.emplace_back(StartupProfiler::name(p), valueStr[i].data());
+	}
+	string_printf(valueStr.back(), "%.3fs", double(StartupProfiler::total()));
+	row.emplace_back("Total", valueStr.back().data());
+}
+
+// kept for the session so reconnecting doesn't need them typed again
+static std::array<char, 256> netplayHost{"127.0.0.1"};
+static std::array<char, 6> netplayRemotePort{"5550"}, netplayLocalPort{"5550"};
+
+static bool setPortString(std::array<char, 6> &portStr, const char *str)
+{
+	int port = str ? atoi(str) : 0;
+	if(port < 1 || port > 65535)
+	{
+		popup.postError("Port must be between 1 and 65535");
+		return false;
+	}
+	string_printf(portStr, "%d", port);
+	return true;
+}
+
+NetplayView::NetplayView(ViewAttachParams attach):
+	TableView{"Netplay", attach, item},
+	remoteHost
+	{
+		"Remote Host", netplayHost.data(),
+		[this](DualTextMenuItem &, View &, Input::Event e)
+		{
+			EmuApp::pushAndShowNewCollectTextInputView(attachParams(), e, "Input Host Name or Address", netplayHost.data(),
+				[this](CollectTextInputView &view, const char *str)
+				{
+					if(str && strlen(str))
+					{
+						string_copy(netplayHost, str);
+						remoteHost.compile(renderer(), projP);
+						postDraw();
+					}
+					view.dismiss();
+					return 0;
+				});
+		}
+	},
+	remotePort
+	{
+		"Remote Port", netplayRemotePort.data(),
+		[this](DualTextMenuItem &, View &, Input::Event e)
+		{
+			EmuApp::pushAndShowNewCollectTextInputView(attachParams(), e, "Input Remote Port", netplayRemotePort.data(),
+				[this](CollectTextInputView &view, const char *str)
+				{
+					if(setPortString(netplayRemotePort, str))
+					{
+						remotePort.compile(renderer(), projP);
+						postDraw();
+					}
+					view.dismiss();
+					return 0;
+				});
+		}
+	},
+	localPort
+	{
+		"Local Port", netplayLocalPort.data(),
+		[this](DualTextMenuItem &, View &, Input::Event e)
+		{
+			EmuApp::pushAndShowNewCollectTextInputView(attachParams(), e, "Input Local Port", netplayLocalPort.data(),
+				[this](CollectTextInputView &view, const char *str)
+				{
+					if(setPortString(netplayLocalPort, str))
+					{
+						localPort.compile(renderer(), projP);
+						postDraw();
+					}
+					view.dismiss();
+					return 0;
+				});
+		}
+	},
+	connect
+	{
+		"Connect",
+		[](TextMenuItem &, View &, Input::Event e)
+		{
+			if(auto err = Netplay::startUdp(atoi(netplayLocalPort.data()), netplayHost.data(), atoi(netplayRemotePort.data()));
+				err)
+			{
+				popup.printf(4, true, "Netplay: %s", err->what());
+				return;
+			}
+			startGameFromMenu();
+		}
+	},
+	loopback
+	{
+		"Loopback Test",
+		[](TextMenuItem &, View &, Input::Event e)
+		{
+			if(auto err = Netplay::startLoopback(4, 5);
+				err)
+			{
+				popup.printf(4, true, "Netplay: %s", err->what());
+				return;
+			}
+			startGameFromMenu();
+		}
+	},
+	stop
+	{
+		"Stop Netplay",
+		[this](TextMenuItem &, View &, Input::Event e)
+		{
+			if(!Netplay::isActive())
+				return;
+			auto s = Netplay::stats();
+			Netplay::stop();
+			popup.printf(4, false, "Netplay stopped\n%u rollbacks, %u stalls", s.rollbacks, s.stalls);
+			onShow();
+			postDraw();
+		}
+	},
+	statsHeading{"Last Session"}
+{
+	const char *statName[STATS]{"Rollbacks", "Re-simulated Frames", "Stalls",
+		"Max Rollback Frames", "Avg Rollback", "Re-simulate Per Frame"};
+	iterateTimes(STATS, i)
+	{
+		stat[i] = {statName[i], statStr[i].data()};
+	}
+	updateStats();
+	item.emplace_back(&remoteHost);
+	item.emplace_back(&remotePort);
+	item.emplace_back(&localPort);
+	item.emplace_back(&connect);
+	item.emplace_back(&loopback);
+	item.emplace_back(&stop);
+	item.emplace_back(&statsHeading);
+	for(auto &s : stat)
+	{
+		item.emplace_back(&s);
+	}
+}
+
+void NetplayView::updateStats()
+{
+	auto s = Netplay::stats();
+	string_printf(statStr[0], "%u", s.rollbacks);
+	string_printf(statStr[1], "%u", s.resimulatedFrames);
+	string_printf(statStr[2], "%u", s.stalls);
+	string_printf(statStr[3], "%u", s.maxRollbackFrames);
+	string_printf(statStr[4], "%.2fms", s.avgRollbackTime * 1000.);
+	string_printf(statStr[5], "%.3fms", s.resimulateFrameTime * 1000.);
+}
+
+void NetplayView::onShow()
+{
+	bool active = Netplay::isActive();
+	connect.setActive(!active);
+	loopback.setActive(!active);
+	stop.setActive(active);
+	statsHeading.t.setString(active ? "Current Session" : "Last Session");
+	statsHeading.compile(renderer(), projP);
+	updateStats();
+	for(auto &s : stat)
+	{
+		s.compile(renderer(), projP);
+	}
+}
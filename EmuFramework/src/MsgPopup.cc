@@ -101,6 +101,11 @@ void MsgPopup::vprintf(uint secs, bool error, const char *format, va_list args)
 	postContent(secs, error);
 }
 
+bool MsgPopup::isVisible() const
+{
+	return strlen(str.data());
+}
+
 void MsgPopup::draw()
 {
 	using namespace Gfx;
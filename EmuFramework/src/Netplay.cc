@@ -0,0 +1,592 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "Netplay"
+#include <emuframework/Netplay.hh>
+#include <emuframework/EmuApp.hh>
+#include <emuframework/EmuInputView.hh>
+#include <emuframework/InputMovie.hh>
+#include <emuframework/BootSnapshot.hh>
+#include <emuframework/FramePacing.hh>
+#include <emuframework/MemoryStats.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/ScopeGuard.hh>
+#include <imagine/util/math/math.hh>
+#include <imagine/util/utility.h>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include "private.hh"
+
+static constexpr uint MAX_HELD = 16; // actions held at once by one side
+static constexpr uint MAX_ROLLBACK = 12;
+static constexpr uint MIN_ROLLBACK = 2;
+static constexpr uint STATE_RING = MAX_ROLLBACK + 1;
+static constexpr uint INPUT_RING = 128;
+static constexpr uint MAX_PACKET_INPUTS = 16;
+static constexpr double ROLLBACK_BUDGET = .5; // of a frame's time
+static constexpr uint NO_ROLLBACK = ~0u;
+
+struct FrameInput
+{
+	uint8 keys = 0;
+	std::array<uint32, MAX_HELD> key{}; // sorted
+
+	bool operator==(const FrameInput &rhs) const
+	{
+		return keys == rhs.keys && std::equal(key.data(), key.data() + keys, rhs.key.data());
+	}
+
+	bool operator!=(const FrameInput &rhs) const { return !(*this == rhs); }
+
+	bool contains(uint32 k) const
+	{
+		return std::binary_search(key.data(), key.data() + keys, k);
+	}
+
+	bool add(uint32 k)
+	{
+		auto end = key.data() + keys;
+		auto it = std::lower_bound(key.data(), end, k);
+		if(it != end && *it == k)
+			return true;
+		if(keys == MAX_HELD)
+			return false;
+		std::move_backward(it, end, end + 1);
+		*it = k;
+		keys++;
+		return true;
+	}
+
+	void remove(uint32 k)
+	{
+		auto end = key.data() + keys;
+		auto it = std::lower_bound(key.data(), end, k);
+		if(it == end || *it != k)
+			return;
+		std::move(it + 1, end, it);
+		keys--;
+	}
+};
+
+struct PacketHeader
+{
+	static constexpr uint32 MAGIC = 0x504E4D45; // "EMNP"
+
+	uint32 magic = MAGIC;
+	uint32 firstFrame = 0; // frame of the first input in the packet
+	uint32 nextAckFrame = 0; // all of the receiver's frames before this one arrived
+	uint8 inputs = 0;
+	uint8 padding[3]{};
+};
+
+static constexpr uint MAX_PACKET_SIZE = sizeof(PacketHeader) + MAX_PACKET_INPUTS * (1 + MAX_HELD * sizeof(uint32));
+
+// builds a packet with inputs for frames starting at firstFrame, getInput(frame) returns each one
+template <class GetInput>
+static uint writePacket(uint8 *packet, uint32 firstFrame, uint inputs, uint32 nextAckFrame, GetInput getInput)
+{
+	PacketHeader header;
+	header.firstFrame = firstFrame;
+	header.nextAckFrame = nextAckFrame;
+	header.inputs = std::min(inputs, MAX_PACKET_INPUTS);
+	memcpy(packet, &header, sizeof(header));
+	uint size = sizeof(header);
+	iterateTimes(header.inputs, i)
+	{
+		const FrameInput &input = getInput(firstFrame + i);
+		packet[size++] = input.keys;
+		memcpy(&packet[size], input.key.data(), input.keys * sizeof(uint32));
+		size += input.keys * sizeof(uint32);
+	}
+	return size;
+}
+
+// calls onInput(frame, input) for each input in the packet, returns false if it's malformed
+template <class OnInput>
+static bool readPacket(const uint8 *packet, uint size, PacketHeader &header, OnInput onInput)
+{
+	if(size < sizeof(header))
+		return false;
+	memcpy(&header, packet, sizeof(header));
+	if(header.magic != PacketHeader::MAGIC || header.inputs > MAX_PACKET_INPUTS)
+		return false;
+	uint pos = sizeof(header);
+	iterateTimes(header.inputs, i)
+	{
+		FrameInput input;
+		if(pos >= size)
+			return false;
+		input.keys = packet[pos++];
+		if(input.keys > MAX_HELD || pos + input.keys * sizeof(uint32) > size)
+			return false;
+		memcpy(input.key.data(), &packet[pos], input.keys * sizeof(uint32));
+		pos += input.keys * sizeof(uint32);
+		onInput(header.firstFrame + i, input);
+	}
+	return true;
+}
+
+class LoopbackTransport : public Netplay::Transport
+{
+public:
+	LoopbackTransport(uint latencyFrames, uint lossPercent):
+		latencyFrames{latencyFrames}, lossPercent{lossPercent} {}
+
+	void send(const void *data, uint size) final
+	{
+		tick++;
+		if(dropped())
+			return;
+		// play the other side: take the inputs as its own and answer with
+		// everything it has that the local side hasn't acknowledged
+		PacketHeader header;
+		bool valid = readPacket((const uint8*)data, size, header,
+			[this](uint32 frame, const FrameInput &input)
+			{
+				if(frame == baseFrame + history.size())
+					history.push_back(input);
+			});
+		if(!valid)
+			return;
+		while(history.size() > 1 && baseFrame < header.nextAckFrame)
+		{
+			history.pop_front();
+			baseFrame++;
+		}
+		if(dropped())
+			return;
+		uint32 firstFrame = std::max(baseFrame, header.nextAckFrame);
+		uint32 nextFrame = baseFrame + history.size();
+		if(firstFrame >= nextFrame)
+			return;
+		Packet reply;
+		reply.deliverTick = tick + latencyFrames;
+		reply.size = writePacket(reply.data.data(), firstFrame, nextFrame - firstFrame, nextFrame,
+			[this](uint32 frame) -> const FrameInput& { return history[frame - baseFrame]; });
+		queue.push_back(reply);
+	}
+
+	uint receive(void *data, uint maxSize) final
+	{
+		if(queue.empty() || queue.front().deliverTick > tick)
+			return 0;
+		auto &packet = queue.front();
+		uint size = std::min(packet.size, maxSize);
+		memcpy(data, packet.data.data(), size);
+		queue.pop_front();
+		return size;
+	}
+
+private:
+	struct Packet
+	{
+		std::array<uint8, MAX_PACKET_SIZE> data;
+		uint size;
+		uint deliverTick;
+	};
+	std::deque<FrameInput> history{};
+	std::deque<Packet> queue{};
+	uint32 baseFrame = 0;
+	uint tick = 0;
+	uint latencyFrames;
+	uint lossPercent;
+
+	bool dropped() const
+	{
+		return lossPercent && (uint)(rand() % 100) < lossPercent;
+	}
+};
+
+#ifndef _WIN32
+class UdpTransport : public Netplay::Transport
+{
+public:
+	UdpTransport(int fd): fd{fd} {}
+
+	~UdpTransport()
+	{
+		::close(fd);
+	}
+
+	void send(const void *data, uint size) final
+	{
+		if(::send(fd, data, size, 0) == -1 && errno != EAGAIN && errno != ECONNREFUSED)
+		{
+			logWarn("error sending packet: %s", strerror(errno));
+		}
+	}
+
+	uint receive(void *data, uint maxSize) final
+	{
+		for(;;)
+		{
+			auto size = ::recv(fd, data, maxSize, 0);
+			if(size > 0)
+				return size;
+			// an ICMP error from an earlier send, the other side may not be up yet
+			if(size == -1 && errno == ECONNREFUSED)
+				continue;
+			return 0;
+		}
+	}
+
+private:
+	int fd;
+};
+#endif
+
+static std::unique_ptr<Netplay::Transport> transport{};
+static uint inputDelay = 0;
+static uint frameNow = 0; // next frame to run
+static FrameInput localHeld{}, applied{};
+static std::array<FrameInput, INPUT_RING> localInput{}, remoteInput{};
+static uint localNext = 0, localAckNext = 0; // next local frame to record and the first one not acknowledged
+static uint remoteNext = 0; // next remote frame expected, earlier ones are confirmed
+static uint rollbackFrame = NO_ROLLBACK;
+static bool warnedHeldLimit = false;
+static Netplay::Stats stats_{};
+static bool hasPendingUdp = false;
+static uint16 pendingLocalPort = 0, pendingRemotePort = 0;
+static std::array<char, 256> pendingRemoteHost{};
+
+struct FrameRecord
+{
+	EmuSystem::MemoryState state{}; // before the frame's input was applied
+	FrameInput remote{}; // remote input the frame ran with, predicted unless confirmed
+};
+
+static std::array<FrameRecord, STATE_RING> record{};
+
+static const FrameInput &predictedRemoteInput(uint frame)
+{
+	static const FrameInput none{};
+	if(frame < remoteNext)
+		return remoteInput[frame % INPUT_RING];
+	return remoteNext ? remoteInput[(remoteNext - 1) % INPUT_RING] : none;
+}
+
+static void applyInput(uint frame, const FrameInput &remote)
+{
+	// both sides see the same union of held actions, send the changes in
+	// key order so each core gets identical calls
+	FrameInput target = localInput[frame % INPUT_RING];
+	iterateTimes(remote.keys, i)
+	{
+		target.add(remote.key[i]);
+	}
+	iterateTimes(applied.keys, i)
+	{
+		if(!target.contains(applied.key[i]))
+			EmuSystem::handleInputAction(Input::RELEASED, applied.key[i]);
+	}
+	iterateTimes(target.keys, i)
+	{
+		if(!applied.contains(target.key[i]))
+			EmuSystem::handleInputAction(Input::PUSHED, target.key[i]);
+	}
+	applied = target;
+}
+
+static void sendInput()
+{
+	std::array<uint8, MAX_PACKET_SIZE> packet;
+	uint size = writePacket(packet.data(), localAckNext, localNext - localAckNext, remoteNext,
+		[](uint32 frame) -> const FrameInput& { return localInput[frame % INPUT_RING]; });
+	transport->send(packet.data(), size);
+}
+
+static void receiveInput()
+{
+	std::array<uint8, MAX_PACKET_SIZE> packet;
+	while(uint size = transport->receive(packet.data(), packet.size()))
+	{
+		PacketHeader header;
+		bool valid = readPacket(packet.data(), size, header,
+			[](uint32 frame, const FrameInput &input)
+			{
+				// only take the next expected frame, and not so far ahead it
+				// would overwrite input still needed for prediction
+				if(frame != remoteNext || frame >= frameNow + INPUT_RING / 2)
+					return;
+				remoteInput[frame % INPUT_RING] = input;
+				remoteNext++;
+				if(frame < frameNow && input != record[frame % STATE_RING].remote)
+					rollbackFrame = std::min(rollbackFrame, (uint)frame);
+			});
+		if(!valid)
+		{
+			logWarn("ignoring malformed packet of %u bytes", size);
+			continue;
+		}
+		if(header.nextAckFrame > localAckNext && header.nextAckFrame <= localNext)
+			localAckNext = header.nextAckFrame;
+	}
+}
+
+static void updateMaxRollback()
+{
+	double frameTime = FramePacing::frameTime();
+	if(!frameTime)
+		frameTime = 1. / 60.;
+	uint frames = stats_.resimulateFrameTime ?
+		frameTime * ROLLBACK_BUDGET / stats_.resimulateFrameTime : MAX_ROLLBACK;
+	frames = IG::clamp(frames, MIN_ROLLBACK, MAX_ROLLBACK);
+	if(frames != stats_.maxRollbackFrames)
+	{
+		logMsg("max rollback now %u frames (%.3fms per re-simulated frame)",
+			frames, stats_.resimulateFrameTime * 1000.);
+		stats_.maxRollbackFrames = frames;
+	}
+}
+
+static void rollback()
+{
+	uint fromFrame = std::exchange(rollbackFrame, NO_ROLLBACK);
+	uint frames = frameNow - fromFrame;
+	if(frames > STATE_RING)
+	{
+		logErr("frame %u is older than the saved states, desynced", fromFrame);
+		Netplay::stop();
+		EmuApp::postMessage(true, "Netplay desynced");
+		return;
+	}
+	auto startTime = IG::Time::now();
+	auto &state = record[fromFrame % STATE_RING].state;
+	if(auto err = EmuSystem::loadStateFromMemory(state.data(), state.size());
+		err)
+	{
+		logErr("error restoring frame %u: %s", fromFrame, err->what());
+		Netplay::stop();
+		EmuApp::postMessage(true, "Netplay desynced");
+		return;
+	}
+	EmuSystem::clearInputBuffers(emuInputView);
+	applied = {};
+	for(uint frame = fromFrame; frame < frameNow; frame++)
+	{
+		auto &rec = record[frame % STATE_RING];
+		if(frame != fromFrame)
+			EmuSystem::saveStateToMemory(rec.state);
+		rec.remote = predictedRemoteInput(frame);
+		applyInput(frame, rec.remote);
+		EmuSystem::runFrame(emuVideo, false, false, false);
+	}
+	double secs = (IG::Time::now() - startTime).nSecs() / 1.0e9;
+	stats_.rollbacks++;
+	stats_.resimulatedFrames += frames;
+	stats_.lastRollbackTime = secs;
+	stats_.avgRollbackTime = stats_.rollbacks == 1 ? secs : stats_.avgRollbackTime * .9 + secs * .1;
+	double frameSecs = secs / frames;
+	stats_.resimulateFrameTime = stats_.resimulateFrameTime ?
+		stats_.resimulateFrameTime * .9 + frameSecs * .1 : frameSecs;
+	updateMaxRollback();
+}
+
+EmuSystem::Error Netplay::start(std::unique_ptr<Transport> transport_, uint inputDelay_)
+{
+	if(!EmuSystem::gameIsRunning())
+		return EmuSystem::makeError("System not running");
+	if(!EmuSystem::hasMemoryStates)
+		return EmuSystem::makeError("Netplay isn't supported by this system");
+	stop();
+	InputMovie::stop();
+	BootSnapshot::cancel();
+	EmuSystem::reset(EmuSystem::RESET_HARD);
+	EmuSystem::clearInputBuffers(emuInputView);
+	transport = std::move(transport_);
+	inputDelay = std::min(inputDelay_, MAX_ROLLBACK);
+	frameNow = 0;
+	localHeld = applied = {};
+	localInput.fill({});
+	remoteInput.fill({});
+	localNext = inputDelay;
+	localAckNext = remoteNext = 0;
+	rollbackFrame = NO_ROLLBACK;
+	warnedHeldLimit = false;
+	stats_ = {};
+	updateMaxRollback();
+	logMsg("started with %u frame input delay", inputDelay);
+	return {};
+}
+
+EmuSystem::Error Netplay::startUdp(uint16 localPort, const char *remoteHost, uint16 remotePort, uint inputDelay)
+{
+	#ifndef _WIN32
+	addrinfo hints{};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo *remote{};
+	auto portStr = string_makePrintf<8>("%u", (uint)remotePort);
+	if(int err = getaddrinfo(remoteHost, portStr.data(), &hints, &remote);
+		err)
+	{
+		return EmuSystem::makeError("Can't resolve %s: %s", remoteHost, gai_strerror(err));
+	}
+	auto freeRemote = IG::scopeGuard([&](){ freeaddrinfo(remote); });
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if(fd == -1)
+		return EmuSystem::makeError(std::error_code{errno, std::system_category()});
+	auto t = std::make_unique<UdpTransport>(fd);
+	sockaddr_in local{};
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(localPort);
+	if(bind(fd, (sockaddr*)&local, sizeof(local)) == -1
+		|| connect(fd, remote->ai_addr, remote->ai_addrlen) == -1
+		|| fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == -1)
+	{
+		return EmuSystem::makeError(std::error_code{errno, std::system_category()});
+	}
+	logMsg("using UDP port %u with %s:%u", (uint)localPort, remoteHost, (uint)remotePort);
+	return start(std::move(t), inputDelay);
+	#else
+	return EmuSystem::makeError("UDP netplay isn't supported on this platform");
+	#endif
+}
+
+EmuSystem::Error Netplay::startLoopback(uint latencyFrames, uint lossPercent)
+{
+	logMsg("using loopback with %u frame latency, %u%% loss", latencyFrames, lossPercent);
+	return start(std::make_unique<LoopbackTransport>(latencyFrames, lossPercent), 1);
+}
+
+uint Netplay::parseArgs(int argc, char** argv)
+{
+	if(argc < 5 || strcmp(argv[1], "--netplay") != 0)
+		return 0;
+	pendingLocalPort = atoi(argv[2]);
+	string_copy(pendingRemoteHost, argv[3]);
+	pendingRemotePort = atoi(argv[4]);
+	hasPendingUdp = true;
+	logMsg("netplay requested on port %u with %s:%u",
+		(uint)pendingLocalPort, pendingRemoteHost.data(), (uint)pendingRemotePort);
+	return 4;
+}
+
+void Netplay::startPending()
+{
+	if(!std::exchange(hasPendingUdp, false))
+		return;
+	if(auto err = startUdp(pendingLocalPort, pendingRemoteHost.data(), pendingRemotePort);
+		err)
+	{
+		EmuApp::printfMessage(4, true, "Netplay: %s", err->what());
+	}
+}
+
+void Netplay::stop()
+{
+	if(!transport)
+		return;
+	logMsg("stopped at frame %u, %u rollbacks re-simulating %u frames, %u stalls",
+		frameNow, stats_.rollbacks, stats_.resimulatedFrames, stats_.stalls);
+	transport.reset();
+	for(auto &rec : record)
+	{
+		rec.state.clear();
+		rec.state.shrink_to_fit();
+	}
+	MemoryStats::set(MemoryStats::STATES, 0);
+	EmuSystem::clearInputBuffers(emuInputView);
+}
+
+bool Netplay::isActive()
+{
+	return (bool)transport;
+}
+
+uint Netplay::update(uint frames)
+{
+	if(!transport)
+		return frames;
+	receiveInput();
+	if(rollbackFrame != NO_ROLLBACK)
+	{
+		rollback();
+		if(!transport)
+			return frames;
+	}
+	uint ahead = frameNow > remoteNext ? frameNow - remoteNext : 0;
+	uint allowed = ahead < stats_.maxRollbackFrames ? stats_.maxRollbackFrames - ahead : 0;
+	// don't outrun the resend window either
+	uint unacked = localNext - localAckNext;
+	allowed = std::min(allowed, unacked < INPUT_RING / 2 ? INPUT_RING / 2 - unacked : 0);
+	if(frames && !allowed)
+	{
+		stats_.stalls++;
+		// keep sending so the other side can catch up
+		sendInput();
+	}
+	return std::min(frames, allowed);
+}
+
+void Netplay::sendInputAction(uint state, uint emuKey)
+{
+	if(state == Input::PUSHED)
+	{
+		if(!localHeld.add(emuKey) && !warnedHeldLimit)
+		{
+			logWarn("more than %u actions held, ignoring new ones", MAX_HELD);
+			warnedHeldLimit = true;
+		}
+	}
+	else
+		localHeld.remove(emuKey);
+}
+
+void Netplay::clearInputBuffers()
+{
+	localHeld = {};
+}
+
+void Netplay::startFrame()
+{
+	if(!transport)
+		return;
+	auto &rec = record[frameNow % STATE_RING];
+	if(auto err = EmuSystem::saveStateToMemory(rec.state);
+		err)
+	{
+		logErr("error saving frame %u: %s", frameNow, err->what());
+		stop();
+		EmuApp::postMessage(true, "Netplay stopped, can't save states");
+		return;
+	}
+	if(frameNow < STATE_RING)
+		MemoryStats::set(MemoryStats::STATES, MemoryStats::usage(MemoryStats::STATES).bytes + rec.state.capacity());
+	localInput[localNext++ % INPUT_RING] = localHeld;
+	rec.remote = predictedRemoteInput(frameNow);
+	applyInput(frameNow, rec.remote);
+	sendInput();
+	frameNow++;
+}
+
+Netplay::Stats Netplay::stats()
+{
+	return stats_;
+}
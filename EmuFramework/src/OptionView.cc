@@ -17,6 +17,7 @@
 #include <emuframework/EmuApp.hh>
 #include <emuframework/EmuOptions.hh>
 #include <emuframework/FilePicker.hh>
+#include <emuframework/FramePacing.hh>
 #include <imagine/gui/TextEntry.hh>
 #include <algorithm>
 #include "private.hh"
@@ -247,6 +248,15 @@ static void setWindowPixelFormat(PixelFormatID format)
 }
 #endif
 
+#ifdef CONFIG_BASE_X11
+static void setSoftwarePresent(uint8 val)
+{
+	optionSoftwarePresent = val;
+	updateSoftwarePresent();
+	emuWin->win.postDraw();
+}
+#endif
+
 static void setFontSize(uint val)
 {
 	optionFontSize = val;
@@ -574,18 +584,31 @@ void FirmwarePathSelector::init(Gfx::Renderer &r, const char *name, Input::Event
 	viewStack.pushAndShow(multiChoiceView, e);
 }
 
+template <size_t S>
+static void printFrameRateStr(char (&str)[S], const char *name, EmuSystem::VideoSystem vidSys, bool usesScreenRate)
+{
+	auto stats = FramePacing::stats();
+	if(usesScreenRate && stats.frameTime)
+	{
+		string_printf(str, "%s: %.2fHz, %.2fms jitter", name,
+			1. / EmuSystem::frameTime(vidSys), stats.jitter * 1000.);
+	}
+	else
+	{
+		string_printf(str, "%s: %.2fHz", name, 1. / EmuSystem::frameTime(vidSys));
+	}
+}
+
 template <size_t S>
 static void printFrameRateStr(char (&str)[S])
 {
-	string_printf(str, "Frame Rate: %.2fHz",
-		1. / EmuSystem::frameTime(EmuSystem::VIDSYS_NATIVE_NTSC));
+	printFrameRateStr(str, "Frame Rate", EmuSystem::VIDSYS_NATIVE_NTSC, !optionFrameRate.val);
 }
 
 template <size_t S>
 static void printFrameRatePALStr(char (&str)[S])
 {
-	string_printf(str, "Frame Rate (PAL): %.2fHz",
-		1. / EmuSystem::frameTime(EmuSystem::VIDSYS_PAL));
+	printFrameRateStr(str, "Frame Rate (PAL)", EmuSystem::VIDSYS_PAL, !optionFrameRatePAL.val);
 }
 
 void VideoOptionView::loadStockItems()
@@ -625,6 +648,9 @@ void VideoOptionView::loadStockItems()
 	#ifdef EMU_FRAMEWORK_WINDOW_PIXEL_FORMAT_OPTION
 	item.emplace_back(&windowPixelFormat);
 	#endif
+	#ifdef CONFIG_BASE_X11
+	item.emplace_back(&softwarePresent);
+	#endif
 	if(!optionDitherImage.isConst)
 	{
 		item.emplace_back(&dither);
@@ -650,6 +676,9 @@ void AudioOptionView::loadStockItems()
 	#ifdef EMU_FRAMEWORK_STRICT_UNDERRUN_CHECK_OPTION
 	item.emplace_back(&sndUnderrunCheck);
 	#endif
+	#ifdef CONFIG_AUDIO_PULL_MODE
+	item.emplace_back(&sndPullMode);
+	#endif
 	#ifdef CONFIG_AUDIO_MANAGER_SOLO_MIX
 	item.emplace_back(&audioSoloMix);
 	#endif
@@ -851,7 +880,7 @@ VideoOptionView::VideoOptionView(ViewAttachParams attach, bool customMenu):
 					double wantedTime = time;
 					if(!time)
 					{
-						wantedTime = emuWin->win.screen()->frameTime();
+						wantedTime = FramePacing::frameTime();
 					}
 					if(!EmuSystem::setFrameTime(EmuSystem::VIDSYS_NATIVE_NTSC, wantedTime))
 					{
@@ -878,7 +907,7 @@ VideoOptionView::VideoOptionView(ViewAttachParams attach, bool customMenu):
 					double wantedTime = time;
 					if(!time)
 					{
-						wantedTime = emuWin->win.screen()->frameTime();
+						wantedTime = FramePacing::frameTime();
 					}
 					if(!EmuSystem::setFrameTime(EmuSystem::VIDSYS_PAL, wantedTime))
 					{
@@ -1094,6 +1123,20 @@ VideoOptionView::VideoOptionView(ViewAttachParams attach, bool customMenu):
 		windowPixelFormatItem
 	},
 	#endif
+	#ifdef CONFIG_BASE_X11
+	softwarePresentItem
+	{
+		{"Off", [this]() { setSoftwarePresent(SOFTWARE_PRESENT_OFF); }},
+		{"On", [this]() { setSoftwarePresent(SOFTWARE_PRESENT_ON); }},
+		{"Auto", [this]() { setSoftwarePresent(SOFTWARE_PRESENT_AUTO); }},
+	},
+	softwarePresent
+	{
+		"Present Without GPU",
+		optionSoftwarePresent,
+		softwarePresentItem
+	},
+	#endif
 	#if defined CONFIG_BASE_MULTI_WINDOW && defined CONFIG_BASE_X11
 	secondDisplay
 	{
@@ -1234,6 +1277,19 @@ AudioOptionView::AudioOptionView(ViewAttachParams attach, bool customMenu):
 		}
 	}
 	#endif
+	#ifdef CONFIG_AUDIO_PULL_MODE
+	,sndPullMode
+	{
+		"Low Latency Audio Thread",
+		(bool)optionSoundPullMode,
+		[this](BoolMenuItem &item, View &, Input::Event e)
+		{
+			if(Audio::isOpen())
+				Audio::closePcm();
+			optionSoundPullMode = item.flipBoolValue(*this);
+		}
+	}
+	#endif
 	#ifdef CONFIG_AUDIO_MANAGER_SOLO_MIX
 	,audioSoloMix
 	{
@@ -0,0 +1,457 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "Regression"
+#include <emuframework/RegressionFarm.hh>
+#include <emuframework/EmuSystem.hh>
+#include <emuframework/EmuSystemInstance.hh>
+#include <emuframework/EmuApp.hh>
+#include <emuframework/InputMovie.hh>
+#include <emuframework/MemoryStats.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/thread/Thread.hh>
+#include <imagine/time/Time.hh>
+#include <imagine/util/hash.hh>
+#include <imagine/util/string.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "private.hh"
+
+struct ManifestEntry
+{
+	std::string romPath;
+	std::string moviePath;
+	uint frames;
+};
+
+// output of a game run on an EmuSystem::Instance, written once its thread is done
+struct InstanceRun
+{
+	std::vector<std::string> lines;
+	std::string json;
+	bool failed = false;
+};
+
+static bool hashingFrame = false;
+static uint32 frameHash = 0;
+
+static std::string readFile(const char *path)
+{
+	FileIO file;
+	file.open(path);
+	if(!file)
+		return {};
+	std::string str(file.size(), '\0');
+	if(file.read(&str[0], str.size()) != (ssize_t)str.size())
+		return {};
+	return str;
+}
+
+// calls func with the tab separated fields of each line, skipping blank lines and # comments
+template <class FUNC>
+static void forEachLine(std::string &text, FUNC func)
+{
+	char *savePtr{};
+	for(char *line = strtok_r(&text[0], "\r\n", &savePtr); line; line = strtok_r(nullptr, "\r\n", &savePtr))
+	{
+		if(line[0] == '#' || !strlen(line))
+			continue;
+		std::vector<const char*> field;
+		char *fieldSavePtr{};
+		for(char *f = strtok_r(line, "\t", &fieldSavePtr); f; f = strtok_r(nullptr, "\t", &fieldSavePtr))
+		{
+			field.push_back(f);
+		}
+		func(field);
+	}
+}
+
+static std::vector<ManifestEntry> readManifest(const char *path)
+{
+	std::vector<ManifestEntry> entry;
+	auto text = readFile(path);
+	forEachLine(text,
+		[&](const std::vector<const char*> &field)
+		{
+			if(field.size() < 2)
+			{
+				logWarn("skipping manifest line with %u fields", (uint)field.size());
+				return;
+			}
+			entry.push_back({field[0], field.size() > 2 ? field[2] : "", (uint)strtoul(field[1], nullptr, 10)});
+		});
+	return entry;
+}
+
+static std::string checkpointKey(const char *romPath, uint frame)
+{
+	return std::string{romPath} + '\t' + std::to_string(frame);
+}
+
+static std::unordered_map<std::string, uint32> readBaseline(const char *path)
+{
+	std::unordered_map<std::string, uint32> baseline;
+	auto text = readFile(path);
+	forEachLine(text,
+		[&](const std::vector<const char*> &field)
+		{
+			if(field.size() < 3)
+				return;
+			baseline[checkpointKey(field[0], strtoul(field[1], nullptr, 10))] = strtoul(field[2], nullptr, 16);
+		});
+	return baseline;
+}
+
+// returns true if the baseline has a different hash for this checkpoint
+static bool isMismatch(const std::unordered_map<std::string, uint32> &baseline,
+	const char *rom, uint frame, uint32 hash, uint mismatches)
+{
+	if(baseline.empty())
+		return false;
+	auto it = baseline.find(checkpointKey(rom, frame));
+	if(it == baseline.end())
+	{
+		logWarn("%s: no baseline hash at frame %u", rom, frame);
+		return false;
+	}
+	if(it->second == hash)
+		return false;
+	if(!mismatches)
+		logErr("%s: first mismatch at frame %u, %08X != %08X", rom, frame, hash, it->second);
+	return true;
+}
+
+static uint32 pixmapHash(IG::Pixmap pix)
+{
+	uint rowBytes = pix.format().pixelBytes(pix.w());
+	uint32 crc = 0;
+	iterateTimes(pix.h(), y)
+	{
+		crc = IG::crc32c((const char*)pix.pixel({}) + y * pix.pitchBytes(), rowBytes, crc);
+	}
+	return crc;
+}
+
+[[gnu::format(printf, 2, 3)]]
+static void writeLine(IO &io, const char *format, ...)
+{
+	char line[1024];
+	va_list args;
+	va_start(args, format);
+	int len = vsnprintf(line, sizeof(line) - 1, format, args);
+	va_end(args);
+	len = std::min(len, (int)sizeof(line) - 2);
+	line[len++] = '\n';
+	io.write(line, len);
+}
+
+static std::string jsonString(const char *str)
+{
+	std::string json{'"'};
+	for(; *str; str++)
+	{
+		if(*str == '"' || *str == '\\')
+			json += '\\';
+		if((uint8)*str < 0x20)
+			continue;
+		json += *str;
+	}
+	json += '"';
+	return json;
+}
+
+// runs a game without a movie on its own instance, rendering every frame like
+// the app's machine so hashes and timings match its results
+static InstanceRun runOnInstance(const ManifestEntry &entry, uint checkpointInterval,
+	const std::unordered_map<std::string, uint32> &baseline)
+{
+	InstanceRun run;
+	auto rom = entry.romPath.c_str();
+	auto instance = EmuSystem::makeInstance();
+	EmuSystem::Error err{};
+	auto loadTime = IG::timeFunc(
+		[&]()
+		{
+			FileIO io;
+			io.open(rom);
+			err = io ? instance->loadGame(io, rom) : EmuSystem::makeFileReadError();
+		});
+	if(err)
+	{
+		logErr("%s: %s", rom, err->what());
+		run.lines.emplace_back(string_makePrintf<1024>("# %s: load error: %s", rom, err->what()).data());
+		run.failed = true;
+		return run;
+	}
+	uint frames = entry.frames;
+	IG::Time totalTime{}, maxTime{};
+	uint mismatches = 0;
+	iterateTimes(frames, f)
+	{
+		uint frame = f + 1;
+		bool hashing = frame % checkpointInterval == 0 || frame == frames;
+		bool completedFrame = false;
+		auto time = IG::timeFunc([&](){ completedFrame = instance->runFrame(true); });
+		totalTime += time;
+		maxTime = std::max(maxTime, time);
+		if(!hashing)
+			continue;
+		// the app's machine hashes nothing when no video frame completed
+		uint32 hash = completedFrame ? pixmapHash(instance->videoPixmap()) : 0;
+		run.lines.emplace_back(string_makePrintf<1024>("%s\t%u\t%08X", rom, frame, hash).data());
+		if(isMismatch(baseline, rom, frame, hash, mismatches))
+			mismatches++;
+	}
+	double avgMSecs = frames ? double(totalTime) * 1000. / frames : 0.;
+	double fps = frames ? frames / double(totalTime) : 0.;
+	run.lines.emplace_back(string_makePrintf<1024>("# %s: %u frames, load %.2fms, avg %.3fms, max %.3fms, %.2f fps, %u mismatches, on instance",
+		rom, frames, double(loadTime) * 1000., avgMSecs, double(maxTime) * 1000., fps, mismatches).data());
+	run.json = "{\"rom\":" + jsonString(rom) + ",\"system\":" + jsonString(EmuSystem::shortSystemName());
+	run.json += string_makePrintf<256>(",\"frames\":%u,\"loadMs\":%.2f,\"avgMs\":%.3f,\"maxMs\":%.3f,"
+		"\"fps\":%.2f,\"mismatches\":%u,\"instance\":true}\n",
+		frames, double(loadTime) * 1000., avgMSecs, double(maxTime) * 1000., fps, mismatches).data();
+	logMsg("%s: %u frames at %.2f fps on instance, %u mismatches", rom, frames, fps, mismatches);
+	run.failed = mismatches;
+	return run;
+}
+
+uint RegressionFarm::parseArgs(int argc, char **argv, Config &config)
+{
+	if(argc < 3 || !string_equal(argv[1], "--regress"))
+		return 0;
+	config.manifestPath = argv[2];
+	int arg = 3;
+	for(; arg + 1 < argc; arg += 2)
+	{
+		auto name = argv[arg];
+		auto val = argv[arg + 1];
+		if(string_equal(name, "--baseline"))
+			config.baselinePath = strlen(val) ? val : nullptr;
+		else if(string_equal(name, "--results"))
+			config.resultsPath = val;
+		else if(string_equal(name, "--save-dir"))
+			config.saveDir = val;
+		else if(string_equal(name, "--json"))
+			config.jsonPath = strlen(val) ? val : nullptr;
+		else if(string_equal(name, "--memory-budget"))
+			config.memoryBudgetMiB = strtoul(val, nullptr, 10);
+		else if(string_equal(name, "--threads"))
+			config.threads = std::max(1ul, strtoul(val, nullptr, 10));
+		else if(string_equal(name, "--checkpoint"))
+			config.checkpointInterval = std::max(1ul, strtoul(val, nullptr, 10));
+		else if(string_equal(name, "--shard"))
+		{
+			if(sscanf(val, "%u/%u", &config.shard, &config.shards) != 2 || config.shard >= config.shards)
+			{
+				logErr("invalid shard:%s", val);
+				config.shard = 0;
+				config.shards = 1;
+			}
+		}
+		else
+			break;
+	}
+	return arg;
+}
+
+uint RegressionFarm::run(Config config)
+{
+	auto manifest = readManifest(config.manifestPath);
+	if(manifest.empty())
+	{
+		logErr("no games in manifest:%s", config.manifestPath);
+		return 1;
+	}
+	std::unordered_map<std::string, uint32> baseline;
+	if(config.baselinePath)
+		baseline = readBaseline(config.baselinePath);
+	FileIO results;
+	results.create(config.resultsPath);
+	if(!results)
+	{
+		logErr("error creating results:%s", config.resultsPath ? config.resultsPath : "(none)");
+		return 1;
+	}
+	FileIO json;
+	if(config.jsonPath)
+	{
+		json.create(config.jsonPath);
+		if(!json)
+			logErr("error creating JSON output:%s", config.jsonPath);
+	}
+	if(config.memoryBudgetMiB)
+		MemoryStats::setBudget((size_t)config.memoryBudgetMiB * 1024 * 1024);
+	// keep battery saves of the user and of previous runs out of the results
+	auto prevSavePath = EmuSystem::savePath_;
+	if(config.saveDir)
+	{
+		FS::create_directory(config.saveDir);
+		string_copy(EmuSystem::savePath_, config.saveDir);
+	}
+	uint failures = 0, gamesRun = 0;
+	// games without a movie can run on instances in parallel with the app's machine
+	std::vector<bool> onInstance(manifest.size());
+	std::vector<uint> instanceGames;
+	if(EmuSystem::hasInstances && config.threads > 1)
+	{
+		for(uint i = config.shard; i < manifest.size(); i += config.shards)
+		{
+			if(manifest[i].moviePath.empty() && !EmuApp::hasArchiveExtension(manifest[i].romPath.c_str()))
+			{
+				onInstance[i] = true;
+				instanceGames.push_back(i);
+			}
+		}
+	}
+	std::vector<InstanceRun> instanceRuns(instanceGames.size());
+	std::atomic_uint nextInstanceGame{};
+	auto runInstanceGames =
+		[&]()
+		{
+			for(uint n; (n = nextInstanceGame++) < instanceGames.size();)
+			{
+				instanceRuns[n] = runOnInstance(manifest[instanceGames[n]], config.checkpointInterval, baseline);
+			}
+		};
+	std::vector<IG::thread> workers;
+	iterateTimes(std::min(config.threads - 1, (uint)instanceGames.size()), t)
+	{
+		workers.emplace_back(runInstanceGames);
+	}
+	for(uint i = config.shard; i < manifest.size(); i += config.shards)
+	{
+		if(onInstance[i])
+			continue;
+		auto &entry = manifest[i];
+		auto rom = entry.romPath.c_str();
+		gamesRun++;
+		auto loadTime = IG::timeFunc(
+			[&]()
+			{
+				if(auto err = EmuSystem::loadGameFromPath(rom, {});
+					err)
+				{
+					logErr("%s: %s", rom, err->what());
+					writeLine(results, "# %s: load error: %s", rom, err->what());
+				}
+			});
+		if(!EmuSystem::gameIsRunning())
+		{
+			failures++;
+			continue;
+		}
+		EmuSystem::prepareAudioVideo();
+		uint frames = entry.frames;
+		if(entry.moviePath.size())
+		{
+			if(auto err = InputMovie::startPlayback(entry.moviePath.c_str());
+				err)
+			{
+				writeLine(results, "# %s: movie error: %s", rom, err->what());
+				EmuSystem::closeGame(false);
+				failures++;
+				continue;
+			}
+			if(!frames)
+				frames = InputMovie::frames();
+		}
+		InputMovie::clearInputBuffers();
+		IG::Time totalTime{}, maxTime{};
+		uint mismatches = 0;
+		iterateTimes(frames, f)
+		{
+			uint frame = f + 1;
+			hashingFrame = frame % config.checkpointInterval == 0 || frame == frames;
+			frameHash = 0;
+			auto time = IG::timeFunc(
+				[]()
+				{
+					InputMovie::startFrame();
+					EmuSystem::runFrame(emuVideo, false, true, false);
+				});
+			totalTime += time;
+			maxTime = std::max(maxTime, time);
+			if(!hashingFrame)
+				continue;
+			hashingFrame = false;
+			writeLine(results, "%s\t%u\t%08X", rom, frame, frameHash);
+			if(isMismatch(baseline, rom, frame, frameHash, mismatches))
+				mismatches++;
+		}
+		MemoryStats::sampleSteadyState();
+		auto memReport = MemoryStats::report();
+		EmuSystem::closeGame(false);
+		double avgMSecs = frames ? double(totalTime) * 1000. / frames : 0.;
+		writeLine(results, "# %s: %u frames, load %.2fms, avg %.3fms, max %.3fms, %.2f fps, %u mismatches, peak RSS %.1fMiB%s",
+			rom, frames, double(loadTime) * 1000., avgMSecs, double(maxTime) * 1000.,
+			frames ? frames / double(totalTime) : 0., mismatches, memReport.peakRSS() / (1024. * 1024.),
+			memReport.overBudget() ? " over budget" : "");
+		if(json)
+		{
+			auto line = "{\"rom\":" + jsonString(rom) + ",\"system\":" + jsonString(EmuSystem::shortSystemName());
+			auto timing = string_makePrintf<256>(",\"frames\":%u,\"loadMs\":%.2f,\"avgMs\":%.3f,\"maxMs\":%.3f,"
+				"\"fps\":%.2f,\"mismatches\":%u,\"memory\":",
+				frames, double(loadTime) * 1000., avgMSecs, double(maxTime) * 1000.,
+				frames ? frames / double(totalTime) : 0., mismatches);
+			line += timing.data();
+			line += MemoryStats::toJSON(memReport);
+			line += "}\n";
+			json.write(line.data(), line.size());
+		}
+		if(memReport.overBudget())
+			logWarn("%s: peak RSS %zuKiB over budget", rom, memReport.peakRSS() / 1024);
+		logMsg("%s: %u frames at %.2f fps, %u mismatches", rom, frames,
+			frames ? frames / double(totalTime) : 0., mismatches);
+		if(mismatches)
+			failures++;
+	}
+	// help the workers with any instance games left, then write their output in manifest order
+	runInstanceGames();
+	for(auto &w : workers)
+	{
+		w.join();
+	}
+	for(auto &run : instanceRuns)
+	{
+		gamesRun++;
+		for(auto &line : run.lines)
+		{
+			writeLine(results, "%s", line.c_str());
+		}
+		if(json && run.json.size())
+			json.write(run.json.data(), run.json.size());
+		if(run.failed)
+			failures++;
+	}
+	EmuSystem::savePath_ = prevSavePath;
+	logMsg("shard %u/%u ran %u games with %u failures", config.shard, config.shards, gamesRun, failures);
+	return failures;
+}
+
+bool RegressionFarm::isHashingFrame()
+{
+	return hashingFrame;
+}
+
+void RegressionFarm::hashFrame(IG::Pixmap pix)
+{
+	frameHash = pixmapHash(pix);
+}
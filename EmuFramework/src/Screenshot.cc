@@ -13,9 +13,11 @@
 	You should have received a copy of the GNU General Public License
 	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
 
+#define LOGTAG "Screenshot"
 #include <emuframework/Screenshot.hh>
 #include <emuframework/EmuSystem.hh>
 #include <imagine/logger/logger.h>
+#include <imagine/thread/Thread.hh>
 #include <imagine/data-type/image/sys.hh>
 #include <imagine/pixmap/Pixmap.hh>
 #include <imagine/io/FileIO.hh>
@@ -23,7 +25,7 @@
 
 #ifdef CONFIG_DATA_TYPE_IMAGE_QUARTZ2D
 
-bool writeScreenshot(const IG::Pixmap &vidPix, const char *fname)
+bool writeScreenshot(const IG::Pixmap &vidPix, const char *fname, int compressionLevel)
 {
 	auto screen = vidPix.pixel({});
 	IG::MemPixmap tempPix{{vidPix.size(), IG::PIXEL_FMT_RGB888}};
@@ -60,7 +62,7 @@ extern jobject jBaseActivity;
 
 }
 
-bool writeScreenshot(const IG::Pixmap &vidPix, const char *fname)
+bool writeScreenshot(const IG::Pixmap &vidPix, const char *fname, int compressionLevel)
 {
 	static JavaInstMethod<jobject(jint, jint, jint)> jMakeBitmap;
 	static JavaInstMethod<jboolean(jobject, jobject)> jWritePNG;
@@ -117,7 +119,7 @@ static void png_ioFlush(png_structp pngPtr)
 	logMsg("called png_ioFlush");
 }
 
-bool writeScreenshot(const IG::Pixmap &vidPix, const char *fname)
+bool writeScreenshot(const IG::Pixmap &vidPix, const char *fname, int compressionLevel)
 {
 	FileIO fp;
 	fp.create(fname);
@@ -151,6 +153,8 @@ bool writeScreenshot(const IG::Pixmap &vidPix, const char *fname)
 	uint imgheight = vidPix.h();
 
 	png_set_write_fn(pngPtr, &fp, png_ioWriter, png_ioFlush);
+	if(compressionLevel >= 0)
+		png_set_compression_level(pngPtr, compressionLevel);
 	png_set_IHDR(pngPtr, infoPtr, imgwidth, imgheight, 8,
 		PNG_COLOR_TYPE_RGB,
 		PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
@@ -197,11 +201,11 @@ bool writeScreenshot(const IG::Pixmap &vidPix, const char *fname)
 
 #endif
 
-int sprintScreenshotFilename(FS::PathString &str)
+int sprintScreenshotFilename(FS::PathString &str, int startNum)
 {
-	const uint maxNum = 999;
+	const int maxNum = 999;
 	int num = -1;
-	iterateTimes(maxNum, i)
+	for(int i = startNum; i < maxNum; i++)
 	{
 		string_printf(str, "%s/%s.%.3d.png", EmuSystem::savePath(), EmuSystem::gameName().data(), i);
 		if(!FS::exists(str))
@@ -218,3 +222,93 @@ int sprintScreenshotFilename(FS::PathString &str)
 	logMsg("screenshot %d", num);
 	return num;
 }
+
+void ScreenshotWriter::setOnWrite(OnWriteDelegate del)
+{
+	onWrite = del;
+}
+
+ScreenshotWriter::Job *ScreenshotWriter::freeJob()
+{
+	for(auto &j : job)
+	{
+		if(!j.inUse)
+			return &j;
+	}
+	return nullptr;
+}
+
+bool ScreenshotWriter::write(IG::Pixmap pix, const FS::PathString &path, int num, int compressionLevel)
+{
+	#ifdef CONFIG_DATA_TYPE_IMAGE_ANDROID
+	// writer needs the main thread's JNIEnv
+	bool success = writeScreenshot(pix, path.data(), compressionLevel);
+	if(onWrite)
+		onWrite(num, success);
+	return true;
+	#else
+	auto j = freeJob();
+	if(!j)
+	{
+		logWarn("no free buffer for screenshot #%d", num);
+		return false;
+	}
+	if((IG::PixmapDesc)j->pix != (IG::PixmapDesc)pix)
+	{
+		j->pix = IG::MemPixmap{pix};
+	}
+	j->pix.write(pix);
+	j->path = path;
+	j->num = num;
+	j->compressionLevel = compressionLevel;
+	j->inUse = true;
+	if(!workerRunning)
+		startWorker();
+	queue[queueWritePos] = j - job.data();
+	queueWritePos = (queueWritePos + 1) % MAX_QUEUED;
+	queueSem.notify();
+	return true;
+	#endif
+}
+
+bool ScreenshotWriter::hasPendingWrites() const
+{
+	for(auto &j : job)
+	{
+		if(j.inUse)
+			return true;
+	}
+	return false;
+}
+
+void ScreenshotWriter::startWorker()
+{
+	resultPipe.init({},
+		[this](Base::Pipe &pipe)
+		{
+			while(pipe.hasData())
+			{
+				Result result;
+				pipe.read(&result, sizeof(result));
+				if(onWrite)
+					onWrite(result.num, result.success);
+			}
+			return 0;
+		});
+	IG::makeDetachedThread(
+		[this]()
+		{
+			// only this thread reads the queue, the semaphore counts entries ready to read
+			uint queueReadPos = 0;
+			while(1)
+			{
+				queueSem.wait();
+				auto &j = job[queue[queueReadPos]];
+				queueReadPos = (queueReadPos + 1) % MAX_QUEUED;
+				Result result{j.num, writeScreenshot(j.pix, j.path.data(), j.compressionLevel)};
+				j.inUse = false;
+				resultPipe.write(&result, sizeof(result));
+			}
+		});
+	workerRunning = true;
+}
@@ -0,0 +1,132 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+
+#define LOGTAG "Startup"
+#include <emuframework/StartupProfiler.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/utility.h>
+#include <array>
+#include <cstdio>
+
+static IG::Time startTime{};
+static std::array<IG::Time, StartupProfiler::PHASES> endTime{};
+static bool finished = false;
+
+static const char *phaseName[StartupProfiler::PHASES]
+{
+	"Options", "Renderer", "Fonts", "Window", "Game Load", "First Frame"
+};
+
+static const char *phaseKey[StartupProfiler::PHASES]
+{
+	"options", "renderer", "fonts", "window", "gameLoad", "firstFrame"
+};
+
+static IG::Time phaseStart(StartupProfiler::Phase p)
+{
+	// a phase starts where the last one that ran before it ended
+	for(int i = (int)p - 1; i >= 0; i--)
+	{
+		if(endTime[i])
+			return endTime[i];
+	}
+	return startTime;
+}
+
+void StartupProfiler::start()
+{
+	startTime = IG::Time::now();
+	endTime = {};
+	finished = false;
+}
+
+void StartupProfiler::mark(Phase p)
+{
+	assert(p < PHASES);
+	if(finished || !startTime)
+		return;
+	endTime[p] = IG::Time::now();
+}
+
+void StartupProfiler::finish()
+{
+	if(finished || !startTime)
+		return;
+	finished = true;
+	iterateTimes(PHASES, i)
+	{
+		auto p = (Phase)i;
+		if(phaseRan(p))
+			logMsg("%s: %.3fs", phaseKey[i], double(phaseTime(p)));
+		else
+			logMsg("%s: skipped", phaseKey[i]);
+	}
+	logMsg("total: %.3fs", double(total()));
+	logMsg("startup:%s", toJSON().c_str());
+}
+
+bool StartupProfiler::isFinished()
+{
+	return finished;
+}
+
+IG::Time StartupProfiler::phaseTime(Phase p)
+{
+	assert(p < PHASES);
+	if(!phaseRan(p))
+		return {};
+	return endTime[p] - phaseStart(p);
+}
+
+bool StartupProfiler::phaseRan(Phase p)
+{
+	assert(p < PHASES);
+	return (bool)endTime[p];
+}
+
+IG::Time StartupProfiler::total()
+{
+	for(int i = PHASES - 1; i >= 0; i--)
+	{
+		if(endTime[i])
+			return endTime[i] - startTime;
+	}
+	return {};
+}
+
+const char *StartupProfiler::name(Phase p)
+{
+	assert(p < PHASES);
+	return phaseName[p];
+}
+
+std::string StartupProfiler::toJSON()
+{
+	std::string json{"{"};
+	std::array<char, 64> str;
+	iterateTimes(PHASES, i)
+	{
+		auto p = (Phase)i;
+		if(!phaseRan(p))
+			continue;
+		snprintf(str.data(), str.size(), "\"%s\":%.4f,", phaseKey[i], double(phaseTime(p)));
+		json += str.data();
+	}
+	snprintf(str.data(), str.size(), "\"total\":%.4f}", double(total()));
+	json += str.data();
+	return json;
+}
@@ -0,0 +1,209 @@
+/*  This file is part of EmuFramework.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with EmuFramework.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "StateHash"
+#include <emuframework/StateHash.hh>
+#include <emuframework/EmuSystem.hh>
+#include <emuframework/EmuApp.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/hash.hh>
+#include <imagine/util/ScopeGuard.hh>
+#include <cstring>
+#include <vector>
+
+struct TrackHeader
+{
+	static constexpr char MAGIC[8]{'E', 'M', 'U', 'S', 'T', 'H', 'S', 'H'};
+
+	char magic[8]{};
+	uint32 interval = 0;
+	uint32 entries = 0;
+};
+
+struct TrackEntry
+{
+	uint32 frame;
+	uint32 hash;
+};
+
+struct HashRegion
+{
+	const void *data;
+	size_t size;
+};
+
+enum class Mode : uint8 { OFF, RECORD, CHECK };
+
+constexpr char TrackHeader::MAGIC[8];
+static std::vector<HashRegion> region{};
+static Mode mode = Mode::OFF;
+static uint interval = 0;
+static std::vector<TrackEntry> track{};
+static uint nextEntry = 0;
+static int divergentFrame = -1;
+static bool inOnFrame = false;
+
+void StateHash::addRegion(const void *data, size_t size)
+{
+	region.push_back({data, size});
+}
+
+void StateHash::clearRegions()
+{
+	region.clear();
+}
+
+static uint32 hashSaveState()
+{
+	// reused between frames, cores with hasMemoryStates fill it without a file
+	static EmuSystem::MemoryState state{};
+	if(auto err = EmuSystem::saveStateToMemory(state);
+		err)
+	{
+		logErr("error saving state to hash: %s", err->what());
+		return 0;
+	}
+	return IG::crc32c(state.data(), state.size());
+}
+
+uint32 StateHash::hashState()
+{
+	if(!region.size())
+		return hashSaveState();
+	uint32 crc = 0;
+	for(auto &r : region)
+	{
+		crc = IG::crc32c(r.data, r.size, crc);
+	}
+	return crc;
+}
+
+void StateHash::startRecording(uint interval_)
+{
+	assert(interval_);
+	mode = Mode::RECORD;
+	interval = interval_;
+	track.clear();
+	divergentFrame = -1;
+	logMsg("recording hash every %u frames using %s", interval,
+		region.size() ? "RAM regions" : "save states");
+}
+
+bool StateHash::startChecking(const char *trackPath)
+{
+	stop();
+	FileIO file;
+	file.open(trackPath);
+	if(!file)
+		return false;
+	TrackHeader header;
+	if(file.read(&header, sizeof(header)) != sizeof(header)
+		|| memcmp(header.magic, TrackHeader::MAGIC, sizeof(header.magic)) != 0
+		|| !header.interval)
+	{
+		logErr("invalid hash track:%s", trackPath);
+		return false;
+	}
+	track.resize(header.entries);
+	if(file.read(track.data(), header.entries * sizeof(TrackEntry)) != (ssize_t)(header.entries * sizeof(TrackEntry)))
+	{
+		logErr("truncated hash track:%s", trackPath);
+		track.clear();
+		return false;
+	}
+	mode = Mode::CHECK;
+	interval = header.interval;
+	nextEntry = 0;
+	divergentFrame = -1;
+	logMsg("checking %u hashes from:%s", header.entries, trackPath);
+	return true;
+}
+
+void StateHash::onFrame(uint frame)
+{
+	if(likely(mode == Mode::OFF) || frame % interval)
+		return;
+	// saving a state may run frames in some cores, don't hash recursively
+	if(inOnFrame)
+		return;
+	inOnFrame = true;
+	auto resetInOnFrame = IG::scopeGuard([](){ inOnFrame = false; });
+	if(mode == Mode::RECORD)
+	{
+		track.push_back({frame, hashState()});
+		return;
+	}
+	if(nextEntry == track.size())
+		return;
+	auto &entry = track[nextEntry];
+	if(entry.frame != frame)
+		return;
+	nextEntry++;
+	auto hash = hashState();
+	if(hash != entry.hash)
+	{
+		divergentFrame = frame;
+		logErr("state diverged at frame %u, hash 0x%X != 0x%X", frame, hash, entry.hash);
+		EmuApp::printfMessage(6, true, "State diverged from movie at frame %u", frame);
+		// later frames will differ too, only the first divergence is useful
+		stop();
+	}
+}
+
+bool StateHash::writeTrack(const char *trackPath)
+{
+	if(mode != Mode::RECORD)
+		return false;
+	TrackHeader header;
+	memcpy(header.magic, TrackHeader::MAGIC, sizeof(header.magic));
+	header.interval = interval;
+	header.entries = track.size();
+	FileIO file;
+	file.create(trackPath);
+	if(!file)
+	{
+		logErr("error creating hash track:%s", trackPath);
+		return false;
+	}
+	file.write(&header, sizeof(header));
+	file.write(track.data(), track.size() * sizeof(TrackEntry));
+	logMsg("wrote %u hashes to:%s", (uint)track.size(), trackPath);
+	return true;
+}
+
+void StateHash::stop()
+{
+	if(mode == Mode::CHECK && divergentFrame == -1)
+		logMsg("%u hashes matched", nextEntry);
+	mode = Mode::OFF;
+	track.clear();
+	track.shrink_to_fit();
+}
+
+bool StateHash::isChecking()
+{
+	return mode == Mode::CHECK;
+}
+
+int StateHash::firstDivergentFrame()
+{
+	return divergentFrame;
+}
+
+uint StateHash::hashesChecked()
+{
+	return nextEntry;
+}
@@ -17,6 +17,7 @@
 #include <emuframework/VController.hh>
 #include <emuframework/EmuApp.hh>
 #include <emuframework/EmuOptions.hh>
+#include <emuframework/InputMovie.hh>
 #include <imagine/util/algorithm.h>
 #include <imagine/util/math/int.hh>
 #include "private.hh"
@@ -650,6 +651,14 @@ void VControllerGamepad::draw(Gfx::Renderer &r, bool showHidden) const
 	}
 }
 
+bool VControllerGamepad::hasVisibleElements() const
+{
+	if(dp.state == 1 || faceBtnsState == 1 || centerBtnsState == 1)
+		return true;
+	return EmuSystem::inputHasTriggerBtns && !triggersInline
+		&& (lTriggerState == 1 || rTriggerState == 1);
+}
+
 Gfx::GC VController::xMMSize(Gfx::GC mm) const
 {
 	return useScaledCoordinates ? mainWin.projectionPlane.xSMMSize(mm) : mainWin.projectionPlane.xMMSize(mm);
@@ -731,7 +740,7 @@ void VController::inputAction(uint action, uint vBtn)
 	if(isInKeyboardMode())
 	{
 		assert(vBtn < IG::size(kbMap));
-		EmuSystem::handleInputAction(action, kbMap[vBtn]);
+		InputMovie::sendInputAction(action, kbMap[vBtn]);
 	}
 	else
 	{
@@ -749,7 +758,7 @@ void VController::inputAction(uint action, uint vBtn)
 				turboActions.removeEvent(keyCode);
 			}
 		}
-		EmuSystem::handleInputAction(action, keyCode);
+		InputMovie::sendInputAction(action, keyCode);
 	}
 }
 
@@ -926,6 +935,19 @@ void VController::draw(bool emuSystemControls, bool activeFF, bool showHidden, f
 	}
 }
 
+bool VController::hasVisibleElements(bool emuSystemControls) const
+{
+	if(alpha == 0.)
+		return false;
+	if(isInKeyboardMode() || menuBtnState == 1 || ffBtnState == 1)
+		return true;
+	#ifdef CONFIG_VCONTROLS_GAMEPAD
+	return emuSystemControls && gp.hasVisibleElements();
+	#else
+	return false;
+	#endif
+}
+
 int VController::numElements() const
 {
 	#ifdef CONFIG_VCONTROLS_GAMEPAD
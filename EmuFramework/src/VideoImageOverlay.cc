@@ -56,9 +56,19 @@ alignas(8) static uint32 crtRgbPixmapBuff[] =
 };
 #undef CONV_COL
 
-void VideoImageOverlay::setEffect(Gfx::Renderer &r, uint effect)
+void VideoImageOverlay::setEffect(uint effect)
 {
+	if(effect == this->effect)
+		return;
 	this->effect = effect;
+	// the texture is made on the next place() so an overlay that's only
+	// configured doesn't cost anything until a game is shown
+	spr.deinit();
+	img.deinit();
+}
+
+void VideoImageOverlay::initTexture(Gfx::Renderer &r)
+{
 	IG::Pixmap pix;
 	switch(effect)
 	{
@@ -68,9 +78,7 @@ void VideoImageOverlay::setEffect(Gfx::Renderer &r, uint effect)
 			pix = {{{8, 8}, IG::PIXEL_IA88}, crtPixmapBuff};
 		bcase CRT_RGB ... CRT_RGB_2:
 			pix = {{{16, 2}, IG::PIXEL_RGBA8888}, crtRgbPixmapBuff};
-		bdefault: // turn off effect
-			spr.deinit();
-			img.deinit();
+		bdefault:
 			return;
 	}
 	Gfx::TextureSampler::initDefaultNearestMipRepeatSampler(r);
@@ -83,8 +91,10 @@ void VideoImageOverlay::setEffect(Gfx::Renderer &r, uint effect)
 	spr.compileDefaultProgramOneShot(Gfx::IMG_MODE_MODULATE);
 }
 
-void VideoImageOverlay::place(const Gfx::Sprite &disp, uint lines)
+void VideoImageOverlay::place(Gfx::Renderer &r, const Gfx::Sprite &disp, uint lines)
 {
+	if(effect != NO_EFFECT && !spr.image())
+		initTexture(r);
 	if(spr.image())
 	{
 		using namespace Gfx;
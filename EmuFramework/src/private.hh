@@ -78,6 +78,7 @@ void startViewportAnimation(AppWindowData &winData);
 bool showAutoStateConfirm(Gfx::Renderer &r, Input::Event e, bool addToRecent);
 void onMainMenuItemOptionChanged();
 void placeEmuViews();
+void updateSoftwarePresent();
 void placeElements();
 void loadGameCompleteFromBenchmarkFilePicker(uint result, Input::Event e);
 void onSelectFileFromPicker(Gfx::Renderer &r, const char* name, Input::Event e);
@@ -16,12 +16,17 @@
 #define LOGTAG "main"
 #include <emuframework/EmuApp.hh>
 #include <emuframework/EmuAppInlines.hh>
+#include <emuframework/BackupMemory.hh>
+#include <emuframework/StateHash.hh>
+#include <emuframework/CheatSearch.hh>
 #include "internal.hh"
 #include "Cheats.hh"
 #include <vbam/gba/GBA.h>
 #include <vbam/gba/GBAGfx.h>
 #include <vbam/gba/Sound.h>
 #include <vbam/gba/RTC.h>
+#include <vbam/gba/Flash.h>
+#include <vbam/gba/EEprom.h>
 #include <vbam/common/SoundDriver.h>
 #include <vbam/common/Patch.h>
 #include <vbam/Util.h>
@@ -31,6 +36,7 @@ void CPULoop(GBASys &gba, EmuVideo &video, bool renderGfx, bool processGfx, bool
 void CPUCleanUp();
 bool CPUReadBatteryFile(GBASys &gba, const char *);
 bool CPUWriteBatteryFile(GBASys &gba, const char *);
+const u8 *CPUBatteryMemory(GBASys &gba, int &size);
 bool CPUReadState(GBASys &gba, const char *);
 bool CPUWriteState(GBASys &gba, const char *);
 
@@ -38,6 +44,7 @@ bool detectedRtcGame = 0;
 const char *EmuSystem::creditsViewStr = CREDITS_INFO_STRING "(c) 2012-2014\nRobert Broglia\nwww.explusalpha.com\n\nPortions (c) the\nVBA-m Team\nvba-m.com";
 bool EmuSystem::hasBundledGames = true;
 bool EmuSystem::hasCheats = true;
+bool EmuSystem::hasMemoryStates = true;
 
 EmuSystem::NameFilterFunc EmuSystem::defaultFsFilter =
 	[](const char *name)
@@ -108,6 +115,26 @@ EmuSystem::Error EmuSystem::loadState(const char *path)
 		return makeFileReadError();
 }
 
+EmuSystem::Error EmuSystem::saveStateToMemory(MemoryState &data)
+{
+	static constexpr uint maxStateSize = 0x100000;
+	data.resize(maxStateSize);
+	// uncompressed since rollback saves every frame
+	auto size = CPUWriteMemState(gGba, (char*)data.data(), data.size(), 0);
+	if(!size)
+		return makeError("State is too large");
+	data.resize(size);
+	return {};
+}
+
+EmuSystem::Error EmuSystem::loadStateFromMemory(const uint8 *data, size_t size)
+{
+	if(CPUReadMemState(gGba, (char*)data, size))
+		return {};
+	else
+		return makeError("Invalid state data");
+}
+
 void EmuSystem::saveBackupMem()
 {
 	if(gameIsRunning())
@@ -130,32 +157,24 @@ void EmuSystem::closeSystem()
 	cheatsNumber = 0; // reset cheat list
 }
 
-static EmuSystem::Error applyGamePatches(const char *patchDir, const char *romName, u8 *rom, int &romSize)
+static void snapshotBackupMem(BackupMemory::Snapshot &snapshot)
 {
-	auto patchStr = FS::makePathStringPrintf("%s/%s.ips", patchDir, romName);
-	if(FS::exists(patchStr.data()))
+	int size;
+	if(auto data = CPUBatteryMemory(gGba, size);
+		data)
 	{
-		logMsg("applying IPS patch: %s", patchStr.data());
-		if(!patchApplyIPS(patchStr.data(), &rom, &romSize))
-		{
-			return EmuSystem::makeError("Error applying IPS patch");
-		}
-		return {};
-	}
-	string_printf(patchStr, "%s/%s.ups", patchDir, romName);
-	if(FS::exists(patchStr.data()))
-	{
-		logMsg("applying UPS patch: %s", patchStr.data());
-		if(!patchApplyUPS(patchStr.data(), &rom, &romSize))
-		{
-			return EmuSystem::makeError("Error applying UPS patch");
-		}
-		return {};
+		snapshot.write(FS::makePathStringPrintf("%s/%s.sav", EmuSystem::savePath(), EmuSystem::gameName().data()),
+			data, size);
 	}
-	string_printf(patchStr, "%s/%s.ppf", patchDir, romName);
+}
+
+// IPS, UPS, and BPS patches are applied by the framework as the ROM is read
+static EmuSystem::Error applyGamePatches(const char *patchDir, const char *romName, u8 *rom, int &romSize)
+{
+	auto patchStr = FS::makePathStringPrintf("%s/%s.ppf", patchDir, romName);
 	if(FS::exists(patchStr.data()))
 	{
-		logMsg("applying UPS patch: %s", patchStr.data());
+		logMsg("applying PPF patch: %s", patchStr.data());
 		if(!patchApplyPPF(patchStr.data(), &rom, &romSize))
 		{
 			return EmuSystem::makeError("Error applying PPF patch");
@@ -183,6 +202,16 @@ EmuSystem::Error EmuSystem::loadGame(IO &io, OnLoadProgressDelegate)
 	auto saveStr = FS::makePathStringPrintf("%s/%s.sav", EmuSystem::savePath(), EmuSystem::gameName().data());
 	CPUReadBatteryFile(gGba, saveStr.data());
 	readCheatFile();
+	BackupMemory::watch(flashSaveMemory, sizeof(flashSaveMemory));
+	BackupMemory::watch(eepromData, sizeof(eepromData));
+	BackupMemory::setOnSnapshot(snapshotBackupMem);
+	StateHash::addRegion(gGba.mem.workRAM, sizeof(gGba.mem.workRAM));
+	StateHash::addRegion(gGba.mem.internalRAM, sizeof(gGba.mem.internalRAM));
+	StateHash::addRegion(gGba.lcd.vram, sizeof(gGba.lcd.vram));
+	StateHash::addRegion(gGba.lcd.paletteRAM, sizeof(gGba.lcd.paletteRAM));
+	StateHash::addRegion(gGba.lcd.oam, sizeof(gGba.lcd.oam));
+	CheatSearch::addRegion("WRAM", gGba.mem.workRAM, sizeof(gGba.mem.workRAM));
+	CheatSearch::addRegion("IRAM", gGba.mem.internalRAM, sizeof(gGba.mem.internalRAM));
 	return {};
 }
 
@@ -191,7 +220,7 @@ void EmuSystem::onPrepareVideo(EmuVideo &video)
 	video.setFormat({{240, 160}, pixFmt});
 }
 
-void systemDrawScreen(EmuVideo &video)
+void systemDrawScreen(EmuVideo &video, bool renderGfx)
 {
 	auto img = video.startFrame();
 	IG::Pixmap framePix{{{240, 160}, IG::PIXEL_RGB565}, gGba.lcd.pix};
@@ -204,7 +233,8 @@ void systemDrawScreen(EmuVideo &video)
 		img.pixmap().write(framePix);
 	}
 	img.endFrame();
-	EmuApp::updateAndDrawEmuVideo();
+	if(renderGfx)
+		EmuApp::updateAndDrawEmuVideo();
 }
 
 void systemOnWriteDataToSoundBuffer(const u16 * finalWave, int length)
@@ -270,13 +270,17 @@ local gzFile gz_open (memory, available, mode)
 	  strategy = Z_FILTERED;
 	} else if (*p == 'h') {
 	  strategy = Z_HUFFMAN_ONLY;
+	} else if (*p == 'T') {
+	  s->transparent = 1; /* write uncompressed, as in zlib's gzopen */
 	} else {
 	    *m++ = *p; /* copy the mode */
 	}
     } while (*p++ && m != fmode + sizeof(fmode));
     if (s->mode == '\0') return destroy(s), (gzFile)Z_NULL;
 
-    if (s->mode == 'w') {
+    if (s->mode == 'w' && s->transparent) {
+        /* no deflate state or header, the reader sees no gzip magic and copies the data as is */
+    } else if (s->mode == 'w') {
 #ifdef NO_DEFLATE
         err = Z_STREAM_ERROR;
 #else
@@ -312,7 +316,9 @@ local gzFile gz_open (memory, available, mode)
         return destroy(s), (gzFile)Z_NULL;
     }
 
-    if (s->mode == 'w') {
+    if (s->mode == 'w' && s->transparent) {
+	s->startpos = 0L;
+    } else if (s->mode == 'w') {
         /* Write a very simple .gz header:
          */
         memPrintf(s->file, "%c%c%c%c%c%c%c%c%c%c", gz_magic[0], gz_magic[1],
@@ -568,6 +574,12 @@ int ZEXPORT memgzwrite (file, buf, len)
 
     if (s == NULL || s->mode != 'w') return Z_STREAM_ERROR;
 
+    if (s->transparent) {
+        len = (unsigned)memWrite(buf, 1, len, s->file);
+        s->stream.total_in += len;
+        return (int)len;
+    }
+
     s->stream.next_in = (Bytef*)buf;
     s->stream.avail_in = len;
 
@@ -677,7 +689,7 @@ int ZEXPORT memgzclose (file)
 
     if (s == NULL) return Z_STREAM_ERROR;
 
-    if (s->mode == 'w') {
+    if (s->mode == 'w' && !s->transparent) {
 #ifdef NO_DEFLATE
 	return Z_STREAM_ERROR;
 #else
@@ -783,12 +783,14 @@ bool CPUWriteState(GBASys &gba, const char *file)
   return res;
 }
 
-bool CPUWriteMemState(GBASys &gba, char *memory, int available)
+long CPUWriteMemState(GBASys &gba, char *memory, int available, int level)
 {
-  gzFile gzFile = utilMemGzOpen(memory, available, "w");
+  // level 0 skips deflate and writes the state as is
+  char mode[3] = {'w', level == 0 ? 'T' : level > 0 ? (char)('0' + level) : '\0', '\0'};
+  gzFile gzFile = utilMemGzOpen(memory, available, mode);
 
   if(gzFile == NULL) {
-    return false;
+    return 0;
   }
 
   bool res = CPUWriteState(gba, gzFile);
@@ -800,7 +802,13 @@ bool CPUWriteMemState(GBASys &gba, char *memory, int available)
 
   utilGzClose(gzFile);
 
-  return res;
+  if(!res)
+    return 0;
+
+  // the memory stream header holds the final size once closed
+  int size;
+  memcpy(&size, memory + 4, sizeof(size));
+  return size + 8;
 }
 
 static bool CPUReadState(GBASys &gba, gzFile gzFile)
@@ -1034,7 +1042,8 @@ bool CPUExportEepromFile(const char *fileName)
   return true;
 }
 
-bool CPUWriteBatteryFile(GBASys &gba, const char *fileName)
+// returns the memory CPUWriteBatteryFile() saves, or nullptr if none is in use
+const u8 *CPUBatteryMemory(GBASys &gba, int &size)
 {
   if(gbaSaveType == 0) {
     if(eepromInUse)
@@ -1049,7 +1058,23 @@ bool CPUWriteBatteryFile(GBASys &gba, const char *fileName)
     }
   }
 
-  if((gbaSaveType) && (gbaSaveType!=5)) {
+  if(!gbaSaveType || gbaSaveType == 5)
+    return nullptr;
+
+  // only save if Flash/Sram in use or EEprom in use
+  if(gbaSaveType == 3) {
+    size = eepromSize;
+    return eepromData;
+  }
+  size = gbaSaveType == 2 ? flashSize : 0x10000;
+  return flashSaveMemory;
+}
+
+bool CPUWriteBatteryFile(GBASys &gba, const char *fileName)
+{
+  int size;
+  auto data = CPUBatteryMemory(gba, size);
+  if(data) {
     FILE *file = fopen(fileName, "wb");
 
     if(!file) {
@@ -1058,24 +1083,9 @@ bool CPUWriteBatteryFile(GBASys &gba, const char *fileName)
       return false;
     }
 
-    // only save if Flash/Sram in use or EEprom in use
-    if(gbaSaveType != 3) {
-      if(gbaSaveType == 2) {
-        if(fwrite(flashSaveMemory, 1, flashSize, file) != (size_t)flashSize) {
-          fclose(file);
-          return false;
-        }
-      } else {
-        if(fwrite(flashSaveMemory, 1, 0x10000, file) != 0x10000) {
-          fclose(file);
-          return false;
-        }
-      }
-    } else {
-      if(fwrite(eepromData, 1, eepromSize, file) != (size_t)eepromSize) {
-        fclose(file);
-        return false;
-      }
+    if(fwrite(data, 1, size, file) != (size_t)size) {
+      fclose(file);
+      return false;
     }
     fclose(file);
   }
@@ -3461,9 +3471,9 @@ void CPULoop(GBASys &gba, EmuVideo &video, bool renderGfx, bool processGfx, bool
 				#endif
               }*/
             }
-            if(ioMem.VCOUNT == 159 && likely(renderGfx))
+            if(ioMem.VCOUNT == 159 && likely(processGfx))
             {
-            	systemDrawScreen(video);
+            	systemDrawScreen(video, renderGfx);
             }
             // entering H-Blank
             ioMem.DISPSTAT |= 2;
@@ -1025,7 +1025,8 @@ extern void CPUCleanUp();
 extern void CPUUpdateRender(GBASys &gba);
 extern bool CPUReadMemState(GBASys &gba, char *, int);
 extern bool CPUReadState(GBASys &gba, const char *);
-extern bool CPUWriteMemState(GBASys &gba, char *, int);
+// zlib compression level, 0 for none, returns the bytes written or 0 on error
+extern long CPUWriteMemState(GBASys &gba, char *, int, int level = -1);
 extern bool CPUWriteState(GBASys &gba, const char *);
 extern int CPULoadRom(GBASys &gba, const char *);
 extern int CPULoadRomWithIO(GBASys &gba, IO &);
@@ -40,8 +40,10 @@ public:
 		FORCE_DMG        = 1, /**< Treat the ROM as not having CGB support regardless of
 		                           what its header advertises. */
 		GBA_CGB          = 2, /**< Use GBA intial CPU register values when in CGB mode. */
-		MULTICART_COMPAT = 4  /**< Use heuristics to detect and support some multicart
+		MULTICART_COMPAT = 4, /**< Use heuristics to detect and support some multicart
 		                           MBCs disguised as MBC1. */
+		NO_SAVEDATA      = 8  /**< Never read or write persistent cartridge data files,
+		                           cartridge RAM starts out blank. */
 	};
 
 	 /*
@@ -119,6 +121,15 @@ public:
 	/** Writes persistent cartridge data to disk. Done implicitly on ROM close. */
 	void saveSavedata();
 
+	/**
+	  * Returns the battery-backed cartridge RAM written by saveSavedata() and its size,
+	  * or 0 if the cartridge has none.
+	  */
+	unsigned char * savedata(std::size_t &size) const;
+
+	/** Path persistent cartridge data is saved to, without the file extension. */
+	std::string const saveBasePath() const;
+
 	/**
 	  * Saves emulator state to the state slot selected with selectState().
 	  * The data will be stored in the directory given by setSaveDir().
@@ -32,6 +32,7 @@ public:
 	void loadState(SaveState const &state);
 	void loadSavedata() { mem_.loadSavedata(); }
 	void saveSavedata() { mem_.saveSavedata(); }
+	unsigned char * savedata(std::size_t &size) const { return mem_.savedata(size); }
 
 	void setVideoBuffer(PixelType *videoBuf, std::ptrdiff_t pitch) {
 		mem_.setVideoBuffer(videoBuf, pitch);
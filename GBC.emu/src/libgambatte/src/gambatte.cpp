@@ -45,6 +45,8 @@ struct GB::Priv {
 	unsigned loadflags;
 
 	Priv() : stateNo(1), loadflags(0) {}
+
+	bool usesSavedata() const { return cpu.loaded() && !(loadflags & NO_SAVEDATA); }
 };
 
 GB::GB() : p_(new Priv) {}
@@ -77,13 +79,15 @@ std::ptrdiff_t GB::runFor(gambatte::PixelType *const videoBuf, std::ptrdiff_t co
 
 void GB::reset() {
 	if (p_->cpu.loaded()) {
-		p_->cpu.saveSavedata();
+		if (p_->usesSavedata())
+			p_->cpu.saveSavedata();
 
 		SaveState state;
 		p_->cpu.setStatePtrs(state);
 		setInitState(state, p_->cpu.isCgb(), p_->loadflags & GBA_CGB);
 		p_->cpu.loadState(state);
-		p_->cpu.loadSavedata();
+		if (p_->usesSavedata())
+			p_->cpu.loadSavedata();
 	}
 }
 
@@ -96,7 +100,7 @@ void GB::setSaveDir(std::string const &sdir) {
 }
 
 LoadRes GB::load(const void *romdata, std::size_t size, std::string const &romfilename, unsigned const flags) {
-	if (p_->cpu.loaded())
+	if (p_->usesSavedata())
 		p_->cpu.saveSavedata();
 
 	LoadRes const loadres = p_->cpu.load(romdata, size,
@@ -109,7 +113,8 @@ LoadRes GB::load(const void *romdata, std::size_t size, std::string const &romfi
 		p_->loadflags = flags;
 		setInitState(state, p_->cpu.isCgb(), flags & GBA_CGB);
 		p_->cpu.loadState(state);
-		p_->cpu.loadSavedata();
+		if (p_->usesSavedata())
+			p_->cpu.loadSavedata();
 
 		p_->stateNo = 1;
 #ifndef GAMBATTE_NO_OSD
@@ -129,10 +134,18 @@ bool GB::isLoaded() const {
 }
 
 void GB::saveSavedata() {
-	if (p_->cpu.loaded())
+	if (p_->usesSavedata())
 		p_->cpu.saveSavedata();
 }
 
+unsigned char * GB::savedata(std::size_t &size) const {
+	return p_->cpu.loaded() ? p_->cpu.savedata(size) : 0;
+}
+
+std::string const GB::saveBasePath() const {
+	return p_->cpu.saveBasePath();
+}
+
 void GB::setDmgPaletteColor(int palNum, int colorNum, unsigned long rgb32) {
 	p_->cpu.setDmgPaletteColor(palNum, colorNum, rgb32);
 }
@@ -143,7 +156,8 @@ void GB::refreshPalettes() {
 
 bool GB::loadState(std::string const &filepath) {
 	if (p_->cpu.loaded()) {
-		p_->cpu.saveSavedata();
+		if (p_->usesSavedata())
+			p_->cpu.saveSavedata();
 
 		SaveState state;
 		p_->cpu.setStatePtrs(state);
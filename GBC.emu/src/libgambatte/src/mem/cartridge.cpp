@@ -708,6 +708,14 @@ void Cartridge::saveSavedata() {
 	}
 }
 
+unsigned char * Cartridge::savedata(std::size_t &size) const {
+	if (!hasBattery(memptrs_.romdata()[0x147]))
+		return 0;
+
+	size = memptrs_.rambankdataend() - memptrs_.rambankdata();
+	return size ? memptrs_.rambankdata() : 0;
+}
+
 static int asHex(char c) {
 	return c >= 'A' ? c - 'A' + 0xA : c - '0';
 }
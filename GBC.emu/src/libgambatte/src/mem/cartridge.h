@@ -64,6 +64,7 @@ public:
 	unsigned char rtcRead() const { return *rtc_.activeData(); }
 	void loadSavedata();
 	void saveSavedata();
+	unsigned char * savedata(std::size_t &size) const;
 	std::string const saveBasePath() const;
 	void setSaveDir(std::string const &dir);
 	LoadRes loadROM(const void *romdata, std::size_t size, std::string const &romfilename, bool forceDmg, bool multicartCompat);
@@ -43,6 +43,7 @@ public:
 	void loadState(SaveState const &state);
 	void loadSavedata() { cart_.loadSavedata(); }
 	void saveSavedata() { cart_.saveSavedata(); }
+	unsigned char * savedata(std::size_t &size) const { return cart_.savedata(size); }
 	std::string const saveBasePath() const { return cart_.saveBasePath(); }
 
 #ifndef GAMBATTE_NO_OSD
@@ -16,6 +16,8 @@
 #define LOGTAG "main"
 #include <emuframework/EmuApp.hh>
 #include <emuframework/EmuAppInlines.hh>
+#include <emuframework/BackupMemory.hh>
+#include <emuframework/EmuSystemInstance.hh>
 #include <gambatte.h>
 #include <resample/resampler.h>
 #include <resample/resamplerinfo.h>
@@ -37,6 +39,7 @@ static constexpr auto pixFmt = IG::PIXEL_FMT_RGBA8888;
 #endif
 
 bool EmuSystem::hasCheats = true;
+bool EmuSystem::hasInstances = true;
 EmuSystem::NameFilterFunc EmuSystem::defaultFsFilter =
 	[](const char *name)
 	{
@@ -65,22 +68,27 @@ const char *EmuSystem::systemName()
 	return "Game Boy";
 }
 
-void applyGBPalette()
+static void applyGBPalette(gambatte::GB &gb, const GBPalette *builtinPalette)
 {
 	uint idx = optionGBPal;
 	assert(idx < IG::size(gbPal));
-	bool useBuiltin = optionUseBuiltinGBPalette && gameBuiltinPalette;
+	bool useBuiltin = optionUseBuiltinGBPalette && builtinPalette;
 	if(useBuiltin)
 		logMsg("using built-in game palette");
 	else
 		logMsg("using palette index %d", idx);
-	const GBPalette &pal = useBuiltin ? *gameBuiltinPalette : gbPal[idx];
+	const GBPalette &pal = useBuiltin ? *builtinPalette : gbPal[idx];
 	iterateTimes(4, i)
-		gbEmu.setDmgPaletteColor(0, i, pal.bg[i]);
+		gb.setDmgPaletteColor(0, i, pal.bg[i]);
 	iterateTimes(4, i)
-		gbEmu.setDmgPaletteColor(1, i, pal.sp1[i]);
+		gb.setDmgPaletteColor(1, i, pal.sp1[i]);
 	iterateTimes(4, i)
-		gbEmu.setDmgPaletteColor(2, i, pal.sp2[i]);
+		gb.setDmgPaletteColor(2, i, pal.sp2[i]);
+}
+
+void applyGBPalette()
+{
+	applyGBPalette(gbEmu, gameBuiltinPalette);
 }
 
 EmuSystem::Error EmuSystem::onOptionsLoaded()
@@ -138,6 +146,16 @@ void EmuSystem::closeSystem()
 	gameBuiltinPalette = nullptr;
 }
 
+static void snapshotBackupMem(BackupMemory::Snapshot &snapshot)
+{
+	std::size_t size;
+	if(auto data = gbEmu.savedata(size);
+		data)
+	{
+		snapshot.write(FS::makePathStringPrintf("%s.sav", gbEmu.saveBasePath().c_str()), data, size);
+	}
+}
+
 EmuSystem::Error EmuSystem::loadGame(IO &io, OnLoadProgressDelegate)
 {
 	gbEmu.setSaveDir(EmuSystem::savePath());
@@ -160,6 +178,13 @@ EmuSystem::Error EmuSystem::loadGame(IO &io, OnLoadProgressDelegate)
 	}
 	readCheatFile();
 	applyCheats();
+	std::size_t saveSize;
+	if(auto saveData = gbEmu.savedata(saveSize);
+		saveData)
+	{
+		BackupMemory::watch(saveData, saveSize);
+		BackupMemory::setOnSnapshot(snapshotBackupMem);
+	}
 	return {};
 }
 
@@ -238,6 +263,88 @@ void EmuSystem::runFrame(EmuVideo &video, bool renderGfx, bool processGfx, bool
 	}
 }
 
+class GbcInstance : public EmuSystem::Instance
+{
+public:
+	GbcInstance()
+	{
+		gb.setInputGetter(&input);
+	}
+
+	EmuSystem::Error loadGame(IO &io, const char *name) final
+	{
+		auto buffView = io.constBufferView();
+		if(!buffView)
+		{
+			return EmuSystem::makeFileReadError();
+		}
+		// never share battery saves with the app's machine
+		uint flags = gambatte::GB::NO_SAVEDATA | (optionReportAsGba ? gambatte::GB::GBA_CGB : 0);
+		if(auto result = gb.load(buffView.data(), buffView.size(), name, flags);
+			result != gambatte::LOADRES_OK)
+		{
+			return EmuSystem::makeError("%s", gambatte::to_string(result).c_str());
+		}
+		if(!gb.isCgb())
+		{
+			applyGBPalette(gb, findGbcTitlePal(gb.romTitle().c_str()));
+		}
+		return {};
+	}
+
+	void reset() final
+	{
+		gb.reset();
+	}
+
+	void handleInputAction(uint state, uint emuKey) final
+	{
+		input.bits = IG::setOrClearBits(input.bits, emuKey, state == Input::PUSHED);
+	}
+
+	void clearInputBuffers() final
+	{
+		input.bits = 0;
+	}
+
+	bool runFrame(bool processGfx) final
+	{
+		// one slice like EmuSystem::runFrame(), audio is discarded
+		size_t samples = 35112;
+		return gb.runFor(processGfx ? frame : nullptr, gbResX, (uint_least32_t*)snd, samples, {}) != -1;
+	}
+
+	IG::Pixmap videoPixmap() final
+	{
+		return {{{gbResX, gbResY}, pixFmt}, frame};
+	}
+
+	EmuSystem::Error saveState(const char *path) final
+	{
+		if(!gb.saveState(nullptr, gbResX, path))
+			return EmuSystem::makeFileWriteError();
+		return {};
+	}
+
+	EmuSystem::Error loadState(const char *path) final
+	{
+		if(!gb.loadState(path))
+			return EmuSystem::makeFileReadError();
+		return {};
+	}
+
+private:
+	gambatte::GB gb;
+	GbcInput input;
+	gambatte::PixelType frame[gbResX * gbResY]{};
+	alignas(std::max_align_t) uint8 snd[(35112+2064)*4];
+};
+
+std::unique_ptr<EmuSystem::Instance> EmuSystem::makeInstance()
+{
+	return std::make_unique<GbcInstance>();
+}
+
 void EmuApp::onCustomizeNavView(EmuApp::NavView &view)
 {
 	const Gfx::LGradientStopDesc navViewGrad[] =
@@ -108,6 +108,7 @@ ifdef hasSCD
  cdrom/l-ec.cpp \
  cdrom/CDUtility.cpp \
  cdrom/CDAccess_Image.cpp \
+ cdrom/CDReadAhead.cpp \
  cdrom/CDAccess.cpp \
  string/trim.cpp
 
@@ -45,5 +45,8 @@
 /* Function prototypes */
 EmuSystem::Error state_load(const unsigned char *buffer);
 int state_save(unsigned char *buffer);
+/* uncompressed, state must hold STATE_SIZE bytes */
+EmuSystem::Error state_load_raw(unsigned char *state, unsigned long size);
+int state_save_raw(unsigned char *state);
 
 #endif
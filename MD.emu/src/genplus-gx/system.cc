@@ -169,7 +169,7 @@ int audioUpdateAll(int16 *sb)
 	int16 cddaRemsampledBuff[size*2];
 	extern int readCDDA(void *dest, uint size);
 	bool doCDDA = hasSegaCD && readCDDA(cddaBuff, cddaFrames);
-	if(doCDDA && snd.sample_rate != 44100)
+	if(doCDDA && sb && snd.sample_rate != 44100)
 	{
 		auto cddaPtr = (int32*)cddaBuff;
 		auto cddaResampledPtr = (int32*)cddaRemsampledBuff;
@@ -214,8 +214,16 @@ int audioUpdateAll(int16 *sb)
 #endif
 
   assert(size < snd.buffer_size);
+  /* without an output buffer the samples are consumed unmixed */
+  int mixSize = sb ? size : 0;
+  if (!sb)
+  {
+    fm += size * 2;
+    psg += size;
+  }
+
   /* mix samples */
-  for (i = 0; i < size; i ++)
+  for (i = 0; i < mixSize; i ++)
   {
     /* PSG samples (mono) */
     l = r = (((*psg++) * psg_preamp) / 100);
@@ -29,7 +29,7 @@
 #include "genesis.h"
 StaticArrayList<MdCheat, EmuCheats::MAX> cheatList;
 StaticArrayList<MdCheat*, EmuCheats::MAX> romCheatList;
-StaticArrayList<MdCheat*, EmuCheats::MAX> ramCheatList;
+CheatPatchTable ramPatches;
 bool cheatsModified = 0;
 static const char *INPUT_CODE_8BIT_STR = "Input xxx-xxx-xxx (GG) or xxxxxx:xx (AR) code";
 static const char *INPUT_CODE_16BIT_STR = "Input xxxx-xxxx (GG) or xxxxxx:xxxx (AR) code";
@@ -278,6 +278,7 @@ uint decodeCheat(const char *string, uint32 &address, uint16 &data, uint16 &orig
 
 void applyCheats()
 {
+	ramPatches.setRegion(0, work_ram, sizeof(work_ram));
 	for(auto &e : cheatList)
   {
   	assert(!e.isApplied()); // make sure cheats have been cleared beforehand
@@ -319,14 +320,26 @@ void applyCheats()
       else if(e.address >= 0xFF0000)
       {
         // add RAM patch
-      	ramCheatList.push_back(&e);
+        if(e.data & 0xFF00)
+        {
+          // word patch
+          uint16 word = e.data;
+          ramPatches.addWrite(0, e.address & 0xFFFE, &word, 2);
+        }
+        else
+        {
+          // byte patch
+          uint8 byte = e.data;
+          ramPatches.addWrite(0, e.address & 0xFFFF, &byte, 1);
+        }
       }
       e.setApplied(1);
     }
   }
-  if(romCheatList.size() || ramCheatList.size())
+  ramPatches.compile();
+  if(romCheatList.size() || !ramPatches.empty())
   {
-  	logMsg("%d RAM cheats, %d ROM cheats active", ramCheatList.size(), romCheatList.size());
+  	logMsg("%d RAM patch runs, %d ROM cheats active", ramPatches.runs(), romCheatList.size());
   }
 }
 
@@ -334,7 +347,7 @@ void clearCheats()
 {
 	//logMsg("clearing cheats");
 	romCheatList.clear();
-	ramCheatList.clear();
+	ramPatches.clear();
 
 	//logMsg("reversing applied cheats");
   // disable cheats in reversed order in case the same address is used by multiple patches
@@ -372,7 +385,7 @@ void clearCheats()
 void clearCheatList()
 {
 	romCheatList.clear();
-	ramCheatList.clear();
+	ramPatches.clear();
 	cheatList.clear();
 }
 
@@ -474,20 +487,7 @@ void readCheatFile()
 
 void RAMCheatUpdate()
 {
-	for(auto &e : ramCheatList)
-	{
-		// apply RAM patch
-		if(e->data & 0xFF00)
-		{
-			// word patch
-			*(uint16*)(work_ram + (e->address & 0xFFFE)) = e->data;
-		}
-		else
-		{
-			// byte patch
-			work_ram[e->address & 0xFFFF] = e->data;
-		}
-	}
+	ramPatches.apply();
 }
 
 void ROMCheatUpdate()
@@ -3,6 +3,7 @@
 #include <imagine/util/container/ArrayList.hh>
 #include <imagine/util/bits.h>
 #include <emuframework/EmuSystem.hh>
+#include <emuframework/CheatPatchTable.hh>
 
 namespace EmuCheats
 {
@@ -64,5 +65,5 @@ void ROMCheatUpdate();
 
 extern StaticArrayList<MdCheat, EmuCheats::MAX> cheatList;
 extern StaticArrayList<MdCheat*, EmuCheats::MAX> romCheatList;
-extern StaticArrayList<MdCheat*, EmuCheats::MAX> ramCheatList;
+extern CheatPatchTable ramPatches;
 extern bool cheatsModified;
@@ -17,6 +17,9 @@
 #include <emuframework/EmuApp.hh>
 #include <emuframework/EmuInput.hh>
 #include <emuframework/EmuAppInlines.hh>
+#include <emuframework/BackupMemory.hh>
+#include <emuframework/StateHash.hh>
+#include <emuframework/CheatSearch.hh>
 #include "internal.hh"
 #include "system.h"
 #include "loadrom.h"
@@ -37,6 +40,7 @@
 
 const char *EmuSystem::creditsViewStr = CREDITS_INFO_STRING "(c) 2011-2014\nRobert Broglia\nwww.explusalpha.com\n\nPortions (c) the\nGenesis Plus Team\ncgfm2.emuviews.com";
 bool EmuSystem::hasCheats = true;
+bool EmuSystem::hasMemoryStates = true;
 bool EmuSystem::hasPALVideoSystem = true;
 t_config config{};
 uint config_ym2413_enabled = 1;
@@ -84,7 +88,7 @@ void EmuSystem::runFrame(EmuVideo &video, bool renderGfx, bool processGfx, bool
 	system_frame(!processGfx, renderGfx, video);
 
 	int16 audioBuff[snd.buffer_size * 2];
-	int frames = audio_update(audioBuff);
+	int frames = audio_update(renderAudio ? audioBuff : nullptr);
 	if(renderAudio)
 	{
 		//logMsg("%d frames", frames);
@@ -172,6 +176,35 @@ EmuSystem::Error EmuSystem::loadState(const char *path)
 	return loadMDState(path);
 }
 
+EmuSystem::Error EmuSystem::saveStateToMemory(MemoryState &data)
+{
+	// uncompressed since rollback saves every frame
+	data.resize(STATE_SIZE);
+	data.resize(state_save_raw(data.data()));
+	return {};
+}
+
+EmuSystem::Error EmuSystem::loadStateFromMemory(const uint8 *data, size_t size)
+{
+	return state_load_raw((unsigned char*)data, size);
+}
+
+uint EmuSystem::bootSnapshotFrames()
+{
+	#ifndef NO_SCD
+	// past the BIOS logos, cartridges boot instantly
+	if(sCD.isActive)
+		return 240;
+	#endif
+	return 0;
+}
+
+FS::PathString EmuSystem::bootSnapshotConfig()
+{
+	return FS::makePathStringPrintf("%s:%s:%s:%d:%d:%d", optionCDBiosUsaPath.val, optionCDBiosJpnPath.val,
+		optionCDBiosEurPath.val, (int)optionRegion, (int)optionVideoSystem, (int)option6BtnPad);
+}
+
 void EmuSystem::saveBackupMem() // for manually saving when not closing game
 {
 	if(!gameIsRunning())
@@ -224,6 +257,41 @@ void EmuSystem::saveBackupMem() // for manually saving when not closing game
 	writeCheatFile();
 }
 
+static void snapshotBackupMem(BackupMemory::Snapshot &snapshot)
+{
+	#ifndef NO_SCD
+	if(sCD.isActive)
+	{
+		auto saveStr = sprintBRAMSaveFilename();
+		snapshot.write(saveStr, bram, sizeof(bram));
+		snapshot.write(saveStr, sram.sram, 0x10000, true);
+		return;
+	}
+	#endif
+	if(sram.on)
+	{
+		snapshot.write(sprintSaveFilename(), sram.sram, 0x10000, optionBigEndianSram);
+	}
+}
+
+static void watchBackupMem()
+{
+	#ifndef NO_SCD
+	if(sCD.isActive)
+	{
+		BackupMemory::watch(bram, sizeof(bram));
+		BackupMemory::watch(sram.sram, 0x10000);
+		BackupMemory::setOnSnapshot(snapshotBackupMem);
+		return;
+	}
+	#endif
+	if(sram.on)
+	{
+		BackupMemory::watch(sram.sram, 0x10000);
+		BackupMemory::setOnSnapshot(snapshotBackupMem);
+	}
+}
+
 void EmuSystem::closeSystem()
 {
 	saveBackupMem();
@@ -506,6 +574,10 @@ EmuSystem::Error EmuSystem::loadGame(IO &io, OnLoadProgressDelegate)
 
 	readCheatFile();
 	applyCheats();
+	watchBackupMem();
+	StateHash::addRegion(work_ram, sizeof(work_ram));
+	StateHash::addRegion(zram, sizeof(zram));
+	CheatSearch::addRegion("RAM", work_ram, sizeof(work_ram));
 
 	return {};
 }
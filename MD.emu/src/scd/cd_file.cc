@@ -65,6 +65,13 @@ void Unload_ISO(void)
 	}
 }
 
+void FILE_Hint_LBA(int lba)
+{
+	if(!cdImage || lba < 0)
+		return;
+	cdImage->HintReadSector(lba, 32);
+}
+
 static void readLBA(void *dest, int lba)
 {
 	cdImage->Read_Sector((uint8*)dest, lba, 2048);
@@ -13,3 +13,5 @@ int Load_ISO(CDAccess *cd);
 void Unload_ISO(void);
 int  FILE_Read_One_LBA_CDC(void);
 int  FILE_Play_CD_LBA(void);
+// start reading ahead at a seek or play target
+void FILE_Hint_LBA(int lba);
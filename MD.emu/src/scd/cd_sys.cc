@@ -492,6 +492,7 @@ int Play_CDD_c3(void)
 
 	sCD.Cur_LBA = new_lba;
 	CDC_Update_Header();
+	FILE_Hint_LBA(sCD.Cur_LBA);
 
 	//logMsg("Read : Cur LBA = %d, M=%d, S=%d, F=%d", sCD.Cur_LBA, MSF.M, MSF.S, MSF.F);
 
@@ -545,6 +546,7 @@ int Seek_CDD_c4(void)
 	sCD.Cur_Track = MSF_to_Track(&MSF);
 	sCD.Cur_LBA = MSF_to_LBA(&MSF);
 	CDC_Update_Header();
+	FILE_Hint_LBA(sCD.Cur_LBA);
 
 	sCD.Status_CDC &= ~1;				// Stop CDC read
 
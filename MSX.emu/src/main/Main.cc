@@ -18,6 +18,7 @@
 #include <emuframework/EmuAppInlines.hh>
 #include <imagine/fs/ArchiveFS.hh>
 #include <imagine/gui/AlertView.hh>
+#include <imagine/util/audio/Resampler.hh>
 #include "internal.hh"
 
 // TODO: remove when namespace code is complete
@@ -51,6 +52,8 @@ bool EmuSystem::handlesGenericIO = false; // TODO: need to re-factor BlueMSX fil
 BoardInfo boardInfo{};
 Machine *machine{};
 Mixer *mixer{};
+static constexpr uint mixerRate = 44100;
+static Audio::Resampler resampler{};
 bool canInstallCBIOS = true;
 FS::PathString machineCustomPath{};
 FS::PathString machineBasePath{};
@@ -68,6 +71,7 @@ static char *srcPixData = (char*)&screenBuff[8 * msxResX];
 static IG::Pixmap srcPix{{{msxResX, msxResY}, pixFmt}, srcPixData};
 static bool doubleWidthFrame = false;
 static EmuVideo *emuVideo{};
+static bool renderToScreen = false;
 
 #if defined CONFIG_BASE_ANDROID || defined CONFIG_ENV_WEBOS || defined CONFIG_BASE_IOS || defined CONFIG_MACHINE_IS_PANDORA
 static const bool checkForMachineFolderOnStart = true;
@@ -712,10 +716,9 @@ EmuSystem::Error EmuSystem::loadGame(IO &, OnLoadProgressDelegate)
 
 void EmuSystem::configAudioRate(double frameTime, int rate)
 {
-	assumeExpr(rate == 44100);// TODO: not all sound chips handle non-44100Hz sample rate
-	uint mixRate = std::round(rate * (59.924 * frameTime));
-	mixerSetSampleRate(mixer, mixRate);
-	logMsg("set mixer rate %d", (int)mixerGetSampleRate(mixer));
+	// not all sound chips handle non-44100Hz sample rates, so mix at that rate & resample the output
+	mixerSetSampleRate(mixer, mixerRate);
+	resampler.init(mixerRate, rate * (59.924 * frameTime), 2);
 }
 
 static Int32 soundWrite(void* dummy, Int16 *buffer, UInt32 count)
@@ -731,7 +734,8 @@ static void commitVideoFrame()
 	{
 		emuVideo->setFormat({{msxResX, msxResY}, pixFmt});
 		emuVideo->writeFrame(srcPix);
-		EmuApp::updateAndDrawEmuVideo();
+		if(renderToScreen)
+			EmuApp::updateAndDrawEmuVideo();
 		emuVideo = {};
 	}
 }
@@ -745,6 +749,7 @@ void RefreshScreen(int screenMode)
 
 void EmuSystem::runFrame(EmuVideo &video, bool renderGfx, bool processGfx, bool renderAudio)
 {
+	renderToScreen = renderGfx;
 	// fast-forward during floppy access, but stop if access ends
 	if(unlikely(fdcActive && renderGfx))
 	{
@@ -761,27 +766,27 @@ void EmuSystem::runFrame(EmuVideo &video, bool renderGfx, bool processGfx, bool
 			}
 			mixerSync(mixer);
 			UInt32 samples;
-			uchar *audio = (uchar*)mixerGetBuffer(mixer, &samples);
+			Int16 *audio = mixerGetBuffer(mixer, &samples);
 			if(useFrame)
 			{
-				writeSound(audio, samples/2);
+				EmuSystem::writeSound(resampler, audio, samples/2);
 				return; // done with frame for this update
 			}
 		}
 	}
 
-	// regular frame update
-	if(renderGfx)
-		emuVideo = &video;
+	// regular frame update, the VDP still draws every line since sprite
+	// collision and overflow status come from its line renderers
+	emuVideo = processGfx ? &video : nullptr;
 	boardInfo.run(boardInfo.cpuRef);
 	((R800*)boardInfo.cpuRef)->terminate = 0;
 	mixerSync(mixer);
 	UInt32 samples;
-	uchar *audio = (uchar*)mixerGetBuffer(mixer, &samples);
+	Int16 *audio = mixerGetBuffer(mixer, &samples);
 	//logMsg("%d samples", samples/2);
 	if(renderAudio && samples)
 	{
-		writeSound(audio, samples/2);
+		EmuSystem::writeSound(resampler, audio, samples/2);
 	}
 }
 
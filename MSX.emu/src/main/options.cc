@@ -29,7 +29,6 @@ const AspectRatioInfo EmuSystem::aspectRatioInfo[] =
 		EMU_SYSTEM_DEFAULT_ASPECT_RATIO_INFO_INIT
 };
 const uint EmuSystem::aspectRatioInfos = IG::size(EmuSystem::aspectRatioInfo);
-int EmuSystem::forcedSoundRate = 44100;
 #define optionMachineNameDefault "MSX2"
 char optionMachineNameStr[128] = optionMachineNameDefault;
 PathOption optionMachineName{CFGKEY_MACHINE_NAME, optionMachineNameStr, optionMachineNameDefault};
@@ -16,6 +16,7 @@
 #define LOGTAG "main"
 #include <emuframework/EmuApp.hh>
 #include <emuframework/EmuAppInlines.hh>
+#include <emuframework/MemoryStats.hh>
 #include <imagine/base/Pipe.hh>
 #include <imagine/thread/Thread.hh>
 #include <imagine/fs/ArchiveFS.hh>
@@ -279,6 +280,22 @@ CLINK void *res_load_data(const char *name)
 	return buffer;
 }
 
+static void updateMemoryStats()
+{
+	auto &r = memory.rom;
+	const ROM_REGION *region[]{&r.cpu_m68k, &r.cpu_z80, &r.tiles, &r.game_sfix, &r.bios_sfix, &r.bios_audio,
+		&r.bios_m68k, &r.adpcma, &r.adpcmb, &r.spr_usage, &r.gfix_usage, &r.cpu_z80c};
+	size_t romBytes = 0;
+	for(auto reg : region)
+	{
+		// tiles aren't loaded when using the sprite cache, adpcmb may share adpcma's data
+		if(reg->p && !(reg == &r.adpcmb && r.adpcmb.p == r.adpcma.p))
+			romBytes += reg->size;
+	}
+	MemoryStats::set(MemoryStats::ROM, romBytes);
+	MemoryStats::set(MemoryStats::SPRITE_CACHE, memory.vid.spr_cache.data ? memory.vid.spr_cache.size : 0);
+}
+
 EmuSystem::Error EmuSystem::loadGame(IO &, OnLoadProgressDelegate onLoadProgressFunc)
 {
 	onLoadProgress = onLoadProgressFunc;
@@ -324,6 +341,7 @@ EmuSystem::Error EmuSystem::loadGame(IO &, OnLoadProgressDelegate onLoadProgress
 	EmuSystem::setFullGameName(drv->longname);
 	logMsg("set long game name: %s", EmuSystem::fullGameName().data());
 	setTimerIntOption();
+	updateMemoryStats();
 	return {};
 }
 
@@ -240,6 +240,8 @@ void flash_write(uint32 start_address, uint16 length)
 
 //	system_debug_message("flash write: %06X, %d bytes", start_address, length);
 
+	system_io_flash_changed();
+
 	for (i = 0; i < block_count; i++)
 	{
 		//Got this block with enough bytes to cover it
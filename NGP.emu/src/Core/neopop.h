@@ -386,6 +386,12 @@ RomHeader;
 	bool system_io_flash_write(uint8* buffer, uint32 bufferLength);
 
 
+/*! Called after the game writes to flash memory so the system can
+	schedule a call to flash_commit() or flash_prepare(). */
+
+	void system_io_flash_changed(void);
+
+
 /*! Reads from the file specified by 'filename' into the given preallocated
 	buffer. This is state data. */
 
@@ -22,12 +22,14 @@
 #include "interrupt.h"
 #include <emuframework/EmuApp.hh>
 #include <emuframework/EmuAppInlines.hh>
+#include <emuframework/BackupMemory.hh>
 
 const char *EmuSystem::creditsViewStr = CREDITS_INFO_STRING "(c) 2011-2014\nRobert Broglia\nwww.explusalpha.com\n\n(c) 2004\nthe NeoPop Team\nwww.nih.at";
 uint32 frameskip_active = 0;
 static const int ngpResX = SCREEN_WIDTH, ngpResY = SCREEN_HEIGHT;
 static constexpr auto pixFmt = IG::PIXEL_FMT_RGB565;
 static EmuVideo *emuVideo{};
+static bool renderToScreen = false;
 static IG::Pixmap srcPix{{{ngpResX, ngpResY}, pixFmt}, cfb};
 
 EmuSystem::NameFilterFunc EmuSystem::defaultFsFilter =
@@ -102,6 +104,21 @@ bool system_io_flash_write(uchar* buffer, uint32 len)
 	return !ec;
 }
 
+void system_io_flash_changed()
+{
+	BackupMemory::markDirty();
+}
+
+static void snapshotBackupMem(BackupMemory::Snapshot &snapshot)
+{
+	int len;
+	auto flashData = flash_prepare(&len);
+	if(!flashData)
+		return;
+	snapshot.write(sprintSaveFilename(), flashData, len);
+	free(flashData);
+}
+
 void EmuSystem::saveBackupMem()
 {
 	logMsg("saving flash");
@@ -140,6 +157,7 @@ EmuSystem::Error EmuSystem::loadGame(IO &io, OnLoadProgressDelegate)
 	logMsg("loaded NGP rom: %s, catalog %d,%d", rom.name, rom_header->catalog, rom_header->subCatalog);
 	::reset();
 	rom_bootHacks();
+	BackupMemory::setOnSnapshot(snapshotBackupMem);
 	return {};
 }
 
@@ -164,15 +182,16 @@ void system_VBL(void)
 	if(likely(emuVideo))
 	{
 		emuVideo->writeFrame(srcPix);
-		EmuApp::updateAndDrawEmuVideo();
+		if(renderToScreen)
+			EmuApp::updateAndDrawEmuVideo();
 		emuVideo = {};
 	}
 }
 
 void EmuSystem::runFrame(EmuVideo &video, bool renderGfx, bool processGfx, bool renderAudio)
 {
-	if(renderGfx)
-		emuVideo = &video;
+	emuVideo = processGfx ? &video : nullptr;
+	renderToScreen = renderGfx;
 	frameskip_active = processGfx ? 0 : 1;
 
 	#ifndef NEOPOP_DEBUG
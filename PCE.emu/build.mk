@@ -53,6 +53,7 @@ mednafen/cdrom/galois.cpp \
 mednafen/cdrom/recover-raw.cpp \
 mednafen/cdrom/CDAccess.cpp \
 mednafen/cdrom/CDAccess_Image.cpp \
+mednafen/cdrom/CDReadAhead.cpp \
 mednafen/cdrom/CDAccess_CCD.cpp \
 mednafen/cdrom/CDUtility.cpp \
 mednafen/cdrom/l-ec.cpp \
@@ -232,6 +232,7 @@ void CDAccess_Image::ParseTOCFileLineInfo(CDRFILE_TRACK_INFO *track, const int t
   }
 
   track->fp = std::make_shared<FileIO>(std::move(fp));
+  readAhead.addFile(*track->fp, efn.c_str());
   toc_streamcache[filename] = track->fp;
  }
 
@@ -678,6 +679,7 @@ void CDAccess_Image::ImageOpen(const std::string& path, bool image_memcache)
      	throw MDFN_Error(0, "Error opening file \"%s\"", efn.c_str());
      }
      TmpTrack.fp = std::make_shared<FileIO>(std::move(fp));
+     readAhead.addFile(*TmpTrack.fp, efn.c_str());
      TmpTrack.FirstFileInstance = 1;
 
      if(!strcasecmp(args[1].c_str(), "BINARY"))
@@ -987,6 +989,7 @@ void CDAccess_Image::ImageOpenBinary(const std::string& path, bool isIso)
 		throw(MDFN_Error(ene.Errno(), _("Could not open file \"%s\": %s"), path.c_str(), ene.StrError()));
 	}
 	track.fp = std::make_shared<FileIO>(std::move(fp));
+	readAhead.addFile(*track.fp, path.c_str());
 	track.FirstFileInstance = 1;
 	track.DIFormat = DI_FORMAT_MODE1_RAW;
 	if(isIso)
@@ -1166,7 +1169,7 @@ bool CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
 		switch(ct->DIFormat)
 		{
  case DI_FORMAT_AUDIO:
-	ct->fp->readAtPos(buf, 2352, SeekPos);
+	readAhead.readAtPos(*ct->fp, buf, 2352, SeekPos);
 	SeekPos += 2352;
 
 	if(ct->RawAudioMSBFirst)
@@ -1174,7 +1177,7 @@ bool CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
 	break;
 
  case DI_FORMAT_MODE1:
-	ct->fp->readAtPos(buf + 12 + 3 + 1, 2048, SeekPos);
+	readAhead.readAtPos(*ct->fp, buf + 12 + 3 + 1, 2048, SeekPos);
 	SeekPos += 2048;
 	encode_mode1_sector(lba + 150, buf);
 	break;
@@ -1182,12 +1185,12 @@ bool CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
  case DI_FORMAT_MODE1_RAW:
  case DI_FORMAT_MODE2_RAW:
  case DI_FORMAT_CDI_RAW:
-	ct->fp->readAtPos(buf, 2352, SeekPos);
+	readAhead.readAtPos(*ct->fp, buf, 2352, SeekPos);
 	SeekPos += 2352;
 	break;
 
  case DI_FORMAT_MODE2:
-	ct->fp->readAtPos(buf + 16, 2336, SeekPos);
+	readAhead.readAtPos(*ct->fp, buf + 16, 2336, SeekPos);
 	SeekPos += 2336;
 	encode_mode2_sector(lba + 150, buf);
 	break;
@@ -1196,13 +1199,13 @@ bool CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
  // FIXME: M2F1, M2F2, does sub-header come before or after user data(standards say before, but I wonder
  // about cdrdao...).
  case DI_FORMAT_MODE2_FORM1:
-	ct->fp->readAtPos(buf + 24, 2048, SeekPos);
+	readAhead.readAtPos(*ct->fp, buf + 24, 2048, SeekPos);
 	SeekPos += 2048;
 	//encode_mode2_form1_sector(lba + 150, buf);
 	break;
 
  case DI_FORMAT_MODE2_FORM2:
-	ct->fp->readAtPos(buf + 24, 2324, SeekPos);
+	readAhead.readAtPos(*ct->fp, buf + 24, 2324, SeekPos);
 	SeekPos += 2324;
 	//encode_mode2_form2_sector(lba + 150, buf);
 	break;
@@ -1210,7 +1213,7 @@ bool CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
 		}
 
 		if(ct->SubchannelMode)
-			ct->fp->readAtPos(buf + 2352, 96, SeekPos);
+			readAhead.readAtPos(*ct->fp, buf + 2352, 96, SeekPos);
 	 }
 	} // end if audible part of audio track read.
 	return true;
@@ -1280,7 +1283,7 @@ bool CDAccess_Image::Read_Sector(uint8 *buf, int32 lba, uint32 size)
 			MDFN_printf("skipping cdda sector read\n");
 			return false;
 		}
-		ct->fp->readAtPos(buf, 2352, SeekPos);
+		readAhead.readAtPos(*ct->fp, buf, 2352, SeekPos);
 
 		if(ct->RawAudioMSBFirst)
 		 Endian_A16_Swap(buf, 588 * 2);
@@ -1292,7 +1295,7 @@ bool CDAccess_Image::Read_Sector(uint8 *buf, int32 lba, uint32 size)
 			MDFN_printf("skipping data sector read\n");
 			return false;
 		}
-		ct->fp->readAtPos(buf, 2048, SeekPos);
+		readAhead.readAtPos(*ct->fp, buf, 2048, SeekPos);
 		break;
 
 	case DI_FORMAT_MODE1_RAW:
@@ -1302,7 +1305,7 @@ bool CDAccess_Image::Read_Sector(uint8 *buf, int32 lba, uint32 size)
 			return false;
 		}
 		SeekPos += 12 + 3 + 1;
-		ct->fp->readAtPos(buf, 2048, SeekPos);
+		readAhead.readAtPos(*ct->fp, buf, 2048, SeekPos);
 		break;
 			}
 
@@ -1349,7 +1352,7 @@ void CDAccess_Image::HintReadSector(uint32 lba, int32 count)
 				if(ct->SubchannelMode)
 				 SeekPos += 96 * (lba - ct->LBA);
 
-				ct->fp->advise(SeekPos, 2352 * count, IO::ADVICE_WILLNEED);
+				readAhead.hint(*ct->fp, SeekPos, 2352 * count);
 			}
 		}
 	 }
@@ -4,6 +4,7 @@
 #include <map>
 #include <array>
 #include <imagine/io/FileIO.hh>
+#include "CDReadAhead.h"
 
 class Stream;
 class CDAFReader;
@@ -92,6 +93,8 @@ class CDAccess_Image : public CDAccess
 
  std::string base_dir;
 
+ CDReadAhead readAhead;
+
  void ImageOpen(const std::string& path, bool image_memcache);
  void ImageOpenBinary(const std::string& path, bool isIso);
  void LoadSBI(const std::string& sbi_path);
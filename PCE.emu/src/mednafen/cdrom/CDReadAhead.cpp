@@ -0,0 +1,210 @@
+#define LOGTAG "CDReadAhead"
+#include "CDReadAhead.h"
+#include <imagine/logger/logger.h>
+#include <imagine/util/algorithm.h>
+#include <algorithm>
+#include <cstring>
+
+#ifdef CONFIG_IO_ASYNC_READER
+
+enum ChunkState : uint8
+{
+	CHUNK_EMPTY, CHUNK_PENDING, CHUNK_READY
+};
+
+CDReadAhead::CDReadAhead()
+{
+	reader.init(CHUNKS);
+}
+
+CDReadAhead::~CDReadAhead()
+{
+	// wait for reads into the chunk buffers to finish
+	reader.deinit();
+}
+
+void CDReadAhead::addFile(FileIO &io, const char *path)
+{
+	if(findFile(io) != -1)
+		return;
+	PosixIO fdIO;
+	if(auto ec = fdIO.open(path);
+		ec)
+	{
+		logWarn("can't open %s for read-ahead: %s", path, ec.message().c_str());
+		return;
+	}
+	if(!data)
+		data = std::make_unique<char[]>(CHUNKS * CHUNK_BYTES);
+	off_t size = fdIO.size();
+	file.push_back({&io, std::move(fdIO), size});
+}
+
+int CDReadAhead::findFile(FileIO &io) const
+{
+	iterateTimes(file.size(), i)
+	{
+		if(file[i].io == &io)
+			return i;
+	}
+	return -1;
+}
+
+CDReadAhead::Chunk *CDReadAhead::findChunk(int f, off_t index)
+{
+	for(auto &c : chunk)
+	{
+		if(c.state != CHUNK_EMPTY && c.file == f && c.index == index)
+			return &c;
+	}
+	return nullptr;
+}
+
+CDReadAhead::Chunk *CDReadAhead::queueChunk(int f, off_t index)
+{
+	off_t offset = index * CHUNK_BYTES;
+	if(offset >= file[f].size)
+		return nullptr;
+	// replace the least recently used chunk that isn't being read into
+	Chunk *c{};
+	for(auto &candidate : chunk)
+	{
+		if(candidate.state == CHUNK_PENDING)
+			continue;
+		if(candidate.state == CHUNK_EMPTY)
+		{
+			c = &candidate;
+			break;
+		}
+		if(!c || candidate.lastUse < c->lastUse)
+			c = &candidate;
+	}
+	if(!c)
+		return nullptr;
+	c->file = f;
+	c->index = index;
+	c->validBytes = 0;
+	c->lastUse = useCount;
+	c->state = CHUNK_PENDING;
+	uint chunkIdx = c - chunk.data();
+	batch[batchSize++] =
+		{
+			file[f].fdIO.fd(), chunkData(*c), (size_t)std::min((off_t)CHUNK_BYTES, file[f].size - offset), offset,
+			[this, chunkIdx](ssize_t result)
+			{
+				auto &c = chunk[chunkIdx];
+				if(result <= 0)
+				{
+					if(result < 0)
+						logErr("error reading ahead at offset:%lld: %s", (long long)c.index * CHUNK_BYTES, strerror(-result));
+					c.state = CHUNK_EMPTY;
+					return;
+				}
+				c.validBytes = result;
+				c.state = CHUNK_READY;
+			}
+		};
+	return c;
+}
+
+void CDReadAhead::queueAhead(int f, off_t index, uint chunks)
+{
+	iterateTimes(chunks, i)
+	{
+		if(findChunk(f, index + i))
+			continue;
+		if(!queueChunk(f, index + i))
+			break;
+	}
+}
+
+void CDReadAhead::submit()
+{
+	if(!batchSize)
+		return;
+	uint queued = reader.read(batch.data(), batchSize);
+	// shouldn't happen since there's a reader slot per chunk
+	for(uint i = queued; i < batchSize; i++)
+	{
+		chunk[((char*)batch[i].buf - data.get()) / CHUNK_BYTES].state = CHUNK_EMPTY;
+	}
+	batchSize = 0;
+}
+
+ssize_t CDReadAhead::readAtPos(FileIO &io, void *buff, size_t bytes, off_t offset)
+{
+	int f = findFile(io);
+	if(f == -1)
+		return io.readAtPos(buff, bytes, offset);
+	reader.processCompletions();
+	auto dest = (char*)buff;
+	size_t bytesRead = 0;
+	while(bytes)
+	{
+		off_t index = offset / CHUNK_BYTES;
+		uint chunkOffset = offset % CHUNK_BYTES;
+		size_t copyBytes = std::min(bytes, (size_t)(CHUNK_BYTES - chunkOffset));
+		auto c = findChunk(f, index);
+		bool miss = !c;
+		if(miss)
+			c = queueChunk(f, index);
+		// keep the chunk being read from out of the ones replaced by read-ahead
+		if(c)
+			c->lastUse = ++useCount;
+		queueAhead(f, index + 1, CHUNKS_AHEAD);
+		submit();
+		if(!miss)
+		{
+			// read-ahead already in flight is likely close to done
+			while(c->state == CHUNK_PENDING)
+				reader.wait();
+		}
+		// on a miss read only what's needed now, the rest of the chunk arrives in the background
+		if(miss || c->state != CHUNK_READY || chunkOffset + copyBytes > c->validBytes)
+		{
+			auto result = io.readAtPos(dest, bytes, offset);
+			return result < 0 ? result : bytesRead + result;
+		}
+		memcpy(dest, chunkData(*c) + chunkOffset, copyBytes);
+		dest += copyBytes;
+		offset += copyBytes;
+		bytes -= copyBytes;
+		bytesRead += copyBytes;
+	}
+	return bytesRead;
+}
+
+void CDReadAhead::hint(FileIO &io, off_t offset, size_t bytes)
+{
+	int f = findFile(io);
+	if(f == -1)
+	{
+		io.advise(offset, bytes, IO::ADVICE_WILLNEED);
+		return;
+	}
+	reader.processCompletions();
+	off_t index = offset / CHUNK_BYTES;
+	off_t endIndex = (offset + std::max(bytes, (size_t)1) - 1) / CHUNK_BYTES;
+	queueAhead(f, index, std::min((uint)(endIndex - index + 1), CHUNKS / 2));
+	submit();
+}
+
+#else
+
+CDReadAhead::CDReadAhead() {}
+
+CDReadAhead::~CDReadAhead() {}
+
+void CDReadAhead::addFile(FileIO &io, const char *path) {}
+
+ssize_t CDReadAhead::readAtPos(FileIO &io, void *buff, size_t bytes, off_t offset)
+{
+	return io.readAtPos(buff, bytes, offset);
+}
+
+void CDReadAhead::hint(FileIO &io, off_t offset, size_t bytes)
+{
+	io.advise(offset, bytes, IO::ADVICE_WILLNEED);
+}
+
+#endif
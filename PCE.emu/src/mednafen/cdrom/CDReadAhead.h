@@ -0,0 +1,68 @@
+#ifndef __MDFN_CDROM_CDREADAHEAD_H
+#define __MDFN_CDROM_CDREADAHEAD_H
+
+#include <imagine/io/FileIO.hh>
+#ifdef CONFIG_IO_ASYNC_READER
+#include <imagine/io/AsyncReader.hh>
+#include <imagine/io/PosixIO.hh>
+#include <array>
+#include <memory>
+#include <vector>
+#endif
+
+// Reads image data ahead of the emulated drive into a small chunk cache so
+// sector and CD-DA reads don't block on seeks to slow SD cards or USB drives.
+// Each read queues the chunks after it, and a seek hint queues the chunks at
+// the new position, all through one AsyncReader. A read that misses the
+// cache is served straight from the FileIO while its chunk is queued, as are
+// reads of files not added or of chunks that failed to load.
+
+class CDReadAhead
+{
+public:
+	CDReadAhead();
+	~CDReadAhead();
+	void addFile(FileIO &io, const char *path);
+	ssize_t readAtPos(FileIO &io, void *buff, size_t bytes, off_t offset);
+	void hint(FileIO &io, off_t offset, size_t bytes);
+
+	#ifdef CONFIG_IO_ASYNC_READER
+private:
+	static constexpr uint CHUNK_BYTES = 64 * 1024;
+	static constexpr uint CHUNKS = 24;
+	static constexpr uint CHUNKS_AHEAD = 4; // 256KiB, over a second of 1x speed reads
+
+	struct File
+	{
+		FileIO *io{};
+		PosixIO fdIO{};
+		off_t size = 0;
+	};
+
+	struct Chunk
+	{
+		int file = -1;
+		off_t index = 0;
+		uint validBytes = 0;
+		uint lastUse = 0;
+		uint8 state = 0;
+	};
+
+	std::vector<File> file{};
+	std::unique_ptr<char[]> data{};
+	std::array<Chunk, CHUNKS> chunk{};
+	std::array<AsyncReader::Request, CHUNKS> batch{};
+	uint batchSize = 0;
+	uint useCount = 0;
+	AsyncReader reader{};
+
+	int findFile(FileIO &io) const;
+	Chunk *findChunk(int file, off_t index);
+	Chunk *queueChunk(int file, off_t index);
+	void queueAhead(int file, off_t index, uint chunks);
+	void submit();
+	char *chunkData(const Chunk &c) { return &data[(&c - chunk.data()) * CHUNK_BYTES]; }
+	#endif
+};
+
+#endif
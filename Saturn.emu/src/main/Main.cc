@@ -2,6 +2,8 @@
 #define LOGTAG "main"
 #include <emuframework/EmuApp.hh>
 #include <emuframework/EmuAppInlines.hh>
+#include <emuframework/CheatSearch.hh>
+#include <imagine/util/audio/Resampler.hh>
 #include "internal.hh"
 
 extern "C"
@@ -44,6 +46,9 @@ CLINK void OSDDisplayMessages(void) {}
 // Sound
 
 // EmuFramework is in charge of audio setup & parameters
+static constexpr int scspRate = 44100;
+static Audio::Resampler resampler{};
+
 static int SNDImagineInit() { logMsg("called sound core init"); return 0; }
 static void SNDImagineDeInit() {}
 static int SNDImagineReset() { return 0; }
@@ -79,7 +84,7 @@ static void SNDImagineUpdateAudio(u32 *leftchanbuffer, u32 *rightchanbuffer, u32
 	{
 		mergeSamplesToStereo(leftchanbuffer[i], rightchanbuffer[i], &sample[i*2]);
 	}
-	EmuSystem::writeSound(sample, frames);
+	EmuSystem::writeSound(resampler, sample, frames);
 }
 
 static u32 SNDImagineGetAudioSpace()
@@ -198,6 +203,7 @@ EmuSystem::NameFilterFunc EmuSystem::defaultBenchmarkFsFilter = hasCDExtension;
 static constexpr auto pixFmt = IG::PIXEL_FMT_RGBA8888;
 
 static EmuVideo *emuVideo{};
+static bool renderToScreen = false;
 
 CLINK void YuiSwapBuffers()
 {
@@ -209,7 +215,8 @@ CLINK void YuiSwapBuffers()
 		IG::Pixmap srcPix = {{{width, height}, pixFmt}, dispbuffer};
 		emuVideo->setFormat(srcPix);
 		emuVideo->writeFrame(srcPix);
-		EmuApp::updateAndDrawEmuVideo();
+		if(renderToScreen)
+			EmuApp::updateAndDrawEmuVideo();
 		emuVideo = {};
 	}
 	else
@@ -265,6 +272,32 @@ EmuSystem::Error EmuSystem::loadState(const char *path)
 		return EmuSystem::makeFileReadError();
 }
 
+EmuSystem::Error EmuSystem::loadStateFromMemory(const uint8 *data, size_t size)
+{
+	// states also hold backup RAM, but it has its own file and a boot
+	// snapshot or rollback mustn't revert saves made since
+	auto bupRam = std::make_unique<u8[]>(0x10000);
+	memcpy(bupRam.get(), BupRam, 0x10000);
+	auto err = loadStateFromMemoryWithFile(data, size);
+	memcpy(BupRam, bupRam.get(), 0x10000);
+	return err;
+}
+
+uint EmuSystem::bootSnapshotFrames()
+{
+	// the emulated BIOS used without a BIOS file boots instantly
+	if(!strlen(biosPath.data()))
+		return 0;
+	// past the Saturn logo sequence, before any game shows a title
+	return 240;
+}
+
+FS::PathString EmuSystem::bootSnapshotConfig()
+{
+	return FS::makePathStringPrintf("%s:%d:%d:%d:%s", biosPath.data(), yinit.sh2coretype,
+		yinit.carttype, yinit.regionid, yinit.cartpath ? yinit.cartpath : "");
+}
+
 void EmuSystem::saveBackupMem() // for manually saving when not closing game
 {
 	if(gameIsRunning())
@@ -300,19 +333,27 @@ EmuSystem::Error EmuSystem::loadGame(IO &, OnLoadProgressDelegate)
 	pad[0] = PerPadAdd(&PORTDATA1);
 	pad[1] = PerPadAdd(&PORTDATA2);
 	ScspSetFrameAccurate(1);
+	// stored as host order 16-bit words, so on little-endian hosts 16-bit
+	// searches match the SH-2's view while byte offsets have bit 0 flipped
+	CheatSearch::addRegion("HWRAM", HighWram, 0x100000);
+	CheatSearch::addRegion("LWRAM", LowWram, 0x100000);
 
 	return {};
 }
 
 void EmuSystem::configAudioRate(double frameTime, int rate)
 {
-	// TODO: use frameTime
+	// the SCSP always renders at 44100Hz
+	double systemFrameRate = yabsys.IsPal ? 50. : 60.;
+	resampler.init(scspRate, rate * (systemFrameRate * frameTime), 2);
 }
 
 void EmuSystem::runFrame(EmuVideo &video, bool renderGfx, bool processGfx, bool renderAudio)
 {
-	if(renderGfx)
-		emuVideo = &video;
+	emuVideo = processGfx ? &video : nullptr;
+	renderToScreen = renderGfx;
+	VIDSoftSetSkipDraw(!processGfx);
+	// the SCSP's slots only advance while mixing, so only the output conversion is skipped
 	SNDImagine.UpdateAudio = renderAudio ? SNDImagineUpdateAudio : SNDImagineUpdateAudioNull;
 	YabauseEmulate();
 }
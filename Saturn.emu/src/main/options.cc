@@ -48,7 +48,6 @@ uint SH2Cores = IG::size(SH2CoreList) - 1;
 bool EmuApp::hasIcon = false;
 bool EmuApp::autoSaveStateDefault = false;
 bool EmuSystem::hasSound = !(Config::envIsAndroid || Config::envIsIOS || Config::envIsWebOS);
-int EmuSystem::forcedSoundRate = 44100;
 bool EmuSystem::constFrameRate = true;
 
 void EmuSystem::initOptions()
@@ -24,6 +24,9 @@
 #include <assert.h>
 #include <wchar.h>
 #include "cdbase.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
 #include "error.h"
 #include "debug.h"
 
@@ -329,6 +332,7 @@ enum IMG_TYPE { IMG_NONE, IMG_ISO, IMG_BINCUE, IMG_MDS, IMG_CCD, IMG_NRG };
 enum IMG_TYPE imgtype = IMG_ISO;
 static u32 isoTOC[102];
 static disc_info_struct disc;
+static u32 readAheadStart, readAheadEnd;
 
 #define MSF_TO_FAD(m,s,f) ((m * 4500) + (s * 75) + f)
 
@@ -821,6 +825,7 @@ static int ISOCDInit(const char * iso) {
 
    memset(isoTOC, 0xFF, 0xCC * 2);
    memset(&disc, 0, sizeof(disc));
+   readAheadStart = readAheadEnd = 0;
 
    if (!iso)
       return -1;
@@ -987,9 +992,47 @@ static int ISOCDReadSectorFAD(u32 FAD, void *buffer) {
 
 //////////////////////////////////////////////////////////////////////////////
 
-static void ISOCDReadAheadFAD(UNUSED u32 FAD)
+#define READ_AHEAD_SECTORS 64
+
+static void ISOCDReadAheadFAD(u32 FAD)
 {
-	// No-op
+#ifdef POSIX_FADV_WILLNEED
+   // Have the OS read the next sectors in the background so a seek on slow
+   // storage doesn't stall the frame that reads them. This is called for
+   // every sector, so only hint again once half the window is used.
+   int i, j;
+   track_info_struct *track=NULL;
+   u32 end;
+
+   if (!disc.session || (FAD >= readAheadStart && FAD + READ_AHEAD_SECTORS / 2 < readAheadEnd))
+      return;
+
+   for (i = 0; i < disc.session_num; i++)
+   {
+      for (j = 0; j < disc.session[i].track_num; j++)
+      {
+         if (FAD >= disc.session[i].track[j].fad_start &&
+             FAD <= disc.session[i].track[j].fad_end)
+         {
+            track = &disc.session[i].track[j];
+            break;
+         }
+      }
+   }
+
+   if (track == NULL || !track->fp)
+      return;
+
+   end = FAD + READ_AHEAD_SECTORS;
+   if (end > track->fad_end + 1)
+      end = track->fad_end + 1;
+   posix_fadvise(fileno(track->fp), track->file_offset + (FAD - track->fad_start) * track->sector_size,
+      (end - FAD) * track->sector_size, POSIX_FADV_WILLNEED);
+   readAheadStart = FAD;
+   readAheadEnd = end;
+#else
+   (void)FAD;
+#endif
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -156,6 +156,8 @@ static int nbg1priority=0;
 static int nbg2priority=0;
 static int nbg3priority=0;
 static int rbg0priority=0;
+static int vdp2skipdraw=0;
+static int vdp2screensdrawn=0;
 #ifdef USE_OPENGL
 static int outputwidth;
 static int outputheight;
@@ -2822,12 +2824,20 @@ int VIDSoftVdp2Reset(void)
 void VIDSoftVdp2DrawStart(void)
 {
    int titanblendmode = TITAN_BLEND_TOP;
+
+   if (vdp2skipdraw)
+   {
+      vdp2screensdrawn = 0;
+      return;
+   }
+
    if (Vdp2Regs->CCCTL & 0x100) titanblendmode = TITAN_BLEND_ADD;
    else if (Vdp2Regs->CCCTL & 0x200) titanblendmode = TITAN_BLEND_BOTTOM;
    TitanSetBlendingMode(titanblendmode);
 
    Vdp2DrawBackScreen();
    Vdp2DrawLineScreen();
+   vdp2screensdrawn = 1;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -2846,6 +2856,14 @@ void VIDSoftVdp2DrawEnd(void)
    int wctl;
    clipping_struct colorcalcwindow[2];
 
+   if (vdp2skipdraw && !vdp2screensdrawn)
+   {
+      // nothing was drawn for this frame, only keep the VDP1 framebuffers in step
+      VIDSoftVdp1SwapFrameBuffer();
+      return;
+   }
+   vdp2screensdrawn = 0;
+
    // Figure out whether to draw vdp1 framebuffer or vdp2 framebuffer pixels
    // based on priority
    if (Vdp1External.disptoggle && (Vdp2Regs->TVMD & 0x8000))
@@ -3105,6 +3123,9 @@ void VIDSoftVdp2DrawScreens(void)
 {
    int i;
 
+   if (vdp2skipdraw)
+      return;
+
    VIDSoftVdp2SetResolution(Vdp2Regs->TVMD);
    VIDSoftVdp2SetPriorityNBG0(Vdp2Regs->PRINA & 0x7);
    VIDSoftVdp2SetPriorityNBG1((Vdp2Regs->PRINA >> 8) & 0x7);
@@ -3129,6 +3150,22 @@ void VIDSoftVdp2DrawScreens(void)
 
 //////////////////////////////////////////////////////////////////////////////
 
+void VIDSoftSetSkipDraw(int skip)
+{
+   vdp2skipdraw = skip;
+   // A frame's screens are drawn at the VBlankOUT ending the previous frame,
+   // so catch up if that one was skipped. No emulated time passes between
+   // frames, the registers and VRAM are the same as they were then.
+   if (!skip && !vdp2screensdrawn)
+   {
+      VIDSoftVdp2DrawStart();
+      if (Vdp2Regs->TVMD & 0x8000)
+         VIDSoftVdp2DrawScreens();
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void VIDSoftVdp2DrawScreen(int screen)
 {
    VIDSoftVdp2SetResolution(Vdp2Regs->TVMD);
@@ -29,5 +29,8 @@ extern pixel_t *dispbuffer;
 extern VideoInterface_struct VIDSoft;
 
 void VIDSoftVdp2DrawScreen(int screen);
+// skip VDP2 drawing and composition in the coming frame, VDP1 still draws
+// since its framebuffers carry over to later frames
+void VIDSoftSetSkipDraw(int skip);
 
 #endif
@@ -27,6 +27,7 @@ include $(imagineSrcDir)/fs/system.mk
 include $(imagineSrcDir)/fs/ArchiveFS.mk
 include $(imagineSrcDir)/io/system.mk
 include $(imagineSrcDir)/io/MapIO.mk
+include $(imagineSrcDir)/io/PatchIO.mk
 include $(imagineSrcDir)/bluetooth/system.mk
 include $(imagineSrcDir)/gui/gui.mk
 include $(imagineSrcDir)/font/system.mk
@@ -35,7 +36,8 @@ include $(imagineSrcDir)/mem/malloc.mk
 include $(imagineSrcDir)/util/system/pagesize.mk
 include $(imagineSrcDir)/logger/system.mk
 include $(buildSysPath)/package/stdc++.mk
-SRC += util/string/generic.cc
+SRC += util/string/generic.cc \
+util/audio/Resampler.cc
 
 libName := imagine$(libNameExt)
 ifndef RELEASE
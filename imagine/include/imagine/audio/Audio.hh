@@ -19,6 +19,9 @@
 #include <imagine/audio/AudioManager.hh>
 #include <imagine/util/audio/PcmFormat.hh>
 #include <system_error>
+#if defined CONFIG_AUDIO_ALSA || defined CONFIG_AUDIO_PULSEAUDIO
+#include <imagine/util/audio/PullBuffer.hh>
+#endif
 
 #if defined CONFIG_AUDIO_ALSA
 #include <imagine/audio/alsa/config.hh>
@@ -31,6 +34,9 @@ namespace Audio
 	namespace Config
 	{
 	#define CONFIG_AUDIO_LATENCY_HINT
+	#if defined CONFIG_AUDIO_ALSA || defined CONFIG_AUDIO_PULSEAUDIO
+	#define CONFIG_AUDIO_PULL_MODE
+	#endif
 	}
 
 struct BufferContext
@@ -65,5 +71,11 @@ void setHintOutputLatency(uint us);
 uint hintOutputLatency();
 void setHintStrictUnderrunCheck(bool on);
 bool hintStrictUnderrunCheck();
+#ifdef CONFIG_AUDIO_PULL_MODE
+// writePcm() queues to a buffer drained by a real-time audio thread, takes effect on the next openPcm()
+void setHintPullMode(bool on);
+bool hintPullMode();
+PullStats pullStats();
+#endif
 int maxRate();
 }
@@ -20,6 +20,8 @@
 
 #if defined CONFIG_BASE_GLIB
 #include <imagine/base/eventloop/GlibEventLoop.hh>
+#elif defined CONFIG_BASE_EPOLL
+#include <imagine/base/eventloop/EpollEventLoop.hh>
 #elif defined __ANDROID__
 #include <imagine/base/eventloop/ALooperEventLoop.hh>
 #elif defined __APPLE__
@@ -60,6 +62,7 @@ public:
 	bool addToEventLoop(EventLoop loop, PollEventDelegate callback, uint events);
 	void addXServerToEventLoop(EventLoop loop);
 	void modifyEvents(uint events);
+	void setPriority(PollPriority priority);
 	void removeFromEventLoop();
 	bool hasEventLoop();
 	int fd() const;
@@ -0,0 +1,79 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <imagine/pixmap/Pixmap.hh>
+#include <imagine/util/rectangle2.h>
+#include <array>
+#include <vector>
+
+namespace Base
+{
+
+class Window;
+
+// Presents CPU-drawn frames to a window without going through GL. When GL
+// only runs on a software rasterizer, as in a VNC session or on a thin
+// client without a GPU, most of the CPU otherwise goes to emulating GL just
+// to scale one texture. Frames are nearest neighbor scaled into an image
+// the size of the window, shared with the X server through MIT-SHM when
+// possible, and everything outside the frame is black. Shared images are
+// double buffered so a frame can be drawn while the server still reads the
+// previous one.
+
+class SoftwarePresenter
+{
+public:
+	SoftwarePresenter() {}
+	~SoftwarePresenter();
+	bool init(Window &win);
+	void deinit();
+	// returns false if the pixmap's format isn't supported
+	bool present(IG::Pixmap pix, IG::WindowRect rect);
+	// redraw the whole window on the next present, such as after GL drew to it
+	void invalidate();
+	static bool supportsFormat(IG::PixelFormat format);
+	explicit operator bool() const { return win; }
+	// called from the X event handler when the server is done reading a shared image
+	void putCompleted(unsigned long shmSeg);
+
+private:
+	struct Image
+	{
+		void *image{}; // XImage
+		unsigned long shmSeg = 0;
+		char *shmAddr{};
+		bool putPending = false;
+		bool needsClear = true;
+	};
+	Window *win{};
+	void *gc{};
+	std::array<Image, 2> img{};
+	uint images = 0;
+	uint nextImg = 0;
+	uint imageW = 0, imageH = 0;
+	IG::WindowRect lastRect{};
+	std::vector<uint> srcX{};
+	bool putAll = true;
+
+	bool makeImages(uint w, uint h);
+	bool makeImage(Image &i, uint w, uint h, bool useShm);
+	void freeImages();
+	void waitForPut(Image &i);
+};
+
+}
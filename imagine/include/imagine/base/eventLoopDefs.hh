@@ -23,4 +23,10 @@ namespace Base
 
 using PollEventDelegate = DelegateFunc<int (int fd, int event)>;
 
+// when several sources are ready, HIGH ones are dispatched first
+enum class PollPriority : uint8
+{
+	DEFAULT, HIGH
+};
+
 }
@@ -0,0 +1,68 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <sys/epoll.h>
+#include <imagine/base/eventLoopDefs.hh>
+#include <memory>
+
+namespace Base
+{
+
+static const int POLLEV_IN = EPOLLIN, POLLEV_OUT = EPOLLOUT, POLLEV_ERR = EPOLLERR, POLLEV_HUP = EPOLLHUP;
+
+struct EpollLoopData;
+
+// owned by the FDEventSource so its address stays fixed while registered with epoll
+struct EpollFDEventSourceInfo
+{
+	PollEventDelegate callback{};
+	EpollLoopData *loop{};
+	EpollFDEventSourceInfo *nextRemoved{};
+	int fd = -1;
+	PollPriority priority = PollPriority::DEFAULT;
+	bool isXServer = false;
+};
+
+class EpollFDEventSource
+{
+public:
+	constexpr EpollFDEventSource() {}
+	constexpr EpollFDEventSource(int fd): fd_{fd} {}
+
+protected:
+	std::unique_ptr<EpollFDEventSourceInfo> info{};
+	int fd_ = -1;
+	PollPriority priority = PollPriority::DEFAULT;
+};
+
+using FDEventSourceImpl = EpollFDEventSource;
+
+class EpollEventLoop
+{
+public:
+	constexpr EpollEventLoop() {}
+	constexpr EpollEventLoop(EpollLoopData *loop): loop{loop} {}
+	int nativeObject();
+	EpollLoopData *loopData() const { return loop; }
+
+protected:
+	EpollLoopData *loop{};
+};
+
+using EventLoopImpl = EpollEventLoop;
+
+}
@@ -26,6 +26,7 @@ protected:
 	GSource2 *source{};
 	gpointer tag{};
 	int fd_ = -1;
+	int priority = G_PRIORITY_DEFAULT;
 };
 
 using FDEventSourceImpl = GlibFDEventSource;
@@ -107,6 +107,8 @@ public:
 	static Renderer makeConfiguredRenderer(IG::PixelFormat pixelFormat, Error &err);
 	void configureRenderer();
 	bool isConfigured() const;
+	// true if GL is emulated on the CPU, like Mesa's llvmpipe
+	bool isSoftwareRasterizer() const;
 	void bind();
 	void unbind();
 	bool restoreBind();
@@ -21,6 +21,7 @@
 #include <imagine/data-type/image/GfxImageSource.hh>
 #include <imagine/gfx/Texture.hh>
 #include <imagine/font/Font.hh>
+#include <imagine/fs/FSDefs.hh>
 #include <system_error>
 #include <memory>
 
@@ -30,19 +31,31 @@ namespace Gfx
 struct GlyphEntry
 {
 	Gfx::PixmapTexture glyph{};
+	Gfx::PixmapTexture *atlas{}; // set instead of glyph when packed in the font's atlas
+	IG::Rect2<GTexC> atlasUV{};
 	IG::GlyphMetrics metrics{};
 
 	constexpr GlyphEntry() {}
+	Texture &texture() { return atlas ? *atlas : glyph; }
+	IG::Rect2<GTexC> uvBounds() const { return atlas ? atlasUV : glyph.uvBounds(); }
+	explicit operator bool() const { return atlas || (bool)glyph; }
 };
 
+struct GlyphAtlasBuild;
+
+// Fonts with an atlas name pack their common characters into one texture so
+// text using them draws in a single batch. The atlas is rasterized on a
+// worker thread after each size change, or read from a cache file named
+// after the font and pixel size in the documents path when there is one.
+
 class GlyphTextureSet
 {
 public:
 	IG::FontSettings settings{};
 	static constexpr bool supportsUnicode = Config::UNICODE_CHARS;
 
-	GlyphTextureSet() {}
-	GlyphTextureSet(Renderer &r, std::unique_ptr<IG::Font> font, IG::FontSettings set);
+	GlyphTextureSet();
+	GlyphTextureSet(Renderer &r, std::unique_ptr<IG::Font> font, IG::FontSettings set, const char *atlasName = {});
 	GlyphTextureSet(Renderer &r, const char *path, IG::FontSettings set);
 	GlyphTextureSet(Renderer &r, GenericIO io, IG::FontSettings set);
 	static GlyphTextureSet makeSystem(Renderer &r, IG::FontSettings set);
@@ -70,10 +83,17 @@ private:
 	IG::FontSize faceSize{};
 	uint nominalHeight_ = 0;
 	uint32 usedGlyphTableBits = 0;
+	FS::FileString atlasName{};
+	std::unique_ptr<PixmapTexture> atlas{};
+	std::unique_ptr<GlyphAtlasBuild> atlasBuild{};
 
 	void calcNominalHeight(Renderer &r);
 	bool initGlyphTable();
 	std::errc cacheChar(Renderer &r, int c, int tableIdx);
+	void startAtlasBuild();
+	void waitForAtlasBuild();
+	void applyAtlas(Renderer &r);
+	void freeAtlas();
 };
 
 }
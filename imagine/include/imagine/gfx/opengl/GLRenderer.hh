@@ -54,6 +54,7 @@ public:
 	bool shouldSpecifyDrawReadBuffers = false;
 	bool hasDebugOutput = false;
 	bool useLegacyGLSL = Config::Gfx::OPENGL_ES;
+	bool isSoftwareRasterizer = false;
 	#ifdef __ANDROID__
 	bool hasEGLImages = false;
 	bool hasExternalEGLImages = false;
@@ -187,6 +187,11 @@ void startKeyRepeatTimer(Event event);
 void cancelKeyRepeatTimer();
 void deinitKeyRepeatTimer();
 
+#ifdef CONFIG_INPUT_EVDEV
+// dispatch events already read by the input thread, call right before input is sampled
+void flushEvents();
+#endif
+
 IG::Point2D<int> transformInputPos(const Base::Window &win, IG::Point2D<int> srcPos);
 
 using DeviceChangeDelegate = DelegateFunc<void (const Device &dev, Device::Change change)>;
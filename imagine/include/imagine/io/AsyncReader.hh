@@ -0,0 +1,88 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+
+#include <imagine/config/defs.hh>
+#include <imagine/thread/Thread.hh>
+#include <imagine/thread/Semaphore.hh>
+#include <imagine/util/DelegateFunc.hh>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <sys/types.h>
+
+// Runs file reads in the background so data can be requested before it's
+// needed instead of stalling the caller on slow storage. On Linux a batch of
+// reads goes to io_uring with a single system call, otherwise, or if the
+// kernel doesn't allow io_uring, a small pool of threads runs them with
+// pread(). Completion delegates run on the thread calling
+// processCompletions() or wait(), and only that thread may use the reader.
+
+class AsyncReader
+{
+public:
+	// receives the bytes read or a negative errno
+	using OnCompleteDelegate = DelegateFunc<void (ssize_t result)>;
+
+	struct Request
+	{
+		int fd = -1;
+		void *buf{};
+		size_t bytes = 0;
+		off_t offset = 0;
+		OnCompleteDelegate onComplete{};
+	};
+
+	AsyncReader();
+	~AsyncReader();
+	AsyncReader(const AsyncReader &) = delete;
+	AsyncReader &operator=(const AsyncReader &) = delete;
+	bool init(uint maxPending = 32);
+	void deinit();
+	// returns how many requests were queued, fewer than count if too many are pending
+	uint read(const Request *req, uint count);
+	bool read(Request req) { return read(&req, 1); }
+	// runs the delegates of finished reads without blocking, returns how many ran
+	uint processCompletions();
+	// blocks until a pending read finishes, returns how many delegates ran
+	uint wait();
+	uint pending() const { return pendingReads; }
+	bool usesIOUring() const;
+	explicit operator bool() const { return maxPending; }
+
+private:
+	struct Slot;
+	struct Ring;
+	std::unique_ptr<Slot[]> slot{};
+	std::unique_ptr<Ring> ring{};
+	std::vector<IG::thread> worker{};
+	std::unique_ptr<IG::Semaphore> workSem{}, doneSem{};
+	std::atomic_bool quitWorkers{};
+	uint maxPending = 0;
+	uint pendingReads = 0;
+	uint nextSeq = 0;
+
+	int freeSlot() const;
+	bool initRing();
+	void deinitRing();
+	bool submitToRing(const Request *req, uint count, uint &queued);
+	uint reapRing();
+	void startWorkers(uint threads);
+	void runWorker();
+	uint reapWorkers();
+	uint complete(uint idx, ssize_t result);
+};
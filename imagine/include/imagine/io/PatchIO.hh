@@ -0,0 +1,91 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+
+#include <imagine/config/defs.hh>
+#include <imagine/io/IO.hh>
+#include <map>
+#include <vector>
+
+// Presents a ROM with an IPS, UPS, or BPS patch applied without making a
+// patched copy of it. The patch is parsed once into a map of output ranges,
+// each either read from the original IO, or from a buffer holding the bytes
+// the patch changed, so a small translation patch on a large ROM costs only
+// the size of its changes. Reads go through to the original IO, which stays
+// memory mapped if it was, but mmapConst() returns null since the patched
+// data isn't contiguous. Sources without a memory map, such as ArchiveIO
+// streams that can't seek, are read into memory first.
+
+class PatchIO : public IO
+{
+public:
+	using IOUtils::read;
+	using IOUtils::readAtPos;
+	using IOUtils::write;
+	using IOUtils::seek;
+
+	enum class Format : uint8 { NONE, IPS, UPS, BPS };
+
+	PatchIO() {}
+	~PatchIO() final;
+	PatchIO(PatchIO &&o) = default;
+	PatchIO &operator=(PatchIO &&o) = default;
+	GenericIO makeGeneric();
+	// takes ownership of the source on success, the patch is only read during the call
+	std::error_code open(GenericIO &source, IO &patch);
+	Format format() const { return format_; }
+	// number of bytes held in memory for patched ranges
+	size_t patchedBytes() const { return patchData.size(); }
+
+	ssize_t read(void *buff, size_t bytes, std::error_code *ecOut) final;
+	ssize_t readAtPos(void *buff, size_t bytes, off_t offset, std::error_code *ecOut) final;
+	ssize_t write(const void *buff, size_t bytes, std::error_code *ecOut) final;
+	off_t seek(off_t offset, IO::SeekMode mode, std::error_code *ecOut) final;
+	void close() final;
+	size_t size() final;
+	bool eof() final;
+	void advise(off_t offset, size_t bytes, Advice advice) final;
+	explicit operator bool() final;
+
+private:
+	enum class Source : uint8 { ORIGINAL, PATCH, ZERO };
+
+	struct Extent
+	{
+		size_t size;
+		size_t offset; // into the original IO or patchData
+		Source src;
+	};
+
+	GenericIO src{};
+	std::map<size_t, Extent> extent{}; // keyed by output offset
+	std::vector<char> patchData{};
+	size_t outSize = 0;
+	size_t pos = 0;
+	Format format_ = Format::NONE;
+
+	void reset();
+	std::map<size_t, Extent>::iterator splitAt(size_t outOffset);
+	void addExtent(size_t outOffset, Extent e);
+	char *overlay(size_t outOffset, size_t size);
+	void resize(size_t size);
+	bool sourceMatches(size_t size, uint32 crc);
+	bool readExtents(char *buff, size_t bytes, size_t offset);
+	std::error_code parseIPS(const char *patch, size_t patchSize);
+	std::error_code parseUPS(const char *patch, size_t patchSize);
+	std::error_code parseBPS(const char *patch, size_t patchSize);
+};
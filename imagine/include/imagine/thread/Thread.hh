@@ -37,6 +37,7 @@ public:
 	template<class Function>
 	explicit thread(Function&& f) : ThreadImpl{f} {}
 	thread(const thread&) = delete;
+	thread &operator=(thread&& other);
 	bool joinable() const;
 	id get_id() const;
 	void join();
@@ -47,6 +48,9 @@ namespace this_thread
 {
 
 thread::id get_id();
+// raise the calling thread to real-time scheduling if the system allows it,
+// for threads that must wake on time such as for audio or input
+bool setRealtimePriority();
 
 }
 
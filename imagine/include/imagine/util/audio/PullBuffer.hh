@@ -0,0 +1,74 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <imagine/util/audio/PcmFormat.hh>
+#include <imagine/util/ringbuffer/RingBuffer.hh>
+#include <atomic>
+#include <vector>
+
+namespace Audio
+{
+
+// Ring buffer between the thread producing samples and an audio thread that
+// pulls them on the device's schedule. Only one thread may write and one may
+// read. A read always returns the requested frames, on underrun the last
+// samples played are repeated while fading out and the next real samples fade
+// back in, which is far less audible than a gap of silence.
+
+struct PullStats
+{
+	uint underruns = 0; // reads that came up short after a successful one
+	uint concealedFrames = 0;
+	uint droppedFrames = 0; // writes past the end of the buffer
+	uint minQueuedFrames = 0; // lowest fill level seen by a read
+};
+
+class PullBuffer
+{
+public:
+	PullBuffer() {}
+	bool init(PcmFormat format, uint frames);
+	void deinit();
+	// call only while the reading thread is stopped
+	void reset();
+	// returns the number of frames written
+	uint write(const void *samples, uint frames);
+	void read(void *samples, uint frames);
+	uint framesQueued() const;
+	uint framesFree() const;
+	uint capacity() const { return capacityFrames; }
+	PullStats stats() const;
+	void resetStats();
+	explicit operator bool() const { return capacityFrames; }
+
+private:
+	StaticRingBuffer<> rBuff{};
+	PcmFormat format{};
+	std::vector<char> lastSamples{}; // tail of the last read for concealment
+	uint lastFrames = 0;
+	uint fadeFrames = 0;
+	uint capacityFrames = 0;
+	uint gain = 0; // 0 - fadeFrames, fadeFrames is full volume
+	bool underrun = false;
+	std::atomic_uint underruns{}, concealedFrames{}, droppedFrames{}, minQueuedFrames{};
+
+	void conceal(char *samples, uint frames);
+	void fadeIn(char *samples, uint frames);
+};
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <imagine/config/defs.hh>
+#include <vector>
+
+namespace Audio
+{
+
+// Polyphase windowed-sinc resampler for interleaved signed 16-bit PCM.
+// Filters are stored as Q15 coefficients and the inner product runs with
+// SSE2 or NEON when the target has them. Meant for cores that render audio
+// at their native rate, the ratio adjustment lets the caller nudge the
+// output rate to keep the audio buffer at its target fill level.
+
+class Resampler
+{
+public:
+	enum class Quality : uint8
+	{
+		LOW, // 8 taps
+		MEDIUM, // 16 taps
+		HIGH // 32 taps
+	};
+
+	static constexpr uint MAX_CHANNELS = 2;
+
+	Resampler() {}
+	void init(double inputRate, double outputRate, uint channels, Quality quality = Quality::MEDIUM);
+	void deinit();
+	void reset();
+	// scales the output rate, 1.0 is the rate passed to init()
+	void setRatioAdjust(double adjust);
+	double inputRate() const { return inRate; }
+	double outputRate() const { return outRate; }
+	uint channelCount() const { return channels; }
+	uint maxOutputFrames(uint inputFrames) const;
+	// returns the number of frames written to out
+	uint resample(int16 *out, const int16 *in, uint inputFrames);
+	explicit operator bool() const { return taps; }
+
+private:
+	std::vector<int16> coeff{}; // taps coefficients for each phase
+	std::vector<int16> history[MAX_CHANNELS]{}; // deinterleaved input, taps - 1 frames of history
+	uint64_t pos = 0; // 32.32 fixed point position in history
+	uint64_t step = 0;
+	double inRate = 0, outRate = 0;
+	uint taps = 0;
+	uint channels = 0;
+};
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <algorithm>
+#include <memory>
+#include <new>
+#include <utility>
 
 namespace IG
 {
@@ -72,6 +75,35 @@ public:
 
 #define forEachInContainer(container, it) for(IG::ForEachIteratorWrapper<decltype(container)> it {container, (container).begin()}; it != (container).end(); ++it)
 
+// leaves value-initialized elements default-initialized instead, so
+// resizing a vector used as a scratch buffer doesn't clear it first
+template <class T, class Alloc = std::allocator<T>>
+class NoInitAllocator : public Alloc
+{
+public:
+	using AllocTraits = std::allocator_traits<Alloc>;
+
+	template <class U>
+	struct rebind
+	{
+		using other = NoInitAllocator<U, typename AllocTraits::template rebind_alloc<U>>;
+	};
+
+	using Alloc::Alloc;
+
+	template <class U>
+	void construct(U *p)
+	{
+		::new((void*)p) U;
+	}
+
+	template <class U, class... Args>
+	void construct(U *p, Args&&... args)
+	{
+		AllocTraits::construct(static_cast<Alloc&>(*this), p, std::forward<Args>(args)...);
+	}
+};
+
 template <class C, class T>
 static bool removeFirst(C &c, const T &val)
 {
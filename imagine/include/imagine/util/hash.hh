@@ -0,0 +1,152 @@
+#pragma once
+
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#if defined __x86_64__ || defined __i386__
+#include <nmmintrin.h>
+#elif defined __ARM_FEATURE_CRC32
+#include <arm_acle.h>
+#endif
+
+namespace IG
+{
+
+// Fast non-cryptographic hash for detecting changes in memory blocks,
+// consumes 8 bytes per step so it's cheap enough to run between frames
+inline uint32_t hashBytes(const void *data, size_t size, uint64_t seed = 0xcbf29ce484222325)
+{
+	constexpr uint64_t prime = 0x100000001b3;
+	auto bytes = (const uint8_t*)data;
+	uint64_t h = seed ^ size;
+	while(size >= 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, bytes, 8);
+		h = (h ^ word) * prime;
+		h ^= h >> 29;
+		bytes += 8;
+		size -= 8;
+	}
+	while(size--)
+	{
+		h = (h ^ *bytes++) * prime;
+	}
+	h ^= h >> 32;
+	return h;
+}
+
+namespace CRC32CImpl
+{
+
+inline uint32_t software(const uint8_t *bytes, size_t size, uint32_t crc)
+{
+	static constexpr auto table =
+		[]()
+		{
+			std::array<uint32_t, 256> table{};
+			for(uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t c = i;
+				for(int b = 0; b < 8; b++)
+					c = (c >> 1) ^ (0x82F63B78 & -(c & 1));
+				table[i] = c;
+			}
+			return table;
+		}();
+	while(size--)
+	{
+		crc = table[(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+#if defined __x86_64__ || defined __i386__
+[[gnu::target("sse4.2")]]
+inline uint32_t hardware(const uint8_t *bytes, size_t size, uint32_t crc)
+{
+	while(size >= 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, bytes, 8);
+		#if defined __x86_64__
+		crc = _mm_crc32_u64(crc, word);
+		#else
+		crc = _mm_crc32_u32(crc, (uint32_t)word);
+		crc = _mm_crc32_u32(crc, (uint32_t)(word >> 32));
+		#endif
+		bytes += 8;
+		size -= 8;
+	}
+	while(size--)
+	{
+		crc = _mm_crc32_u8(crc, *bytes++);
+	}
+	return crc;
+}
+
+inline bool hasHardware()
+{
+	#if defined __SSE4_2__
+	return true;
+	#else
+	static const bool hasSSE42 = __builtin_cpu_supports("sse4.2");
+	return hasSSE42;
+	#endif
+}
+#elif defined __ARM_FEATURE_CRC32
+inline uint32_t hardware(const uint8_t *bytes, size_t size, uint32_t crc)
+{
+	while(size >= 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, bytes, 8);
+		crc = __crc32cd(crc, word);
+		bytes += 8;
+		size -= 8;
+	}
+	while(size--)
+	{
+		crc = __crc32cb(crc, *bytes++);
+	}
+	return crc;
+}
+
+constexpr bool hasHardware() { return true; }
+#else
+inline uint32_t hardware(const uint8_t *bytes, size_t size, uint32_t crc) { return software(bytes, size, crc); }
+
+constexpr bool hasHardware() { return false; }
+#endif
+
+}
+
+// CRC-32C (Castagnoli), uses SSE4.2 on x86 CPUs that report it at runtime
+// or the ARMv8 CRC instructions when the target has them, the software
+// version produces the same values so results can be compared across builds
+inline uint32_t crc32c(const void *data, size_t size, uint32_t crc = 0)
+{
+	auto bytes = (const uint8_t*)data;
+	if(CRC32CImpl::hasHardware())
+		return ~CRC32CImpl::hardware(bytes, size, ~crc);
+	else
+		return ~CRC32CImpl::software(bytes, size, ~crc);
+}
+
+}
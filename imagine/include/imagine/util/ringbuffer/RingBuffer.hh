@@ -68,6 +68,11 @@ public:
 		return written;
 	}
 
+	SIZE writtenContiguousSize() const
+	{
+		return std::min((SIZE)written, (SIZE)(((uintptr_t)buff + buffSize) - (uintptr_t)start));
+	}
+
 	SIZE write(const void *buff, SIZE size)
 	{
 		if(size > freeSpace())
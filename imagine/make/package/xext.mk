@@ -0,0 +1,6 @@
+ifndef inc_pkg_xext
+inc_pkg_xext := 1
+
+pkgConfigDeps += xext
+
+endif
\ No newline at end of file
@@ -23,9 +23,11 @@
 #include <alsa/asoundlib.h>
 #include <sys/time.h>
 #include <math.h>
+#include <algorithm>
 #include <imagine/audio/Audio.hh>
 #include <imagine/logger/logger.h>
 #include <imagine/base/Base.hh>
+#include <imagine/thread/Thread.hh>
 #include "alsautils.h"
 
 namespace Audio
@@ -33,9 +35,13 @@ namespace Audio
 
 PcmFormat pcmFormat;
 static snd_pcm_t *pcmHnd{};
-static snd_pcm_uframes_t bufferSize, periodSize;
+static snd_pcm_uframes_t bufferSize, periodSize, startThreshold;
 static bool useMmap;
 static uint wantedLatency = 100000;
+static bool pullMode = false;
+static PullBuffer pullBuff{};
+static IG::thread pullThread{};
+static std::atomic_bool pullThreadRunning{false};
 
 int maxRate()
 {
@@ -52,6 +58,21 @@ uint hintOutputLatency()
 	return wantedLatency;
 }
 
+void setHintPullMode(bool on)
+{
+	pullMode = on;
+}
+
+bool hintPullMode()
+{
+	return pullMode;
+}
+
+PullStats pullStats()
+{
+	return pullBuff.stats();
+}
+
 static const SampleFormat &alsaFormatToPcm(snd_pcm_format_t format)
 {
 	switch(format)
@@ -83,13 +104,11 @@ int frameDelay()
 		return 0;
 	snd_pcm_sframes_t delay;
 	snd_pcm_delay(pcmHnd, &delay);
-	return delay;
+	return delay + (pullBuff ? pullBuff.framesQueued() : 0);
 }
 
-int framesFree()
+static int hwFramesFree()
 {
-	if(unlikely(!isOpen()))
-		return 0;
 	auto frames = snd_pcm_avail_update(pcmHnd);
 	if(frames < 0)
 	{
@@ -99,11 +118,24 @@ int framesFree()
 	return frames;
 }
 
+int framesFree()
+{
+	if(unlikely(!isOpen()))
+		return 0;
+	if(pullBuff)
+		return pullBuff.framesFree();
+	return hwFramesFree();
+}
+
+static void startPullThread();
+static void stopPullThread();
+
 void pausePcm()
 {
 	if(unlikely(!isOpen()))
 		return;
 	logMsg("pausing playback");
+	stopPullThread();
 	snd_pcm_pause(pcmHnd, 1);
 }
 
@@ -116,6 +148,9 @@ void resumePcm()
 	switch(state)
 	{
 		bcase SND_PCM_STATE_PREPARED:
+			// the pull thread starts the stream once it fills the device buffer
+			if(pullBuff)
+				break;
 			logMsg("starting PCM");
 			snd_pcm_start(pcmHnd);
 		bcase SND_PCM_STATE_PAUSED:
@@ -125,6 +160,7 @@ void resumePcm()
 			logMsg("resuming PCM");
 			snd_pcm_resume(pcmHnd);
 	}
+	startPullThread();
 }
 
 void clearPcm()
@@ -132,6 +168,8 @@ void clearPcm()
 	if(unlikely(!isOpen()))
 		return;
 	logMsg("clearing queued samples");
+	if(pullBuff && !pullThreadRunning)
+		pullBuff.reset();
 	snd_pcm_drop(pcmHnd);
 	snd_pcm_prepare(pcmHnd);
 }
@@ -188,19 +226,27 @@ public:
 	}
 };
 
-void writePcm(const void *samples, uint framesToWrite)
-{
-	if(unlikely(!isOpen()))
-		return;
+static AlsaMmapContext mmapCtx{};
 
-	auto framesFreeOnHW = framesFree();
+// snd_pcm_mmap_writei() starts the stream itself, do the same once enough frames are queued
+static void startAtThreshold()
+{
+	if(snd_pcm_state(pcmHnd) == SND_PCM_STATE_PREPARED
+		&& bufferSize - std::max(hwFramesFree(), 0) >= startThreshold)
+	{
+		snd_pcm_start(pcmHnd);
+	}
+}
 
-	// verify PCM state
+// returns the frames free after bringing the PCM back into a writable state
+static int prepareForWrite()
+{
+	auto framesFreeOnHW = hwFramesFree();
 	switch((int)snd_pcm_state(pcmHnd))
 	{
 		bcase SND_PCM_STATE_XRUN:
 			snd_pcm_recover(pcmHnd, -EPIPE, 0);
-			framesFreeOnHW = framesFree();
+			framesFreeOnHW = hwFramesFree();
 			logMsg("recovered from xrun, %d frames free", framesFreeOnHW);
 		bcase SND_PCM_STATE_PAUSED:
 			logMsg("unpausing PCM");
@@ -209,6 +255,46 @@ void writePcm(const void *samples, uint framesToWrite)
 			logMsg("resuming PCM");
 			snd_pcm_resume(pcmHnd);
 	}
+	return framesFreeOnHW;
+}
+
+BufferContext getPlayBuffer(uint wantedFrames)
+{
+	if(unlikely(!isOpen()) || !useMmap || pullBuff)
+		return {};
+	auto framesFreeOnHW = prepareForWrite();
+	if(framesFreeOnHW <= 0)
+		return {};
+	// the returned area may be smaller than the free space when it wraps around the ring buffer
+	snd_pcm_uframes_t frames = std::min(wantedFrames, (uint)framesFreeOnHW);
+	if(mmapCtx.begin(pcmHnd, &frames) != OK)
+		return {};
+	return mmapCtx;
+}
+
+void commitPlayBuffer(BufferContext buffer, uint frames)
+{
+	assert(buffer.data == mmapCtx.data);
+	assert(frames <= buffer.frames);
+	mmapCtx.commit(frames);
+	mmapCtx = {};
+	startAtThreshold();
+}
+
+void writePcm(const void *samples, uint framesToWrite)
+{
+	if(unlikely(!isOpen()))
+		return;
+
+	if(pullBuff)
+	{
+		auto written = pullBuff.write(samples, framesToWrite);
+		if(written != framesToWrite)
+			logWarn("only %d of %d frames queued", written, framesToWrite);
+		return;
+	}
+
+	auto framesFreeOnHW = prepareForWrite();
 
 	//logMsg("writing %d frames, %d free", framesToWrite, framesFreeOnHW);
 
@@ -233,22 +319,6 @@ void writePcm(const void *samples, uint framesToWrite)
 	if(useMmap)
 	{
 		written = snd_pcm_mmap_writei(pcmHnd, samples, framesToWrite);
-		/*AlsaMmapContext ctx;
-		//logMsg("starting mmap loop");
-		auto samplePtr = (char*)samples;
-		for(snd_pcm_uframes_t frames; framesToWrite; framesToWrite -= frames)
-		{
-			frames = framesToWrite;
-			if(ctx.begin(pcmHnd, &frames) != OK)
-				return;
-			assert(frames <= framesToWrite);
-
-			memcpy(ctx.data, samples, pcmFormat.framesToBytes(frames));
-			samplePtr += pcmFormat.framesToBytes(frames);
-
-			if(ctx.commit(frames) != OK)
-				return;
-		}*/
 	}
 	else
 	{
@@ -265,6 +335,75 @@ void writePcm(const void *samples, uint framesToWrite)
 	}
 }
 
+// fills the device buffer a period at a time from pullBuff, concealing any shortfall
+static void runPullThread()
+{
+	IG::this_thread::setRealtimePriority();
+	// fixed size so stack use doesn't depend on the device's period size
+	char writeBuff[16 * 1024];
+	const uint writeBuffFrames = sizeof(writeBuff) / pcmFormat.framesToBytes(1);
+	while(pullThreadRunning.load(std::memory_order_relaxed))
+	{
+		auto framesFreeOnHW = prepareForWrite();
+		if(framesFreeOnHW < (int)periodSize)
+		{
+			snd_pcm_wait(pcmHnd, 20);
+			continue;
+		}
+		uint frames = framesFreeOnHW - framesFreeOnHW % periodSize;
+		if(useMmap)
+		{
+			AlsaMmapContext ctx;
+			while(frames)
+			{
+				snd_pcm_uframes_t ctxFrames = frames;
+				if(ctx.begin(pcmHnd, &ctxFrames) != OK)
+					break;
+				pullBuff.read(ctx.data, ctxFrames);
+				if(ctx.commit(ctxFrames) != OK)
+					break;
+				frames -= ctxFrames;
+			}
+			startAtThreshold();
+		}
+		else
+		{
+			while(frames)
+			{
+				uint writeFrames = std::min(frames, writeBuffFrames);
+				pullBuff.read(writeBuff, writeFrames);
+				auto written = snd_pcm_writei(pcmHnd, writeBuff, writeFrames);
+				if(written < 0)
+				{
+					logWarn("error writing %u frames: %s", writeFrames, alsaPcmWriteErrorToString(written));
+					break;
+				}
+				frames -= writeFrames;
+			}
+		}
+	}
+}
+
+static void startPullThread()
+{
+	if(!pullBuff || pullThreadRunning)
+		return;
+	logMsg("starting pull thread with %u/%u frames queued", pullBuff.framesQueued(), pullBuff.capacity());
+	pullThreadRunning = true;
+	pullThread = IG::thread{runPullThread};
+}
+
+static void stopPullThread()
+{
+	if(!pullThreadRunning)
+		return;
+	pullThreadRunning = false;
+	pullThread.join();
+	auto stats = pullBuff.stats();
+	logMsg("stopped pull thread, %u underruns, %u frames concealed, %u dropped, %u min queued",
+		stats.underruns, stats.concealedFrames, stats.droppedFrames, stats.minQueuedFrames);
+}
+
 static int setupPcm(const PcmFormat &format, snd_pcm_access_t access)
 {
 	int alsalibResample = 1;
@@ -275,7 +414,7 @@ static int setupPcm(const PcmFormat &format, snd_pcm_access_t access)
 		format.channels,
 		format.rate,
 		alsalibResample,
-		wantedLatency)) < 0)
+		pullMode ? wantedLatency / 2 : wantedLatency)) < 0)
 	{
 		logErr("Error setting pcm parameters: %s", snd_strerror(err));
 		return err;
@@ -294,6 +433,13 @@ static int setupPcm(const PcmFormat &format, snd_pcm_access_t access)
 	else
 	{
 		logMsg("buffer size %u, period size %u, mmap %d", (uint)bufferSize, (uint)periodSize, useMmap);
+		snd_pcm_sw_params_t *swParams;
+		snd_pcm_sw_params_alloca(&swParams);
+		if(snd_pcm_sw_params_current(pcmHnd, swParams) < 0
+			|| snd_pcm_sw_params_get_start_threshold(swParams, &startThreshold) < 0)
+		{
+			startThreshold = bufferSize;
+		}
 		return 0;
 	}
 }
@@ -339,6 +485,15 @@ static std::error_code openAlsaPcm(const PcmFormat &format)
 	//snd_pcm_dump(alsaHnd, output);
 	//logMsg("pcm state: %s", alsaPcmStateToString(snd_pcm_state(pcmHnd)));
 
+	if(pullMode)
+	{
+		// split the latency between the device and the queue feeding the pull thread
+		if(!pullBuff.init(format, std::max(format.uSecsToFrames(wantedLatency / 2), (uint)periodSize * 2)))
+		{
+			logErr("error allocating pull buffer, using push mode");
+		}
+	}
+
 	return {};
 
 	CLEANUP:
@@ -357,6 +512,8 @@ static void closeAlsaPcm()
 	if(isOpen())
 	{
 		logDMsg("closing pcm");
+		stopPullThread();
+		pullBuff.deinit();
 		snd_pcm_close(pcmHnd);
 		pcmHnd = nullptr;
 	}
@@ -390,6 +547,8 @@ bool isOpen()
 
 bool isPlaying()
 {
+	if(pullBuff)
+		return pullThreadRunning;
 	return isOpen() && snd_pcm_state(pcmHnd) == SND_PCM_STATE_RUNNING;
 }
 
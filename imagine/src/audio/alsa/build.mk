@@ -5,6 +5,9 @@ include $(IMAGINE_PATH)/make/package/alsa.mk
 
 configDefs += CONFIG_AUDIO CONFIG_AUDIO_ALSA
 
-SRC += audio/alsa/alsa.cc
+include $(imagineSrcDir)/thread/system.mk
+
+SRC += audio/alsa/alsa.cc \
+util/audio/PullBuffer.cc
 
 endif
@@ -10,6 +10,9 @@ else
  include $(IMAGINE_PATH)/make/package/pulseaudio.mk
 endif
 
-SRC += audio/pulseaudio/pulseaudio.cc
+include $(imagineSrcDir)/thread/system.mk
+
+SRC += audio/pulseaudio/pulseaudio.cc \
+util/audio/PullBuffer.cc
 
 endif
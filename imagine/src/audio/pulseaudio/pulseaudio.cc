@@ -18,7 +18,9 @@
 #include <imagine/logger/logger.h>
 #include <imagine/base/Base.hh>
 #include <imagine/util/ScopeGuard.hh>
+#include <imagine/thread/Thread.hh>
 #include <pulse/pulseaudio.h>
+#include <algorithm>
 #ifdef CONFIG_AUDIO_PULSEAUDIO_GLIB
 #include <pulse/glib-mainloop.h>
 #else
@@ -33,6 +35,8 @@ static uint wantedLatency = 100000;
 static pa_context* context{};
 static pa_stream* stream{};
 static bool isCorked = true;
+static bool pullMode = false;
+static PullBuffer pullBuff{};
 
 #ifdef CONFIG_AUDIO_PULSEAUDIO_GLIB
 static pa_glib_mainloop* mainloop{};
@@ -155,6 +159,21 @@ uint hintOutputLatency()
 	return wantedLatency;
 }
 
+void setHintPullMode(bool on)
+{
+	pullMode = on;
+}
+
+bool hintPullMode()
+{
+	return pullMode;
+}
+
+PullStats pullStats()
+{
+	return pullBuff.stats();
+}
+
 int frameDelay()
 {
 	if(unlikely(!isOpen()))
@@ -170,13 +189,15 @@ int frameDelay()
 		logErr("error getting stream latency");
 		return 0;
 	}
-	return pcmFormat.uSecsToFrames(delay);
+	return pcmFormat.uSecsToFrames(delay) + (pullBuff ? pullBuff.framesQueued() : 0);
 }
 
 int framesFree()
 {
 	if(unlikely(!isOpen()))
 		return 0;
+	if(pullBuff)
+		return pullBuff.framesFree();
 	iterateMainLoop();
 	lockMainLoop();
 	auto bytes = pa_stream_writable_size(stream);
@@ -214,6 +235,9 @@ void clearPcm()
 	logMsg("clearing queued samples");
 	lockMainLoop();
 	pa_stream_flush(stream, nullptr, nullptr);
+	// the write callback runs with the main loop locked
+	if(pullBuff)
+		pullBuff.reset();
 	unlockMainLoop();
 	iterateMainLoop();
 }
@@ -223,6 +247,15 @@ void writePcm(const void *samples, uint framesToWrite)
 	if(unlikely(!isOpen()))
 		return;
 
+	if(pullBuff)
+	{
+		auto written = pullBuff.write(samples, framesToWrite);
+		if(written != framesToWrite)
+			logWarn("only %d of %d frames queued", written, framesToWrite);
+		iterateMainLoop();
+		return;
+	}
+
 	iterateMainLoop();
 	lockMainLoop(); // TODO: locking here is sub-optimal, writes should be async using a ring-buffer
 	auto bytesFreeOnHW = pa_stream_writable_size(stream);
@@ -254,6 +287,42 @@ void writePcm(const void *samples, uint framesToWrite)
 	iterateMainLoop();
 }
 
+BufferContext getPlayBuffer(uint wantedFrames)
+{
+	if(unlikely(!isOpen()) || pullBuff)
+		return {};
+	iterateMainLoop();
+	lockMainLoop();
+	auto bytes = std::min(pcmFormat.framesToBytes(wantedFrames), (uint)pa_stream_writable_size(stream));
+	size_t nbytes = bytes;
+	void *data{};
+	// the server's memblock is written in place and handed back in commitPlayBuffer()
+	if(!bytes || pa_stream_begin_write(stream, &data, &nbytes) < 0 || !data)
+	{
+		unlockMainLoop();
+		return {};
+	}
+	unlockMainLoop();
+	return {data, pcmFormat.bytesToFrames(std::min((size_t)bytes, nbytes))};
+}
+
+void commitPlayBuffer(BufferContext buffer, uint frames)
+{
+	assert(frames <= buffer.frames);
+	lockMainLoop();
+	int err = 0;
+	if(frames)
+		err = pa_stream_write(stream, buffer.data, pcmFormat.framesToBytes(frames), nullptr, 0, PA_SEEK_RELATIVE);
+	else
+		pa_stream_cancel_write(stream);
+	unlockMainLoop();
+	if(err < 0)
+	{
+		logWarn("error committing %d frames", frames);
+	}
+	iterateMainLoop();
+}
+
 static std::error_code init()
 {
 	#ifdef CONFIG_AUDIO_PULSEAUDIO_GLIB
@@ -313,6 +382,40 @@ static std::error_code init()
 	return {};
 }
 
+// called from the main loop when the server wants more data, fills it from pullBuff
+static void pullWriteCallback(pa_stream *stream, size_t nbytes, void *)
+{
+	#ifndef CONFIG_AUDIO_PULSEAUDIO_GLIB
+	static bool isRealtime = false;
+	if(!isRealtime)
+	{
+		IG::this_thread::setRealtimePriority();
+		isRealtime = true;
+	}
+	#endif
+	while(nbytes)
+	{
+		size_t bytes = nbytes;
+		void *data{};
+		if(pa_stream_begin_write(stream, &data, &bytes) < 0 || !data || !bytes)
+		{
+			logWarn("error getting write buffer for %d bytes", (int)nbytes);
+			return;
+		}
+		bytes = std::min(bytes, nbytes);
+		uint frames = pcmFormat.bytesToFrames(bytes);
+		if(!frames)
+		{
+			pa_stream_cancel_write(stream);
+			return;
+		}
+		pullBuff.read(data, frames);
+		bytes = pcmFormat.framesToBytes(frames);
+		pa_stream_write(stream, data, bytes, nullptr, 0, PA_SEEK_RELATIVE);
+		nbytes -= bytes;
+	}
+}
+
 std::error_code openPcm(const PcmFormat &format)
 {
 	if(isOpen())
@@ -360,12 +463,24 @@ std::error_code openPcm(const PcmFormat &format)
 		}, &finalState);
 	pa_buffer_attr bufferAttr {0};
 	bufferAttr.maxlength = -1;
-	bufferAttr.tlength = format.uSecsToBytes(wantedLatency);
+	bufferAttr.tlength = format.uSecsToBytes(pullMode ? wantedLatency / 2 : wantedLatency);
 	bufferAttr.prebuf = -1;
 	bufferAttr.minreq = -1;
+	uint streamFlags = PA_STREAM_ADJUST_LATENCY /*| PA_STREAM_AUTO_TIMING_UPDATE | PA_STREAM_INTERPOLATE_TIMING*/;
+	if(pullMode)
+	{
+		// split the latency between the server and the queue feeding the write callback,
+		// which only starts pulling once resumePcm() uncorks the stream
+		if(pullBuff.init(format, format.uSecsToFrames(wantedLatency / 2)))
+		{
+			pa_stream_set_write_callback(stream, pullWriteCallback, nullptr);
+			streamFlags |= PA_STREAM_START_CORKED;
+		}
+		else
+			logErr("error allocating pull buffer, using push mode");
+	}
 	if(pa_stream_connect_playback(stream, nullptr, &bufferAttr,
-		pa_stream_flags_t(PA_STREAM_ADJUST_LATENCY /*| PA_STREAM_AUTO_TIMING_UPDATE | PA_STREAM_INTERPOLATE_TIMING*/),
-		nullptr, nullptr) < 0)
+		pa_stream_flags_t(streamFlags), nullptr, nullptr) < 0)
 	{
 		logErr("error connecting playback stream");
 		closePcm();
@@ -382,7 +497,7 @@ std::error_code openPcm(const PcmFormat &format)
 	auto serverAttr = pa_stream_get_buffer_attr(stream);
 	unlockMainLoop();
 	assert(serverAttr);
-	isCorked = false;
+	isCorked = (bool)pullBuff;
 	logMsg("opened stream with target fill bytes: %d", serverAttr->tlength);
 	return {};
 }
@@ -395,9 +510,17 @@ void closePcm()
 		return;
 	}
 	lockMainLoop();
+	pa_stream_set_write_callback(stream, nullptr, nullptr);
 	pa_stream_disconnect(stream);
 	pa_stream_unref(stream);
 	unlockMainLoop();
+	if(pullBuff)
+	{
+		auto stats = pullBuff.stats();
+		logMsg("pull stats: %u underruns, %u frames concealed, %u dropped, %u min queued",
+			stats.underruns, stats.concealedFrames, stats.droppedFrames, stats.minQueuedFrames);
+		pullBuff.deinit();
+	}
 	iterateMainLoop();
 	isCorked = true;
 	stream = nullptr;
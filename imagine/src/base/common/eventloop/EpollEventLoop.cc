@@ -0,0 +1,270 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "EventLoop"
+#include <imagine/base/Base.hh>
+#include <imagine/base/EventLoop.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/utility.h>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace Base
+{
+
+#ifdef CONFIG_BASE_X11
+extern void x11FDHandler();
+extern bool x11FDPending();
+#endif
+
+struct EpollLoopData
+{
+	int epollFd = -1;
+	bool dispatching = false;
+	// sources removed during a dispatch, freed after it since later events may point to them
+	EpollFDEventSourceInfo *removed{};
+	EpollFDEventSourceInfo *xServer{};
+};
+
+static thread_local EpollLoopData *threadLoop{};
+
+static void dispatch(EpollLoopData &loop, epoll_event *event, uint events, PollPriority priority)
+{
+	iterateTimes(events, i)
+	{
+		auto &info = *((EpollFDEventSourceInfo*)event[i].data.ptr);
+		if(info.fd == -1 || info.priority != priority)
+			continue;
+		if(info.isXServer)
+		{
+			#ifdef CONFIG_BASE_X11
+			x11FDHandler();
+			#endif
+		}
+		else if(!info.callback(info.fd, event[i].events) && info.fd != -1)
+		{
+			// like GLib, returning 0 removes the fd unless the callback already did
+			logMsg("removing fd:%d from epoll:%d after callback", info.fd, loop.epollFd);
+			epoll_ctl(loop.epollFd, EPOLL_CTL_DEL, info.fd, nullptr);
+			info.fd = -1;
+		}
+	}
+}
+
+static void freeRemovedSources(EpollLoopData &loop)
+{
+	while(loop.removed)
+	{
+		auto next = loop.removed->nextRemoved;
+		delete loop.removed;
+		loop.removed = next;
+	}
+}
+
+FDEventSource::FDEventSource(int fd):
+	EpollFDEventSource{fd}
+{}
+
+FDEventSource::FDEventSource(int fd, EventLoop loop, PollEventDelegate callback, uint events):
+	FDEventSource{fd}
+{
+	addToEventLoop(loop, callback, events);
+}
+
+FDEventSource::FDEventSource(FDEventSource &&o)
+{
+	swap(*this, o);
+}
+
+FDEventSource &FDEventSource::operator=(FDEventSource o)
+{
+	swap(*this, o);
+	return *this;
+}
+
+FDEventSource::~FDEventSource()
+{
+	removeFromEventLoop();
+}
+
+void FDEventSource::swap(FDEventSource &a, FDEventSource &b)
+{
+	std::swap(a.info, b.info);
+	std::swap(a.fd_, b.fd_);
+	std::swap(a.priority, b.priority);
+}
+
+FDEventSource FDEventSource::makeXServerAddedToEventLoop(int fd, EventLoop loop)
+{
+	FDEventSource src{fd};
+	src.addXServerToEventLoop(loop);
+	return src;
+}
+
+bool FDEventSource::addToEventLoop(EventLoop loop, PollEventDelegate callback, uint events)
+{
+	assert(!info);
+	if(!loop)
+		loop = EventLoop::forThread();
+	assert(loop);
+	auto newInfo = std::make_unique<EpollFDEventSourceInfo>();
+	newInfo->callback = callback;
+	newInfo->loop = loop.loopData();
+	newInfo->fd = fd_;
+	newInfo->priority = priority;
+	epoll_event ev{};
+	ev.events = events;
+	ev.data.ptr = newInfo.get();
+	if(epoll_ctl(loop.nativeObject(), EPOLL_CTL_ADD, fd_, &ev) == -1)
+	{
+		logErr("error adding fd:%d to epoll: %s", fd_, strerror(errno));
+		return false;
+	}
+	info = std::move(newInfo);
+	logMsg("added fd:%d to epoll:%d", fd_, loop.nativeObject());
+	return true;
+}
+
+void FDEventSource::addXServerToEventLoop(EventLoop loop)
+{
+	if(!addToEventLoop(loop, {}, POLLEV_IN))
+		return;
+	info->isXServer = true;
+	info->loop->xServer = info.get();
+}
+
+void FDEventSource::modifyEvents(uint events)
+{
+	assert(info);
+	epoll_event ev{};
+	ev.events = events;
+	ev.data.ptr = info.get();
+	if(epoll_ctl(info->loop->epollFd, EPOLL_CTL_MOD, fd_, &ev) == -1)
+	{
+		logErr("error modifying fd:%d in epoll: %s", fd_, strerror(errno));
+	}
+}
+
+void FDEventSource::setPriority(PollPriority priority)
+{
+	this->priority = priority;
+	if(info)
+		info->priority = priority;
+}
+
+void FDEventSource::removeFromEventLoop()
+{
+	if(!info)
+		return;
+	auto &loop = *info->loop;
+	if(info->fd != -1)
+	{
+		logMsg("removing fd:%d from epoll:%d", fd_, loop.epollFd);
+		epoll_ctl(loop.epollFd, EPOLL_CTL_DEL, fd_, nullptr);
+	}
+	if(loop.xServer == info.get())
+		loop.xServer = {};
+	if(loop.dispatching)
+	{
+		info->fd = -1;
+		info->nextRemoved = loop.removed;
+		loop.removed = info.release();
+	}
+	else
+		info.reset();
+}
+
+bool FDEventSource::hasEventLoop()
+{
+	return (bool)info;
+}
+
+int FDEventSource::fd() const
+{
+	return fd_;
+}
+
+int EpollEventLoop::nativeObject()
+{
+	return loop ? loop->epollFd : -1;
+}
+
+EventLoop EventLoop::forThread()
+{
+	return {threadLoop};
+}
+
+EventLoop EventLoop::makeForThread()
+{
+	if(!threadLoop)
+	{
+		int fd = epoll_create1(EPOLL_CLOEXEC);
+		if(fd == -1)
+		{
+			logErr("error creating epoll: %s", strerror(errno));
+			return {};
+		}
+		threadLoop = new EpollLoopData;
+		threadLoop->epollFd = fd;
+	}
+	return forThread();
+}
+
+void EventLoop::run()
+{
+	assert(loop);
+	logMsg("running event loop:%d", loop->epollFd);
+	static constexpr uint MAX_EVENTS = 16;
+	epoll_event event[MAX_EVENTS];
+	for(;;)
+	{
+		int timeout = -1;
+		#ifdef CONFIG_BASE_X11
+		// Xlib may have already read events from the socket
+		if(loop->xServer && x11FDPending())
+			timeout = 0;
+		#endif
+		int events = epoll_wait(loop->epollFd, event, MAX_EVENTS, timeout);
+		if(unlikely(events == -1))
+		{
+			if(errno == EINTR)
+				continue;
+			logErr("error in epoll_wait: %s", strerror(errno));
+			break;
+		}
+		#ifdef CONFIG_BASE_X11
+		if(!events && loop->xServer)
+		{
+			x11FDHandler();
+			continue;
+		}
+		#endif
+		loop->dispatching = true;
+		dispatch(*loop, event, events, PollPriority::HIGH);
+		dispatch(*loop, event, events, PollPriority::DEFAULT);
+		loop->dispatching = false;
+		freeRemovedSources(*loop);
+	}
+	logMsg("event loop:%d finished", loop->epollFd);
+}
+
+EventLoop::operator bool() const
+{
+	return loop;
+}
+
+}
@@ -60,6 +60,7 @@ void FDEventSource::swap(FDEventSource &a, FDEventSource &b)
 	std::swap(a.source, b.source);
 	std::swap(a.tag, b.tag);
 	std::swap(a.fd_, b.fd_);
+	std::swap(a.priority, b.priority);
 }
 
 FDEventSource FDEventSource::makeXServerAddedToEventLoop(int fd, EventLoop loop)
@@ -121,6 +122,13 @@ void FDEventSource::modifyEvents(uint events)
 	g_source_modify_unix_fd(source, tag, (GIOCondition)events);
 }
 
+void FDEventSource::setPriority(PollPriority priority)
+{
+	this->priority = priority == PollPriority::HIGH ? G_PRIORITY_HIGH : G_PRIORITY_DEFAULT;
+	if(source)
+		g_source_set_priority(source, this->priority);
+}
+
 void FDEventSource::removeFromEventLoop()
 {
 	if(source)
@@ -149,6 +157,7 @@ bool GlibFDEventSource::makeAndAttachSource(GSourceFuncs *fdSourceFuncs,
 	auto unrefSource = IG::scopeGuard([&](){ g_source_unref(source); });
 	tag = g_source_add_unix_fd(source, fd_, events);
 	g_source_set_callback(source, nullptr, tag, nullptr);
+	g_source_set_priority(source, priority);
 	if(!g_source_attach(source, ctx))
 	{
 		logErr("error attaching source with fd:%d", fd_);
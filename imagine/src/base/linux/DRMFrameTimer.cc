@@ -73,6 +73,8 @@ bool DRMFrameTimer::init(EventLoop loop)
 			}
 			return 1;
 		}};
+	// vsync timestamps go stale if input or other fds are handled first
+	fdSrc.setPriority(PollPriority::HIGH);
 	return true;
 }
 
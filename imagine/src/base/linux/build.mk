@@ -20,12 +20,15 @@ ifeq ($(linuxWinSystem), x11)
  include $(imagineSrcDir)/base/x11/build.mk
 endif
 
-linuxEventLoop ?= glib
+linuxEventLoop ?= epoll
 
 ifeq ($(linuxEventLoop), glib)
  configDefs += CONFIG_BASE_GLIB
  SRC += base/common/eventloop/GlibEventLoop.cc
  include $(IMAGINE_PATH)/make/package/glib.mk
+else
+ configDefs += CONFIG_BASE_EPOLL
+ SRC += base/common/eventloop/EpollEventLoop.cc
 endif
 
 ifneq ($(SUBENV), pandora)
@@ -100,7 +100,8 @@ struct DBusWatchHandler
 
 	void setupFDEvents(int fd, int events)
 	{
-		fdSrc.init(fd,
+		fdSrc = {fd};
+		fdSrc.addToEventLoop({},
 			[this](int fd, int event)
 			{
 				using namespace Base;
@@ -173,7 +174,7 @@ static void removeDBusWatch(DBusWatch *watch, void *conn)
 	auto handler = (DBusWatchHandler*)dbus_watch_get_data(watch);
 	if(handler)
 	{
-		handler->fdSrc.deinit();
+		handler->fdSrc.removeFromEventLoop();
 		delete handler;
 	}
 }
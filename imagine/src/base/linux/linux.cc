@@ -36,6 +36,9 @@ uint appActivityState() { return APP_RUNNING; }
 
 static void cleanup()
 {
+	#ifdef CONFIG_INPUT_EVDEV
+	Input::deinitEvdev();
+	#endif
 	#ifdef CONFIG_BASE_DBUS
 	deinitDBus();
 	#endif
@@ -162,6 +162,8 @@ bool FBDevFrameTimer::init(EventLoop loop)
 			}
 			return 1;
 		}};
+	// vsync timestamps go stale if input or other fds are handled first
+	fdSrc.setPriority(PollPriority::HIGH);
 	IG::makeDetachedThread(
 		[this, fbdev]()
 		{
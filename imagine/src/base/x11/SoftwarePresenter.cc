@@ -0,0 +1,342 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "SoftwarePresenter"
+#include <imagine/base/SoftwarePresenter.hh>
+#include <imagine/base/Window.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/utility.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include "internal.hh"
+#include <X11/extensions/XShm.h>
+
+namespace Base
+{
+
+static bool shmAttachFailed = false;
+static int shmCompletionType = -1;
+static std::vector<SoftwarePresenter*> presenters{};
+
+static int shmErrorHandler(Display *, XErrorEvent *)
+{
+	shmAttachFailed = true;
+	return 0;
+}
+
+bool handleShmCompletionEvent(XEvent &event)
+{
+	if(shmCompletionType == -1 || event.type != shmCompletionType)
+		return false;
+	auto &completion = (XShmCompletionEvent&)event;
+	for(auto p : presenters)
+	{
+		p->putCompleted(completion.shmseg);
+	}
+	return true;
+}
+
+static uint32 pixelToXRGB(uint16 p)
+{
+	// RGB565
+	uint32 r = (p >> 11) & 0x1F, g = (p >> 5) & 0x3F, b = p & 0x1F;
+	return ((r << 3 | r >> 2) << 16) | ((g << 2 | g >> 4) << 8) | (b << 3 | b >> 2);
+}
+
+static uint32 pixelToXRGB(uint32 p, bool swapRB)
+{
+	if(!swapRB)
+		return p;
+	return (p & 0xFF00FF00) | ((p & 0xFF) << 16) | ((p >> 16) & 0xFF);
+}
+
+template <class T, class Convert>
+static void scale(IG::Pixmap pix, IG::WindowRect rect, IG::WindowRect clipped,
+	const uint *srcX, char *dest, uint destPitch, Convert convert)
+{
+	for(int y = clipped.y; y < clipped.y2; y++)
+	{
+		uint srcY = (y - rect.y) * pix.h() / rect.ySize();
+		auto srcRow = (const T*)pix.pixel({0, (int)srcY});
+		auto destRow = (uint32*)(dest + y * destPitch);
+		for(int x = clipped.x; x < clipped.x2; x++)
+		{
+			destRow[x] = convert(srcRow[srcX[x - rect.x]]);
+		}
+	}
+}
+
+SoftwarePresenter::~SoftwarePresenter()
+{
+	deinit();
+}
+
+bool SoftwarePresenter::init(Window &win_)
+{
+	deinit();
+	win = &win_;
+	gc = XCreateGC(dpy, win->nativeObject(), 0, nullptr);
+	if(shmCompletionType == -1 && XShmQueryExtension(dpy))
+		shmCompletionType = XShmGetEventBase(dpy) + ShmCompletion;
+	presenters.emplace_back(this);
+	invalidate();
+	logMsg("presenting to window:0x%lx without GL", (unsigned long)win->nativeObject());
+	return true;
+}
+
+void SoftwarePresenter::deinit()
+{
+	if(!win)
+		return;
+	freeImages();
+	presenters.erase(std::find(presenters.begin(), presenters.end(), this));
+	XFreeGC(dpy, (GC)gc);
+	gc = {};
+	win = {};
+}
+
+void SoftwarePresenter::invalidate()
+{
+	putAll = true;
+	for(auto &i : img)
+	{
+		i.needsClear = true;
+	}
+}
+
+void SoftwarePresenter::putCompleted(unsigned long shmSeg)
+{
+	iterateTimes(images, i)
+	{
+		if(img[i].shmAddr && img[i].shmSeg == shmSeg)
+			img[i].putPending = false;
+	}
+}
+
+void SoftwarePresenter::waitForPut(Image &i)
+{
+	while(i.putPending)
+	{
+		XEvent event;
+		XIfEvent(dpy, &event,
+			[](Display *, XEvent *e, XPointer) -> int { return e->type == shmCompletionType; }, nullptr);
+		handleShmCompletionEvent(event);
+	}
+}
+
+bool SoftwarePresenter::makeImage(Image &i, uint w, uint h, bool useShm)
+{
+	XWindowAttributes attr;
+	if(!XGetWindowAttributes(dpy, win->nativeObject(), &attr))
+		return false;
+	auto visual = attr.visual;
+	if(attr.depth < 24 || visual->red_mask != 0xFF0000 || visual->green_mask != 0xFF00 || visual->blue_mask != 0xFF)
+	{
+		logErr("unsupported visual with depth:%d", attr.depth);
+		return false;
+	}
+	XImage *ximg{};
+	if(useShm)
+	{
+		XShmSegmentInfo info{};
+		ximg = XShmCreateImage(dpy, visual, attr.depth, ZPixmap, nullptr, &info, w, h);
+		if(!ximg)
+			return false;
+		info.shmid = shmget(IPC_PRIVATE, ximg->bytes_per_line * ximg->height, IPC_CREAT | 0600);
+		info.shmaddr = ximg->data = info.shmid != -1 ? (char*)shmat(info.shmid, nullptr, 0) : (char*)-1;
+		info.readOnly = False;
+		if(info.shmaddr != (char*)-1)
+		{
+			shmAttachFailed = false;
+			auto prevHandler = XSetErrorHandler(shmErrorHandler);
+			XShmAttach(dpy, &info);
+			XSync(dpy, False);
+			XSetErrorHandler(prevHandler);
+		}
+		if(info.shmid != -1)
+		{
+			// freed once both sides detach
+			shmctl(info.shmid, IPC_RMID, nullptr);
+		}
+		if(info.shmaddr == (char*)-1 || shmAttachFailed)
+		{
+			if(info.shmaddr != (char*)-1)
+				shmdt(info.shmaddr);
+			ximg->data = nullptr;
+			XDestroyImage(ximg);
+			return false;
+		}
+		i.shmSeg = info.shmseg;
+		i.shmAddr = info.shmaddr;
+	}
+	else
+	{
+		ximg = XCreateImage(dpy, visual, attr.depth, ZPixmap, 0, nullptr, w, h, 32, 0);
+		if(!ximg)
+			return false;
+		ximg->data = (char*)calloc(ximg->bytes_per_line, ximg->height);
+	}
+	i.image = ximg;
+	if(ximg->bits_per_pixel != 32)
+	{
+		logErr("unsupported image with %d bits per pixel", ximg->bits_per_pixel);
+		return false;
+	}
+	return true;
+}
+
+bool SoftwarePresenter::makeImages(uint w, uint h)
+{
+	bool useShm = shmCompletionType != -1;
+	iterateTimes(useShm ? img.size() : 1, i)
+	{
+		if(!makeImage(img[i], w, h, useShm))
+		{
+			if(useShm && !i)
+			{
+				// remote X server or no SysV shared memory
+				logWarn("can't share image memory with X server");
+				img[0] = {};
+				useShm = false;
+				if(makeImage(img[0], w, h, false))
+				{
+					images = 1;
+					break;
+				}
+			}
+			images = i + 1;
+			freeImages();
+			return false;
+		}
+		images = i + 1;
+	}
+	imageW = w;
+	imageH = h;
+	logMsg("made %u %ux%u image(s)%s", images, w, h, useShm ? " in shared memory" : "");
+	return true;
+}
+
+void SoftwarePresenter::freeImages()
+{
+	iterateTimes(images, idx)
+	{
+		auto &i = img[idx];
+		auto ximg = (XImage*)i.image;
+		if(i.shmAddr)
+		{
+			XShmSegmentInfo info{};
+			info.shmseg = i.shmSeg;
+			info.shmaddr = i.shmAddr;
+			XShmDetach(dpy, &info);
+			XSync(dpy, False);
+			shmdt(i.shmAddr);
+			if(ximg)
+				ximg->data = nullptr;
+		}
+		if(ximg)
+			XDestroyImage(ximg);
+		i = {};
+	}
+	images = 0;
+	nextImg = 0;
+	imageW = imageH = 0;
+}
+
+bool SoftwarePresenter::supportsFormat(IG::PixelFormat format)
+{
+	switch(format.id())
+	{
+		case PIXEL_RGB565:
+		case PIXEL_RGBA8888:
+		case PIXEL_BGRA8888:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool SoftwarePresenter::present(IG::Pixmap pix, IG::WindowRect rect)
+{
+	assert(win);
+	if(!supportsFormat(pix.format()) || rect.xSize() <= 0 || rect.ySize() <= 0)
+		return false;
+	uint winW = win->width(), winH = win->height();
+	if(winW != imageW || winH != imageH)
+	{
+		freeImages();
+		if(!makeImages(winW, winH))
+			return false;
+		invalidate();
+	}
+	if(rect != lastRect || srcX.size() != (uint)rect.xSize())
+	{
+		lastRect = rect;
+		srcX.resize(rect.xSize());
+		invalidate();
+	}
+	// recomputed each frame since the source size may change with the same rect
+	iterateTimes(srcX.size(), i)
+	{
+		srcX[i] = i * pix.w() / rect.xSize();
+	}
+	IG::WindowRect clipped{std::max(rect.x, 0), std::max(rect.y, 0),
+		std::min(rect.x2, (int)imageW), std::min(rect.y2, (int)imageH)};
+	if(clipped.xSize() <= 0 || clipped.ySize() <= 0)
+		return true;
+	auto &i = img[nextImg];
+	nextImg = (nextImg + 1) % images;
+	// normally the other image was put a frame ago and is already free
+	waitForPut(i);
+	auto ximg = (XImage*)i.image;
+	if(i.needsClear)
+	{
+		memset(ximg->data, 0, ximg->bytes_per_line * ximg->height);
+		i.needsClear = false;
+	}
+	switch(pix.format().id())
+	{
+		bcase PIXEL_RGB565:
+			scale<uint16>(pix, rect, clipped, srcX.data(), ximg->data, ximg->bytes_per_line,
+				[](uint16 p){ return pixelToXRGB(p); });
+		bcase PIXEL_RGBA8888:
+			scale<uint32>(pix, rect, clipped, srcX.data(), ximg->data, ximg->bytes_per_line,
+				[](uint32 p){ return pixelToXRGB(p, true); });
+		bdefault:
+			scale<uint32>(pix, rect, clipped, srcX.data(), ximg->data, ximg->bytes_per_line,
+				[](uint32 p){ return pixelToXRGB(p, false); });
+	}
+	auto put = putAll ? IG::WindowRect{0, 0, (int)imageW, (int)imageH} : clipped;
+	if(i.shmAddr)
+	{
+		// the server sends a ShmCompletion event once it's done reading the image
+		XShmPutImage(dpy, win->nativeObject(), (GC)gc, ximg, put.x, put.y, put.x, put.y,
+			put.xSize(), put.ySize(), True);
+		i.putPending = true;
+	}
+	else
+	{
+		XPutImage(dpy, win->nativeObject(), (GC)gc, ximg, put.x, put.y, put.x, put.y,
+			put.xSize(), put.ySize());
+	}
+	XFlush(dpy);
+	putAll = false;
+	return true;
+}
+
+}
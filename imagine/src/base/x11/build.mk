@@ -6,9 +6,10 @@ include $(IMAGINE_PATH)/make/package/x11.mk
 include $(IMAGINE_PATH)/make/package/xinput.mk
 include $(IMAGINE_PATH)/make/package/xfixes.mk
 include $(IMAGINE_PATH)/make/package/xrandr.mk
+include $(IMAGINE_PATH)/make/package/xext.mk
 
 ifeq ($(SUBENV), pandora)
- pkgConfigDeps += xext xcb xdmcp xau
+ pkgConfigDeps += xcb xdmcp xau
 endif
 
 configDefs += CONFIG_BASE_X11
@@ -18,7 +19,8 @@ SRC += base/x11/x11.cc \
  base/x11/XScreen.cc \
  base/x11/xdnd.cc \
  base/x11/input.cc \
- base/x11/FrameTimer.cc
+ base/x11/FrameTimer.cc \
+ base/x11/SoftwarePresenter.cc
 
 x11GLWinSystem ?= egl
 
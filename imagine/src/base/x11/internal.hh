@@ -40,6 +40,8 @@ namespace Base
 	void deinitFrameTimer();
 	void frameTimerScheduleVSync();
 	void frameTimerCancel();
+	// returns true if the event was a MIT-SHM put completing
+	bool handleShmCompletionEvent(XEvent &event);
 }
 
 namespace Input
@@ -186,6 +186,8 @@ static int eventHandler(XEvent &event)
 		}
 		bdefault:
 		{
+			if(handleShmCompletionEvent(event))
+				break;
 			logDMsg("got unhandled message type %d", event.type);
 		}
 		break;
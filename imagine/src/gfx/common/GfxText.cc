@@ -23,6 +23,9 @@
 namespace Gfx
 {
 
+// glyphs sharing a texture, usually the font's atlas, are drawn together
+static constexpr uint BATCH_GLYPHS = 64;
+
 Text::~Text()
 {
 	if(lineInfo)
@@ -168,9 +171,21 @@ void Text::draw(Renderer &r, GC xPos, GC yPos, _2DOrigin o, const ProjectionPlan
 	//resetTransforms();
 	r.setBlendMode(BLEND_MODE_ALPHA);
 	TextureSampler::bindDefaultNoMipClampSampler(r);
-	std::array<TexVertex, 4> vArr;
+	std::array<TexVertex, BATCH_GLYPHS * 6> vArr;
+	uint batchGlyphs = 0;
+	Texture *batchTex{};
 	r.bindTempVertexBuffer();
 	TexVertex::bindAttribs(r, vArr.data());
+	auto drawBatch =
+		[&]()
+		{
+			if(!batchGlyphs)
+				return;
+			r.vertexBufferData(vArr.data(), sizeof(TexVertex) * batchGlyphs * 6);
+			batchTex->bind();
+			r.drawPrimitives(Primitive::TRIANGLE, 0, batchGlyphs * 6);
+			batchGlyphs = 0;
+		};
 	_2DOrigin align = o;
 	xPos = o.adjustX(xPos, xSize, LT2DO);
 	//logMsg("aligned to %f, converted to %d", Gfx::alignYToPixel(yPos), toIYPos(Gfx::alignYToPixel(yPos)));
@@ -202,6 +217,7 @@ void Text::draw(Renderer &r, GC xPos, GC yPos, _2DOrigin o, const ProjectionPlan
 				(bool)err)
 			{
 				logWarn("failed char conversion while drawing line %d, char %d, result %d", l, i, (int)err);
+				drawBatch();
 				return;
 			}
 
@@ -226,17 +242,25 @@ void Text::draw(Renderer &r, GC xPos, GC yPos, _2DOrigin o, const ProjectionPlan
 
 			auto x = xPos + projP.unprojectXSize(gly->metrics.xOffset);
 			auto y = yPos - projP.unprojectYSize(gly->metrics.ySize - gly->metrics.yOffset);
-			vArr = makeTexVertArray({x, y, x + xSize, y + projP.unprojectYSize(gly->metrics.ySize)}, gly->glyph);
-			r.vertexBufferData(vArr.data(), sizeof(vArr));
-			gly->glyph.bind();
-			//logMsg("drawing");
-			r.drawPrimitives(Primitive::TRIANGLE_STRIP, 0, 4);
+			auto &tex = gly->texture();
+			if(&tex != batchTex || batchGlyphs == BATCH_GLYPHS)
+			{
+				drawBatch();
+				batchTex = &tex;
+			}
+			auto quad = makeTexVertArray({x, y, x + xSize, y + projP.unprojectYSize(gly->metrics.ySize)}, gly->uvBounds());
+			// split the quad's strip, BL TL BR TR, into two triangles
+			auto v = &vArr[batchGlyphs * 6];
+			v[0] = quad[0]; v[1] = quad[1]; v[2] = quad[2];
+			v[3] = quad[2]; v[4] = quad[1]; v[5] = quad[3];
+			batchGlyphs++;
 			xPos += projP.unprojectXSize(gly->metrics.xAdvance);
 		}
 		yPos -= nominalHeight;
 		yPos = projP.alignYToPixel(yPos);
 		totalCharsDrawn += charsToDraw;
 	}
+	drawBatch();
 	assert(totalCharsDrawn <= chars);
 }
 
@@ -17,8 +17,20 @@
 
 #include <imagine/util/bits.h>
 #include <imagine/gfx/GlyphTextureSet.hh>
+#include <imagine/base/Base.hh>
+#include <imagine/fs/FS.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/thread/Thread.hh>
 #include <imagine/logger/logger.h>
 #include <imagine/mem/mem.h>
+#include <imagine/util/hash.hh>
+#include <imagine/util/string.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <numeric>
+#include <vector>
 
 namespace Gfx
 {
@@ -95,6 +107,233 @@ static int charIsDrawableUnicode(int c)
 			);
 }
 
+// Android renders glyphs through Java, which only the main thread may use
+static constexpr bool RASTERIZE_ATLAS_ON_WORKER = !Config::envIsAndroid;
+static constexpr int ATLAS_MAX_SIZE = 2048;
+static constexpr int ATLAS_PADDING = 1; // keeps linear filtering from sampling a neighbor
+
+// fonts share the FreeType library and may load fallback faces while
+// rendering, so glyphs are rendered one at a time across all threads
+static std::mutex fontMutex;
+
+struct AtlasGlyph
+{
+	int32 c;
+	int16 x, y;
+	IG::GlyphMetrics metrics; // ySize is -1 if the font has no glyph for c
+};
+
+struct GlyphAtlasBuild
+{
+	IG::thread thread{};
+	std::atomic_bool done{};
+	bool needsRasterize = false; // cache miss left for the main thread
+	FS::PathString path{};
+	IG::FontSettings settings{};
+	IG::GlyphMetrics probe[2]{};
+	IG::WP size{};
+	std::vector<AtlasGlyph> glyph{};
+	std::vector<uint8> pixels{};
+};
+
+struct AtlasCacheHeader
+{
+	static constexpr char MAGIC[4]{'I', 'G', 'G', 'A'};
+	static constexpr uint32 VERSION = 1;
+	char magic[4]{};
+	uint32 version = VERSION;
+	int32 pixelWidth = 0, pixelHeight = 0;
+	// metrics of 'M' and 'g', these change if the system's font file does
+	IG::GlyphMetrics probe[2]{};
+	uint32 glyphs = 0;
+	int32 width = 0, height = 0;
+	uint32 pixelHash = 0;
+};
+
+constexpr char AtlasCacheHeader::MAGIC[4];
+
+template <class FUNC>
+static void iterateAtlasChars(FUNC func)
+{
+	for(int c = firstDrawableAsciiChar; c <= lastDrawableAsciiChar; c++)
+		func(c);
+	if(GlyphTextureSet::supportsUnicode)
+	{
+		// Latin-1 Supplement
+		for(int c = 0xA1; c <= 0xFF; c++)
+			func(c);
+	}
+}
+
+static bool isAtlasChar(int c)
+{
+	return charIsDrawableAscii(c) || (GlyphTextureSet::supportsUnicode && c >= 0xA1 && c <= 0xFF);
+}
+
+static uint atlasChars()
+{
+	uint chars = 0;
+	iterateAtlasChars([&](int){ chars++; });
+	return chars;
+}
+
+static void rasterizeAtlas(GlyphAtlasBuild &build, IG::Font &font, IG::FontSize &faceSize)
+{
+	std::vector<std::vector<uint8>> bitmap;
+	build.glyph.clear();
+	iterateAtlasChars(
+		[&](int c)
+		{
+			AtlasGlyph g{c, 0, 0, {}};
+			std::vector<uint8> data;
+			std::lock_guard<std::mutex> lock{fontMutex};
+			std::errc ec{};
+			auto res = font.glyph(c, faceSize, ec);
+			if((bool)ec)
+			{
+				g.metrics.ySize = -1;
+			}
+			else
+			{
+				g.metrics = res.metrics;
+				auto src = res.image.pixmap();
+				if(src.w() && src.h())
+				{
+					data.resize(src.w() * src.h());
+					IG::Pixmap{{src.size(), IG::PIXEL_FMT_A8}, data.data()}.write(src, {});
+				}
+			}
+			build.glyph.push_back(g);
+			bitmap.push_back(std::move(data));
+		});
+	// pack in rows, tallest glyphs first so rows waste little height
+	std::vector<uint> order(build.glyph.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(),
+		[&](uint a, uint b){ return build.glyph[a].metrics.ySize > build.glyph[b].metrics.ySize; });
+	int area = 0, maxGlyphWidth = 0;
+	for(auto &g : build.glyph)
+	{
+		if(g.metrics.ySize <= 0)
+			continue;
+		area += (g.metrics.xSize + ATLAS_PADDING) * (g.metrics.ySize + ATLAS_PADDING);
+		maxGlyphWidth = std::max(maxGlyphWidth, g.metrics.xSize + ATLAS_PADDING);
+	}
+	int width = 64;
+	while(width * width < area || width < maxGlyphWidth)
+		width *= 2;
+	int x = 0, y = 0, rowHeight = 0;
+	for(auto i : order)
+	{
+		auto &g = build.glyph[i];
+		if(bitmap[i].empty())
+			continue;
+		int w = g.metrics.xSize + ATLAS_PADDING, h = g.metrics.ySize + ATLAS_PADDING;
+		if(x + w > width)
+		{
+			x = 0;
+			y += rowHeight;
+			rowHeight = 0;
+		}
+		g.x = x;
+		g.y = y;
+		x += w;
+		rowHeight = std::max(rowHeight, h);
+	}
+	int height = y + rowHeight;
+	if(width > ATLAS_MAX_SIZE || height > ATLAS_MAX_SIZE)
+	{
+		logWarn("glyphs need a %dx%d atlas, larger than the %d limit", width, height, ATLAS_MAX_SIZE);
+		build.glyph.clear();
+		return;
+	}
+	build.size = {width, std::max(height, 1)};
+	build.pixels.assign(build.size.x * build.size.y, 0);
+	IG::Pixmap atlasPix{{build.size, IG::PIXEL_FMT_A8}, build.pixels.data()};
+	iterateTimes(build.glyph.size(), i)
+	{
+		auto &g = build.glyph[i];
+		if(bitmap[i].empty())
+			continue;
+		atlasPix.write({{{g.metrics.xSize, g.metrics.ySize}, IG::PIXEL_FMT_A8}, bitmap[i].data()}, {g.x, g.y});
+	}
+	logMsg("rasterized %u glyphs into %dx%d atlas", (uint)build.glyph.size(), width, build.size.y);
+}
+
+static bool readAtlasCache(GlyphAtlasBuild &build)
+{
+	FileIO file;
+	file.open(build.path);
+	if(!file)
+		return false;
+	AtlasCacheHeader header;
+	if(file.read(&header, sizeof(header)) != sizeof(header)
+		|| memcmp(header.magic, AtlasCacheHeader::MAGIC, sizeof(header.magic)) != 0
+		|| header.version != AtlasCacheHeader::VERSION
+		|| header.width <= 0 || header.width > ATLAS_MAX_SIZE
+		|| header.height <= 0 || header.height > ATLAS_MAX_SIZE)
+	{
+		logWarn("ignoring invalid glyph cache:%s", build.path.data());
+		return false;
+	}
+	if(header.pixelWidth != build.settings.pixelWidth() || header.pixelHeight != build.settings.pixelHeight()
+		|| header.glyphs != atlasChars() || memcmp(header.probe, build.probe, sizeof(header.probe)) != 0)
+	{
+		logMsg("glyph cache:%s is from a different font", build.path.data());
+		return false;
+	}
+	build.glyph.resize(header.glyphs);
+	build.pixels.resize(header.width * header.height);
+	ssize_t glyphBytes = build.glyph.size() * sizeof(AtlasGlyph);
+	if(file.read(build.glyph.data(), glyphBytes) != glyphBytes
+		|| file.read(build.pixels.data(), build.pixels.size()) != (ssize_t)build.pixels.size()
+		|| IG::hashBytes(build.pixels.data(), build.pixels.size()) != header.pixelHash)
+	{
+		logWarn("glyph cache:%s is truncated or corrupt", build.path.data());
+		build.glyph.clear();
+		build.pixels.clear();
+		return false;
+	}
+	build.size = {header.width, header.height};
+	logMsg("read %u glyphs from cache:%s", header.glyphs, build.path.data());
+	return true;
+}
+
+static void writeAtlasCache(const GlyphAtlasBuild &build)
+{
+	if(build.glyph.empty())
+		return;
+	auto tempPath = FS::makePathStringPrintf("%s.tmp", build.path.data());
+	{
+		FileIO file;
+		file.create(tempPath);
+		if(!file)
+		{
+			logWarn("error creating glyph cache:%s", tempPath.data());
+			return;
+		}
+		AtlasCacheHeader header;
+		memcpy(header.magic, AtlasCacheHeader::MAGIC, sizeof(header.magic));
+		header.pixelWidth = build.settings.pixelWidth();
+		header.pixelHeight = build.settings.pixelHeight();
+		memcpy(header.probe, build.probe, sizeof(header.probe));
+		header.glyphs = build.glyph.size();
+		header.width = build.size.x;
+		header.height = build.size.y;
+		header.pixelHash = IG::hashBytes(build.pixels.data(), build.pixels.size());
+		file.write(&header, sizeof(header));
+		file.write(build.glyph.data(), build.glyph.size() * sizeof(AtlasGlyph));
+		file.write(build.pixels.data(), build.pixels.size());
+	}
+	std::error_code ec{};
+	FS::rename(tempPath, build.path, ec);
+	if(ec)
+	{
+		logWarn("error renaming glyph cache:%s", build.path.data());
+		FS::remove(tempPath);
+	}
+}
+
 bool GlyphTextureSet::initGlyphTable()
 {
 	logMsg("allocating glyph table, %d entries", glyphTableEntries);
@@ -112,6 +351,8 @@ bool GlyphTextureSet::initGlyphTable()
 
 void GlyphTextureSet::freeCaches(uint32 purgeBits)
 {
+	if(purgeBits & IG::bit(0)) // all atlas chars are in the first range
+		freeAtlas();
 	auto tableBits = usedGlyphTableBits;
 	iterateTimes(32, i)
 	{
@@ -128,6 +369,7 @@ void GlyphTextureSet::freeCaches(uint32 purgeBits)
 					continue;
 				}
 				glyphTable[tableIdx].glyph.deinit();
+				glyphTable[tableIdx].atlas = {};
 			}
 			usedGlyphTableBits = IG::clearBits(usedGlyphTableBits, IG::bit(i));
 		}
@@ -136,17 +378,21 @@ void GlyphTextureSet::freeCaches(uint32 purgeBits)
 	}
 }
 
+GlyphTextureSet::GlyphTextureSet() {}
+
 GlyphTextureSet::GlyphTextureSet(Renderer &r, const char *path, IG::FontSettings set):
-		GlyphTextureSet(r, std::make_unique<IG::Font>(path), set)
+		GlyphTextureSet(r, std::make_unique<IG::Font>(path), set, FS::basename(path).data())
 {}
 
 GlyphTextureSet::GlyphTextureSet(Renderer &r, GenericIO io, IG::FontSettings set):
 	GlyphTextureSet(r, std::make_unique<IG::Font>(std::move(io)), set)
 {}
 
-GlyphTextureSet::GlyphTextureSet(Renderer &r, std::unique_ptr<IG::Font> font, IG::FontSettings set):
+GlyphTextureSet::GlyphTextureSet(Renderer &r, std::unique_ptr<IG::Font> font, IG::FontSettings set, const char *atlasName):
 	font{std::move(font)}
 {
+	if(atlasName)
+		string_copy(this->atlasName, atlasName);
 	if(set)
 	{
 		setFontSettings(r, set);
@@ -162,17 +408,17 @@ GlyphTextureSet::GlyphTextureSet(Renderer &r, std::unique_ptr<IG::Font> font, IG
 
 GlyphTextureSet GlyphTextureSet::makeSystem(Renderer &r, IG::FontSettings set)
 {
-	return {r, std::make_unique<IG::Font>(IG::Font::makeSystem()), set};
+	return {r, std::make_unique<IG::Font>(IG::Font::makeSystem()), set, "system"};
 }
 
 GlyphTextureSet GlyphTextureSet::makeBoldSystem(Renderer &r, IG::FontSettings set)
 {
-	return {r, std::make_unique<IG::Font>(IG::Font::makeBoldSystem()), set};
+	return {r, std::make_unique<IG::Font>(IG::Font::makeBoldSystem()), set, "system-bold"};
 }
 
 GlyphTextureSet GlyphTextureSet::makeFromAsset(Renderer &r, const char *name, IG::FontSettings set)
 {
-	return {r, openAppAssetIO(name).makeGeneric(), set};
+	return {r, std::make_unique<IG::Font>(openAppAssetIO(name).makeGeneric()), set, name};
 }
 
 GlyphTextureSet::GlyphTextureSet(GlyphTextureSet &&o)
@@ -188,6 +434,7 @@ GlyphTextureSet &GlyphTextureSet::operator=(GlyphTextureSet o)
 
 GlyphTextureSet::~GlyphTextureSet()
 {
+	freeAtlas();
 	if(glyphTable)
 	{
 		iterateTimes(glyphTableEntries, i)
@@ -205,12 +452,18 @@ GlyphTextureSet::operator bool() const
 
 void GlyphTextureSet::swap(GlyphTextureSet &a, GlyphTextureSet &b)
 {
+	// the atlas thread uses the font size object in place
+	a.waitForAtlasBuild();
+	b.waitForAtlasBuild();
 	std::swap(a.settings, b.settings);
 	std::swap(a.font, b.font);
 	std::swap(a.glyphTable, b.glyphTable);
 	std::swap(a.faceSize, b.faceSize);
 	std::swap(a.nominalHeight_, b.nominalHeight_);
 	std::swap(a.usedGlyphTableBits, b.usedGlyphTableBits);
+	std::swap(a.atlasName, b.atlasName);
+	std::swap(a.atlas, b.atlas);
+	std::swap(a.atlasBuild, b.atlasBuild);
 }
 
 uint GlyphTextureSet::nominalHeight() const
@@ -237,6 +490,7 @@ bool GlyphTextureSet::setFontSettings(Renderer &r, IG::FontSettings set)
 		set.setPixelHeight(font->minUsablePixels());
 	if(set == settings)
 		return false;
+	freeAtlas();
 	if(settings && glyphTable)
 	{
 		logMsg("flushing glyph cache");
@@ -253,9 +507,104 @@ bool GlyphTextureSet::setFontSettings(Renderer &r, IG::FontSettings set)
 	std::errc ec{};
 	faceSize = font->makeSize(settings, ec);
 	calcNominalHeight(r);
+	startAtlasBuild();
 	return true;
 }
 
+void GlyphTextureSet::startAtlasBuild()
+{
+	if(!strlen(atlasName.data()))
+		return;
+	auto build = std::make_unique<GlyphAtlasBuild>();
+	build->path = FS::makePathStringPrintf("%s/%s-%dx%d.glyphs", Base::documentsPath().data(),
+		atlasName.data(), settings.pixelWidth(), settings.pixelHeight());
+	build->settings = settings;
+	uint mIdx, gIdx;
+	mapCharToTable('M', mIdx);
+	mapCharToTable('g', gIdx);
+	build->probe[0] = glyphTable[mIdx].metrics;
+	build->probe[1] = glyphTable[gIdx].metrics;
+	build->thread = IG::thread{
+		[&b = *build, font = font.get(), faceSize = &faceSize]()
+		{
+			if(!readAtlasCache(b))
+			{
+				if(RASTERIZE_ATLAS_ON_WORKER)
+				{
+					rasterizeAtlas(b, *font, *faceSize);
+					writeAtlasCache(b);
+				}
+				else
+					b.needsRasterize = true;
+			}
+			b.done = true;
+		}};
+	atlasBuild = std::move(build);
+}
+
+void GlyphTextureSet::waitForAtlasBuild()
+{
+	if(atlasBuild && atlasBuild->thread.joinable())
+		atlasBuild->thread.join();
+}
+
+void GlyphTextureSet::applyAtlas(Renderer &r)
+{
+	waitForAtlasBuild();
+	auto build = std::move(atlasBuild);
+	if(build->needsRasterize)
+	{
+		rasterizeAtlas(*build, *font, faceSize);
+		writeAtlasCache(*build);
+	}
+	if(build->glyph.empty())
+		return;
+	IG::Pixmap pix{{build->size, IG::PIXEL_FMT_A8}, build->pixels.data()};
+	atlas = std::make_unique<PixmapTexture>();
+	if(auto err = atlas->init(r, {pix});
+		err)
+	{
+		logErr("error creating glyph atlas: %s", err->what());
+		atlas.reset();
+		return;
+	}
+	atlas->write(0, pix, {});
+	auto uv = atlas->uvBounds();
+	auto uvX = [&](int x){ return uv.x2 * x / build->size.x; };
+	auto uvY = [&](int y){ return uv.y2 * y / build->size.y; };
+	for(auto &g : build->glyph)
+	{
+		uint tableIdx;
+		if((bool)mapCharToTable(g.c, tableIdx))
+			continue;
+		auto &entry = glyphTable[tableIdx];
+		if(g.metrics.ySize == -1)
+		{
+			if(!entry)
+				entry.metrics.ySize = -1;
+			continue;
+		}
+		// replaces glyphs cached individually before the atlas was ready
+		entry.glyph.deinit();
+		entry.atlas = atlas.get();
+		entry.atlasUV = {uvX(g.x), uvY(g.y), uvX(g.x + g.metrics.xSize), uvY(g.y + g.metrics.ySize)};
+		entry.metrics = g.metrics;
+		usedGlyphTableBits |= IG::bit((g.c >> 11) & 0x1F);
+	}
+	logMsg("using %dx%d glyph atlas for %s", build->size.x, build->size.y, atlasName.data());
+}
+
+void GlyphTextureSet::freeAtlas()
+{
+	waitForAtlasBuild();
+	atlasBuild.reset();
+	if(atlas)
+	{
+		atlas->deinit();
+		atlas.reset();
+	}
+}
+
 std::errc GlyphTextureSet::cacheChar(Renderer &r, int c, int tableIdx)
 {
 	if(glyphTable[tableIdx].metrics.ySize == -1)
@@ -265,7 +614,11 @@ std::errc GlyphTextureSet::cacheChar(Renderer &r, int c, int tableIdx)
 	}
 	// make sure applySize() has been called on the font object first
 	std::errc ec{};
-	auto res = font->glyph(c, faceSize, ec);
+	auto res = [&]()
+		{
+			std::lock_guard<std::mutex> lock{fontMutex};
+			return font->glyph(c, faceSize, ec);
+		}();
 	if((bool)ec)
 	{
 		// mark failed attempt
@@ -331,7 +684,9 @@ std::errc GlyphTextureSet::precache(Renderer &r, const char *string)
 			//logMsg( "%c not a known drawable character, skipping", c);
 			continue;
 		}
-		if(glyphTable[tableIdx].glyph)
+		if(unlikely(atlasBuild) && isAtlasChar(c))
+			applyAtlas(r);
+		if(glyphTable[tableIdx])
 		{
 			//logMsg( "%c already cached", c);
 			continue;
@@ -349,7 +704,13 @@ GlyphEntry *GlyphTextureSet::glyphEntry(Renderer &r, int c)
 	if((bool)mapCharToTable(c, tableIdx))
 		return nullptr;
 	assert(tableIdx < glyphTableEntries);
-	if(!glyphTable[tableIdx].glyph)
+	if(unlikely(atlasBuild))
+	{
+		// switch to the atlas once it's ready, only wait for it if it has a missing glyph
+		if(atlasBuild->done || (!glyphTable[tableIdx] && isAtlasChar(c)))
+			applyAtlas(r);
+	}
+	if(!glyphTable[tableIdx])
 	{
 		if((bool)cacheChar(r, c, tableIdx))
 			return nullptr;
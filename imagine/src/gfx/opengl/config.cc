@@ -457,6 +457,12 @@ void Renderer::configureRenderer()
 	assert(version);Renderer();
 	auto rendererName = (const char*)glGetString(GL_RENDERER);
 	logMsg("version: %s (%s)", version, rendererName);
+	if(rendererName && (strstr(rendererName, "llvmpipe") || strstr(rendererName, "softpipe")
+		|| strstr(rendererName, "Software Rasterizer") || strstr(rendererName, "SWR")))
+	{
+		logMsg("renderer is a software rasterizer");
+		support.isSoftwareRasterizer = true;
+	}
 
 	int glVer = glVersionFromStr(version);
 
@@ -584,6 +590,11 @@ bool Renderer::isConfigured() const
 	return support.isConfigured;
 }
 
+bool Renderer::isSoftwareRasterizer() const
+{
+	return support.isSoftwareRasterizer;
+}
+
 Renderer Renderer::makeConfiguredRenderer(IG::PixelFormat pixelFormat, Error &err)
 {
 	auto renderer = Renderer{pixelFormat, err};
@@ -2,6 +2,7 @@ ifndef inc_input_evdev
 inc_input_evdev := 1
 
 include $(imagineSrcDir)/input/build.mk
+include $(imagineSrcDir)/thread/system.mk
 
 configDefs += CONFIG_INPUT_EVDEV
 
@@ -24,11 +24,17 @@
 #include <imagine/util/string.h>
 #include <imagine/fs/FS.hh>
 #include <imagine/base/Base.hh>
+#include <imagine/base/Pipe.hh>
+#include <imagine/thread/Thread.hh>
+#include <imagine/thread/Semaphore.hh>
 #include <imagine/input/Input.hh>
 #include <imagine/input/AxisKeyEmu.hh>
 #include "evdev.hh"
 #include "../private.hh"
 #include <vector>
+#include <cstddef>
+#include <climits>
+#include <ctime>
 
 #define DEV_NODE_PATH "/dev/input"
 static const uint MAX_STICK_AXES = 6; // 6 possible axes defined in key codes
@@ -117,6 +123,30 @@ static Key toSysKey(Key key)
 }*/
 
 static void removeFromSystem(int fd);
+struct EvdevInputDevice;
+static void removePollEvent(EvdevInputDevice &dev);
+
+// Device fds are read on a dedicated thread so events are picked up as soon
+// as the kernel has them even while the main thread is busy running or
+// drawing a frame. They're passed back over a pipe and dispatched on the main
+// thread, either when its event loop wakes up or earlier from flushEvents().
+static Base::EventLoop inputThreadLoop{};
+static Base::Pipe inputPipe{};
+// devices to stop polling, handled on the input thread since it may be dispatching them
+static Base::Pipe removePollPipe{};
+static IG::Semaphore removePollSem{0};
+
+struct EvdevEventMsg
+{
+	EvdevInputDevice *dev;
+	uint events; // 0 if the device had an error and should be removed
+	input_event event[64];
+
+	static constexpr uint headerSize() { return offsetof(EvdevEventMsg, event); }
+	uint size() const { return headerSize() + events * sizeof(input_event); }
+};
+
+static_assert(sizeof(EvdevEventMsg) <= PIPE_BUF, "message must be written to the pipe atomically");
 
 struct EvdevInputDevice : public Device
 {
@@ -239,29 +269,31 @@ struct EvdevInputDevice : public Device
 	void addPollEvent()
 	{
 		assert(fd >= 0);
-		fdSrc = {fd, {},
+		// runs on the input thread if one was started
+		fdSrc = {fd, inputThreadLoop,
 			[this](int fd, int pollEvents)
 			{
+				EvdevEventMsg msg;
+				msg.dev = this;
 				if(unlikely(pollEvents & Base::POLLEV_ERR))
 				{
 					logMsg("error %d in input fd %d (%s)", errno, fd, name());
-					removeFromSystem(fd);
+					postRemoval(msg);
 					return 0;
 				}
 				else
 				{
-					struct input_event event[64];
 					int len;
-					while((len = read(fd, event, sizeof event)) > 0)
+					while((len = read(fd, msg.event, sizeof msg.event)) > 0)
 					{
-						uint events = len / sizeof(struct input_event);
-						//logMsg("read %d bytes from input fd %d, %d events", len, this->fd, events);
-						processInputEvents(event, events);
+						msg.events = len / sizeof(struct input_event);
+						//logMsg("read %d bytes from input fd %d, %d events", len, this->fd, msg.events);
+						inputPipe.write(&msg, msg.size());
 					}
 					if(len == -1 && errno != EAGAIN)
 					{
 						logMsg("error %d reading from input fd %d (%s)", errno, fd, name());
-						removeFromSystem(fd);
+						postRemoval(msg);
 						return 0;
 					}
 				}
@@ -269,9 +301,16 @@ struct EvdevInputDevice : public Device
 			}};
 	}
 
-	void close()
+	void postRemoval(EvdevEventMsg &msg)
 	{
 		fdSrc.removeFromEventLoop();
+		msg.events = 0;
+		inputPipe.write(&msg, msg.headerSize());
+	}
+
+	void close()
+	{
+		removePollEvent(*this);
 		::close(fd);
 		removeDevice(*this);
 		onDeviceChange.callCopySafe(*this, { Device::Change::REMOVED });
@@ -310,6 +349,18 @@ static void removeFromSystem(int fd)
 	}
 }
 
+static void removePollEvent(EvdevInputDevice &dev)
+{
+	if(!inputThreadLoop)
+	{
+		dev.fdSrc.removeFromEventLoop();
+		return;
+	}
+	auto devPtr = &dev;
+	removePollPipe.write(&devPtr, sizeof(devPtr));
+	removePollSem.wait();
+}
+
 static bool devIsGamepad(int fd)
 {
 	ulong keyBit[Bits::elemsToHold<ulong>(KEY_MAX)] {0};
@@ -375,6 +426,12 @@ static bool processDevNode(const char *path, int id, bool notify)
 	auto &evDev = evDevice.back();
 	bool isJoystick = evDev->setupJoystickBits();
 
+	// use the same clock as frame timestamps instead of wall time
+	int clockId = CLOCK_MONOTONIC;
+	if(ioctl(fd, EVIOCSCLOCKID, &clockId) < 0)
+	{
+		logWarn("unable to set monotonic event clock");
+	}
 	fd_setNonblock(fd, 1);
 	evDev->addPollEvent();
 
@@ -407,8 +464,72 @@ static bool processDevNodeName(const char *name, FS::PathString &path, uint &id)
 	return true;
 }
 
+static void startInputThread()
+{
+	#ifdef CONFIG_BASE_EPOLL
+	IG::Semaphore sem{0};
+	IG::makeDetachedThread(
+		[&sem]()
+		{
+			inputThreadLoop = Base::EventLoop::makeForThread();
+			if(inputThreadLoop)
+			{
+				removePollPipe.init(inputThreadLoop,
+					[](Base::Pipe &pipe)
+					{
+						while(pipe.hasData())
+						{
+							EvdevInputDevice *dev;
+							if(!pipe.read(&dev, sizeof(dev)))
+								break;
+							dev->fdSrc.removeFromEventLoop();
+							removePollSem.notify();
+						}
+						return 1;
+					});
+			}
+			sem.notify();
+			if(!inputThreadLoop)
+			{
+				logErr("error creating input thread event loop");
+				return;
+			}
+			IG::this_thread::setRealtimePriority();
+			inputThreadLoop.run();
+		});
+	sem.wait();
+	#endif
+	if(!inputThreadLoop)
+		logMsg("reading input devices on main thread");
+}
+
+void flushEvents()
+{
+	while(inputPipe.hasData())
+	{
+		EvdevEventMsg msg;
+		if(!inputPipe.read(&msg, msg.headerSize()))
+			return;
+		if(!msg.events)
+		{
+			removeFromSystem(msg.dev->fd);
+			continue;
+		}
+		if(!inputPipe.read(msg.event, msg.events * sizeof(input_event)))
+			return;
+		msg.dev->processInputEvents(msg.event, msg.events);
+	}
+}
+
 void initEvdev(Base::EventLoop loop)
 {
+	inputPipe.init(loop,
+		[](Base::Pipe &)
+		{
+			flushEvents();
+			return 1;
+		});
+	startInputThread();
 	logMsg("setting up inotify for hotplug");
 	{
 		int inputDevNotifyFd = inotify_init();
@@ -477,6 +598,16 @@ void initEvdev(Base::EventLoop loop)
 	}
 }
 
+void deinitEvdev()
+{
+	// the input thread runs until the process exits, stop it from
+	// reading the devices before they're destroyed
+	for(auto &dev : evDevice)
+	{
+		removePollEvent(*dev);
+	}
+}
+
 Time Time::makeWithNSecs(uint64_t nsecs)
 {
 	return makeWithUSecs(nsecs / NSEC_PER_USEC);
@@ -20,4 +20,5 @@
 namespace Input
 {
 	void initEvdev(Base::EventLoop loop);
+	void deinitEvdev();
 }
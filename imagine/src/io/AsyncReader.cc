@@ -0,0 +1,423 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "AsyncReader"
+#include <imagine/io/AsyncReader.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/utility.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#if defined __linux__ && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define USE_IO_URING
+#endif
+
+static constexpr uint WORKER_THREADS = 2;
+
+enum SlotState : uint8
+{
+	SLOT_FREE, SLOT_QUEUED, SLOT_READING, SLOT_DONE
+};
+
+struct AsyncReader::Slot
+{
+	AsyncReader::Request req{};
+	ssize_t result = 0;
+	uint seq = 0;
+	std::atomic<uint8> state{SLOT_FREE};
+	#ifdef USE_IO_URING
+	iovec iov{};
+	#endif
+};
+
+#ifdef USE_IO_URING
+struct AsyncReader::Ring
+{
+	int fd = -1;
+	void *sqMap{}, *cqMap{};
+	size_t sqMapSize = 0, cqMapSize = 0;
+	io_uring_sqe *sqes{};
+	size_t sqesSize = 0;
+	uint *sqHead{}, *sqTail{}, *sqMask{}, *sqArray{};
+	uint *cqHead{}, *cqTail{}, *cqMask{};
+	io_uring_cqe *cqes{};
+	uint unsubmitted = 0;
+};
+
+static int ioUringSetup(uint entries, io_uring_params &p)
+{
+	return syscall(__NR_io_uring_setup, entries, &p);
+}
+
+static int ioUringEnter(int fd, uint toSubmit, uint minComplete, uint flags)
+{
+	return syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+}
+#else
+struct AsyncReader::Ring {};
+#endif
+
+AsyncReader::AsyncReader() {}
+
+AsyncReader::~AsyncReader()
+{
+	deinit();
+}
+
+bool AsyncReader::init(uint maxPending_)
+{
+	deinit();
+	assert(maxPending_);
+	maxPending = maxPending_;
+	slot = std::make_unique<Slot[]>(maxPending);
+	if(initRing())
+	{
+		logMsg("using io_uring with %u entries", maxPending);
+		return true;
+	}
+	startWorkers(WORKER_THREADS);
+	logMsg("using %u threads with %u entries", WORKER_THREADS, maxPending);
+	return true;
+}
+
+void AsyncReader::deinit()
+{
+	if(!maxPending)
+		return;
+	while(pendingReads)
+		wait();
+	if(worker.size())
+	{
+		quitWorkers = true;
+		iterateTimes(worker.size(), i)
+			workSem->notify();
+		for(auto &w : worker)
+			w.join();
+		worker.clear();
+		workSem.reset();
+		doneSem.reset();
+		quitWorkers = false;
+	}
+	deinitRing();
+	slot.reset();
+	maxPending = 0;
+	nextSeq = 0;
+}
+
+int AsyncReader::freeSlot() const
+{
+	iterateTimes(maxPending, i)
+	{
+		if(slot[i].state.load(std::memory_order_relaxed) == SLOT_FREE)
+			return i;
+	}
+	return -1;
+}
+
+uint AsyncReader::read(const Request *req, uint count)
+{
+	assert(maxPending);
+	uint queued = 0;
+	if(ring)
+	{
+		submitToRing(req, count, queued);
+		return queued;
+	}
+	for(; queued < count; queued++)
+	{
+		int idx = freeSlot();
+		if(idx == -1)
+			break;
+		auto &s = slot[idx];
+		s.req = req[queued];
+		s.seq = nextSeq++;
+		s.state.store(SLOT_QUEUED, std::memory_order_release);
+		pendingReads++;
+		workSem->notify();
+	}
+	return queued;
+}
+
+uint AsyncReader::processCompletions()
+{
+	if(!pendingReads)
+		return 0;
+	return ring ? reapRing() : reapWorkers();
+}
+
+uint AsyncReader::wait()
+{
+	uint completed = 0;
+	while(pendingReads && !completed)
+	{
+		completed = processCompletions();
+		if(completed)
+			break;
+		#ifdef USE_IO_URING
+		if(ring)
+		{
+			if(ioUringEnter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS) == -1 && errno != EINTR)
+			{
+				logErr("error waiting for completions: %s", strerror(errno));
+				return 0;
+			}
+			continue;
+		}
+		#endif
+		doneSem->wait();
+	}
+	return completed;
+}
+
+bool AsyncReader::usesIOUring() const
+{
+	return (bool)ring;
+}
+
+uint AsyncReader::complete(uint idx, ssize_t result)
+{
+	auto &s = slot[idx];
+	auto onComplete = s.req.onComplete;
+	s.req = {};
+	s.state.store(SLOT_FREE, std::memory_order_relaxed);
+	pendingReads--;
+	if(onComplete)
+		onComplete(result);
+	return 1;
+}
+
+#ifdef USE_IO_URING
+
+bool AsyncReader::initRing()
+{
+	io_uring_params p{};
+	int fd = ioUringSetup(maxPending, p);
+	if(fd == -1)
+	{
+		logMsg("io_uring not available: %s", strerror(errno));
+		return false;
+	}
+	auto r = std::make_unique<Ring>();
+	r->fd = fd;
+	r->sqMapSize = p.sq_off.array + p.sq_entries * sizeof(uint);
+	r->cqMapSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+	bool singleMap = p.features & IORING_FEAT_SINGLE_MMAP;
+	if(singleMap)
+		r->sqMapSize = r->cqMapSize = std::max(r->sqMapSize, r->cqMapSize);
+	r->sqMap = mmap(nullptr, r->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if(r->sqMap == MAP_FAILED)
+	{
+		logErr("error mapping submission ring: %s", strerror(errno));
+		close(fd);
+		return false;
+	}
+	if(singleMap)
+		r->cqMap = r->sqMap;
+	else
+	{
+		r->cqMap = mmap(nullptr, r->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if(r->cqMap == MAP_FAILED)
+		{
+			logErr("error mapping completion ring: %s", strerror(errno));
+			munmap(r->sqMap, r->sqMapSize);
+			close(fd);
+			return false;
+		}
+	}
+	r->sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+	auto sqes = mmap(nullptr, r->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if(sqes == MAP_FAILED)
+	{
+		logErr("error mapping submission entries: %s", strerror(errno));
+		if(!singleMap)
+			munmap(r->cqMap, r->cqMapSize);
+		munmap(r->sqMap, r->sqMapSize);
+		close(fd);
+		return false;
+	}
+	r->sqes = (io_uring_sqe*)sqes;
+	auto sq = (char*)r->sqMap;
+	r->sqHead = (uint*)(sq + p.sq_off.head);
+	r->sqTail = (uint*)(sq + p.sq_off.tail);
+	r->sqMask = (uint*)(sq + p.sq_off.ring_mask);
+	r->sqArray = (uint*)(sq + p.sq_off.array);
+	auto cq = (char*)r->cqMap;
+	r->cqHead = (uint*)(cq + p.cq_off.head);
+	r->cqTail = (uint*)(cq + p.cq_off.tail);
+	r->cqMask = (uint*)(cq + p.cq_off.ring_mask);
+	r->cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+	// slots never outnumber the rings, the kernel rounds entries up to a power of 2
+	maxPending = std::min(maxPending, p.sq_entries);
+	ring = std::move(r);
+	return true;
+}
+
+void AsyncReader::deinitRing()
+{
+	if(!ring)
+		return;
+	munmap(ring->sqes, ring->sqesSize);
+	if(ring->cqMap != ring->sqMap)
+		munmap(ring->cqMap, ring->cqMapSize);
+	munmap(ring->sqMap, ring->sqMapSize);
+	close(ring->fd);
+	ring.reset();
+}
+
+bool AsyncReader::submitToRing(const Request *req, uint count, uint &queued)
+{
+	auto &r = *ring;
+	uint tail = *r.sqTail;
+	uint mask = *r.sqMask;
+	for(; queued < count; queued++)
+	{
+		int idx = freeSlot();
+		if(idx == -1)
+			break;
+		auto &s = slot[idx];
+		s.req = req[queued];
+		s.seq = nextSeq++;
+		s.iov = {s.req.buf, s.req.bytes};
+		s.state.store(SLOT_READING, std::memory_order_relaxed);
+		uint sqIdx = tail & mask;
+		auto &sqe = r.sqes[sqIdx];
+		sqe = {};
+		// READV instead of READ works with kernels back to 5.1
+		sqe.opcode = IORING_OP_READV;
+		sqe.fd = s.req.fd;
+		sqe.addr = (uintptr_t)&s.iov;
+		sqe.len = 1;
+		sqe.off = s.req.offset;
+		sqe.user_data = idx;
+		r.sqArray[sqIdx] = sqIdx;
+		tail++;
+		pendingReads++;
+		r.unsubmitted++;
+	}
+	if(!r.unsubmitted)
+		return true;
+	__atomic_store_n(r.sqTail, tail, __ATOMIC_RELEASE);
+	int submitted = ioUringEnter(r.fd, r.unsubmitted, 0, 0);
+	if(submitted == -1)
+	{
+		// entries stay in the ring and go with the next submission
+		if(errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			logErr("error submitting %u reads: %s", r.unsubmitted, strerror(errno));
+		return false;
+	}
+	r.unsubmitted -= std::min((uint)submitted, r.unsubmitted);
+	return true;
+}
+
+uint AsyncReader::reapRing()
+{
+	auto &r = *ring;
+	if(r.unsubmitted)
+	{
+		uint queued = 0;
+		submitToRing(nullptr, 0, queued);
+	}
+	uint head = *r.cqHead;
+	uint tail = __atomic_load_n(r.cqTail, __ATOMIC_ACQUIRE);
+	uint mask = *r.cqMask;
+	uint completed = 0;
+	while(head != tail)
+	{
+		auto cqe = r.cqes[head & mask];
+		head++;
+		__atomic_store_n(r.cqHead, head, __ATOMIC_RELEASE);
+		completed += complete(cqe.user_data, cqe.res);
+	}
+	return completed;
+}
+
+#else
+
+bool AsyncReader::initRing() { return false; }
+
+void AsyncReader::deinitRing() {}
+
+bool AsyncReader::submitToRing(const Request *, uint, uint &) { return false; }
+
+uint AsyncReader::reapRing() { return 0; }
+
+#endif
+
+void AsyncReader::startWorkers(uint threads)
+{
+	workSem = std::make_unique<IG::Semaphore>(0);
+	doneSem = std::make_unique<IG::Semaphore>(0);
+	iterateTimes(threads, i)
+	{
+		worker.emplace_back([this](){ runWorker(); });
+	}
+}
+
+void AsyncReader::runWorker()
+{
+	for(;;)
+	{
+		workSem->wait();
+		if(quitWorkers)
+			return;
+		// each notify matches one queued slot, take the oldest one not claimed by another worker
+		for(;;)
+		{
+			Slot *oldest{};
+			iterateTimes(maxPending, i)
+			{
+				auto &s = slot[i];
+				if(s.state.load(std::memory_order_acquire) == SLOT_QUEUED
+					&& (!oldest || (int)(s.seq - oldest->seq) < 0))
+				{
+					oldest = &s;
+				}
+			}
+			// the slot this notify was for went to a worker that woke earlier
+			if(!oldest)
+				break;
+			uint8 expected = SLOT_QUEUED;
+			if(!oldest->state.compare_exchange_strong(expected, SLOT_READING, std::memory_order_acquire))
+				continue;
+			auto &req = oldest->req;
+			ssize_t result;
+			do
+			{
+				result = pread(req.fd, req.buf, req.bytes, req.offset);
+			} while(result == -1 && errno == EINTR);
+			oldest->result = result == -1 ? -errno : result;
+			oldest->state.store(SLOT_DONE, std::memory_order_release);
+			doneSem->notify();
+			break;
+		}
+	}
+}
+
+uint AsyncReader::reapWorkers()
+{
+	uint completed = 0;
+	iterateTimes(maxPending, i)
+	{
+		if(slot[i].state.load(std::memory_order_acquire) == SLOT_DONE)
+			completed += complete(i, slot[i].result);
+	}
+	return completed;
+}
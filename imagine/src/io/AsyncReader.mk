@@ -0,0 +1,10 @@
+ifndef inc_io_async_reader
+inc_io_async_reader := 1
+
+include $(IMAGINE_PATH)/src/io/IO.mk
+
+configDefs += CONFIG_IO_ASYNC_READER
+
+SRC += io/AsyncReader.cc
+
+endif
@@ -0,0 +1,568 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "PatchIO"
+#include <imagine/io/PatchIO.hh>
+#include <imagine/io/BufferMapIO.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/utility.h>
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+#include "utils.hh"
+
+static constexpr uint FOOTER_SIZE = 12; // UPS & BPS source, target, and patch CRC32s
+
+static uint32 readLE32(const char *p)
+{
+	auto b = (const uint8*)p;
+	return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32)b[3] << 24);
+}
+
+// streams like ArchiveIO can't seek inside compressed entries and readAtPos()
+// ignores failed seeks, so sources without a memory map are read in once
+static std::error_code bufferSource(GenericIO &io)
+{
+	if(io.mmapConst())
+		return {};
+	auto size = io.size();
+	auto buff = new char[size];
+	for(size_t pos = 0; pos < size;)
+	{
+		auto bytesRead = io.read(buff + pos, size - pos);
+		if(bytesRead <= 0)
+		{
+			delete[] buff;
+			return {EIO, std::system_category()};
+		}
+		pos += bytesRead;
+	}
+	BufferMapIO buffIO{};
+	buffIO.open(buff, size, [](BufferMapIO &io){ delete[] io.mmapConst(); });
+	io = buffIO.makeGeneric();
+	return {};
+}
+
+static uint readBE(const char *p, uint bytes)
+{
+	uint val = 0;
+	iterateTimes(bytes, i)
+	{
+		val = (val << 8) | (uint8)p[i];
+	}
+	return val;
+}
+
+// variable length number used by UPS & BPS
+static bool decodeNumber(const char *&p, const char *end, size_t &out)
+{
+	uint64 data = 0, shift = 1;
+	while(p < end && shift < (uint64(1) << 56))
+	{
+		uint8 x = *p++;
+		data += (x & 0x7f) * shift;
+		if(x & 0x80)
+		{
+			out = data;
+			return true;
+		}
+		shift <<= 7;
+		data += shift;
+	}
+	return false;
+}
+
+static std::error_code invalidPatch(const char *msg)
+{
+	logErr("%s", msg);
+	return {EINVAL, std::system_category()};
+}
+
+PatchIO::~PatchIO()
+{
+	close();
+}
+
+GenericIO PatchIO::makeGeneric()
+{
+	return GenericIO{*this};
+}
+
+std::error_code PatchIO::open(GenericIO &source, IO &patch)
+{
+	close();
+	auto patchSize = patch.size();
+	std::vector<char> patchBuff(patchSize);
+	if(patch.readAtPos(patchBuff.data(), patchSize, 0) != (ssize_t)patchSize)
+	{
+		logErr("error reading patch");
+		return {EIO, std::system_category()};
+	}
+	if(auto ec = bufferSource(source);
+		ec)
+	{
+		logErr("error reading source");
+		return ec;
+	}
+	src = std::move(source);
+	outSize = src.size();
+	extent.emplace(0, Extent{outSize, 0, Source::ORIGINAL});
+	std::error_code ec{};
+	auto data = patchBuff.data();
+	if(patchSize >= 5 && !memcmp(data, "PATCH", 5))
+	{
+		format_ = Format::IPS;
+		ec = parseIPS(data, patchSize);
+	}
+	else if(patchSize >= 4 && !memcmp(data, "UPS1", 4))
+	{
+		format_ = Format::UPS;
+		ec = parseUPS(data, patchSize);
+	}
+	else if(patchSize >= 4 && !memcmp(data, "BPS1", 4))
+	{
+		format_ = Format::BPS;
+		ec = parseBPS(data, patchSize);
+	}
+	else
+	{
+		ec = invalidPatch("unknown patch format");
+	}
+	if(ec)
+	{
+		source = std::move(src);
+		reset();
+		return ec;
+	}
+	patchData.shrink_to_fit();
+	logMsg("patched %zu bytes into %zu byte output with %zu ranges",
+		patchData.size(), outSize, extent.size());
+	return {};
+}
+
+void PatchIO::reset()
+{
+	extent.clear();
+	patchData.clear();
+	patchData.shrink_to_fit();
+	outSize = pos = 0;
+	format_ = Format::NONE;
+}
+
+std::map<size_t, PatchIO::Extent>::iterator PatchIO::splitAt(size_t outOffset)
+{
+	auto next = extent.upper_bound(outOffset);
+	if(next == extent.begin())
+		return next;
+	auto prev = std::prev(next);
+	auto start = prev->first;
+	auto &e = prev->second;
+	if(start == outOffset)
+		return prev;
+	if(start + e.size <= outOffset)
+		return next;
+	size_t headSize = outOffset - start;
+	Extent tail{e.size - headSize, e.src == Source::ZERO ? 0 : e.offset + headSize, e.src};
+	e.size = headSize;
+	return extent.emplace_hint(next, outOffset, tail);
+}
+
+void PatchIO::addExtent(size_t outOffset, Extent e)
+{
+	if(!e.size)
+		return;
+	auto next = extent.lower_bound(outOffset);
+	if(next != extent.begin())
+	{
+		// extend the previous range if this one continues it
+		auto &prev = *std::prev(next);
+		auto &p = prev.second;
+		if(prev.first + p.size == outOffset && p.src == e.src
+			&& (e.src == Source::ZERO || p.offset + p.size == e.offset))
+		{
+			p.size += e.size;
+			return;
+		}
+	}
+	extent.emplace_hint(next, outOffset, e);
+}
+
+char *PatchIO::overlay(size_t outOffset, size_t size)
+{
+	if(outOffset + size > outSize)
+		resize(outOffset + size);
+	auto first = splitAt(outOffset);
+	auto last = splitAt(outOffset + size);
+	extent.erase(first, last);
+	auto start = patchData.size();
+	patchData.resize(start + size);
+	addExtent(outOffset, {size, start, Source::PATCH});
+	return &patchData[start];
+}
+
+void PatchIO::resize(size_t size)
+{
+	if(size > outSize)
+	{
+		addExtent(outSize, {size - outSize, 0, Source::ZERO});
+	}
+	else if(size < outSize)
+	{
+		extent.erase(splitAt(size), extent.end());
+	}
+	outSize = size;
+}
+
+bool PatchIO::sourceMatches(size_t size, uint32 crc)
+{
+	if(src.size() != size)
+	{
+		logErr("source size:%zu doesn't match patch:%zu", src.size(), size);
+		return false;
+	}
+	uLong srcCrc = crc32(0, nullptr, 0);
+	if(auto data = src.mmapConst(); data)
+	{
+		srcCrc = crc32(srcCrc, (const Bytef*)data, size);
+	}
+	else
+	{
+		char buff[65536];
+		for(size_t offset = 0; offset < size;)
+		{
+			auto bytes = std::min(size - offset, sizeof(buff));
+			if(src.readAtPos(buff, bytes, offset) != (ssize_t)bytes)
+				return false;
+			srcCrc = crc32(srcCrc, (const Bytef*)buff, bytes);
+			offset += bytes;
+		}
+	}
+	if(srcCrc != crc)
+	{
+		logErr("source CRC:0x%X doesn't match patch:0x%X", (uint)srcCrc, crc);
+		return false;
+	}
+	return true;
+}
+
+static bool patchCRCMatches(const char *patch, size_t patchSize)
+{
+	auto crc = crc32(0, (const Bytef*)patch, patchSize - 4);
+	return crc == readLE32(patch + patchSize - 4);
+}
+
+std::error_code PatchIO::parseIPS(const char *patch, size_t patchSize)
+{
+	auto p = patch + 5;
+	auto end = patch + patchSize;
+	while(true)
+	{
+		if(end - p < 3)
+			return invalidPatch("IPS patch missing EOF marker");
+		if(!memcmp(p, "EOF", 3))
+		{
+			p += 3;
+			// optional truncated size
+			if(end - p == 3)
+				resize(readBE(p, 3));
+			return {};
+		}
+		if(end - p < 5)
+			return invalidPatch("truncated IPS record");
+		size_t offset = readBE(p, 3);
+		size_t size = readBE(p + 3, 2);
+		p += 5;
+		if(size)
+		{
+			if((size_t)(end - p) < size)
+				return invalidPatch("truncated IPS record");
+			memcpy(overlay(offset, size), p, size);
+			p += size;
+		}
+		else
+		{
+			// run-length encoded record
+			if(end - p < 3)
+				return invalidPatch("truncated IPS record");
+			size = readBE(p, 2);
+			memset(overlay(offset, size), p[2], size);
+			p += 3;
+		}
+	}
+}
+
+std::error_code PatchIO::parseUPS(const char *patch, size_t patchSize)
+{
+	if(patchSize < 4 + FOOTER_SIZE)
+		return invalidPatch("UPS patch too small");
+	if(!patchCRCMatches(patch, patchSize))
+		return invalidPatch("UPS patch CRC mismatch");
+	auto p = patch + 4;
+	auto end = patch + patchSize - FOOTER_SIZE;
+	size_t srcSize, dstSize;
+	if(!decodeNumber(p, end, srcSize) || !decodeNumber(p, end, dstSize))
+		return invalidPatch("bad UPS header");
+	if(!sourceMatches(srcSize, readLE32(end)))
+		return invalidPatch("UPS patch doesn't match this file");
+	resize(dstSize);
+	size_t offset = 0;
+	while(p < end)
+	{
+		size_t skip;
+		if(!decodeNumber(p, end, skip))
+			return invalidPatch("bad UPS hunk offset");
+		offset += skip;
+		// XOR bytes up to a terminating zero
+		auto hunk = p;
+		while(p < end && *p)
+			p++;
+		if(p == end)
+			return invalidPatch("unterminated UPS hunk");
+		size_t size = p - hunk;
+		p++;
+		if(offset + size > dstSize)
+			return invalidPatch("UPS hunk past end of output");
+		if(size)
+		{
+			auto out = overlay(offset, size);
+			size_t srcBytes = offset < srcSize ? std::min(size, srcSize - offset) : 0;
+			if(srcBytes && src.readAtPos(out, srcBytes, offset) != (ssize_t)srcBytes)
+				return {EIO, std::system_category()};
+			iterateTimes(size, i)
+			{
+				out[i] ^= hunk[i];
+			}
+		}
+		offset += size + 1;
+	}
+	return {};
+}
+
+std::error_code PatchIO::parseBPS(const char *patch, size_t patchSize)
+{
+	if(patchSize < 4 + FOOTER_SIZE)
+		return invalidPatch("BPS patch too small");
+	if(!patchCRCMatches(patch, patchSize))
+		return invalidPatch("BPS patch CRC mismatch");
+	auto p = patch + 4;
+	auto end = patch + patchSize - FOOTER_SIZE;
+	size_t srcSize, dstSize, metadataSize;
+	if(!decodeNumber(p, end, srcSize) || !decodeNumber(p, end, dstSize)
+		|| !decodeNumber(p, end, metadataSize) || (size_t)(end - p) < metadataSize)
+		return invalidPatch("bad BPS header");
+	p += metadataSize;
+	if(!sourceMatches(srcSize, readLE32(end)))
+		return invalidPatch("BPS patch doesn't match this file");
+	// output is built from scratch by the patch's actions
+	extent.clear();
+	outSize = 0;
+	size_t srcRelOffset = 0, dstRelOffset = 0;
+	auto relOffset = [](size_t &relOffset, size_t data, size_t limit)
+		{
+			size_t delta = data >> 1;
+			if(data & 1)
+			{
+				if(delta > relOffset)
+					return false;
+				relOffset -= delta;
+			}
+			else
+				relOffset += delta;
+			return relOffset < limit;
+		};
+	while(p < end)
+	{
+		size_t data;
+		if(!decodeNumber(p, end, data))
+			return invalidPatch("bad BPS action");
+		size_t size = (data >> 2) + 1;
+		if(size > dstSize - outSize)
+			return invalidPatch("BPS action past end of output");
+		switch(data & 3)
+		{
+			bcase 0: // source read
+			{
+				if(outSize + size > srcSize)
+					return invalidPatch("BPS source read past end of input");
+				addExtent(outSize, {size, outSize, Source::ORIGINAL});
+			}
+			bcase 1: // target read
+			{
+				if((size_t)(end - p) < size)
+					return invalidPatch("truncated BPS target read");
+				auto start = patchData.size();
+				patchData.insert(patchData.end(), p, p + size);
+				addExtent(outSize, {size, start, Source::PATCH});
+				p += size;
+			}
+			bcase 2: // source copy
+			{
+				if(!decodeNumber(p, end, data) || !relOffset(srcRelOffset, data, srcSize)
+					|| size > srcSize - srcRelOffset)
+					return invalidPatch("bad BPS source copy");
+				addExtent(outSize, {size, srcRelOffset, Source::ORIGINAL});
+				srcRelOffset += size;
+			}
+			bcase 3: // target copy, may overlap the bytes it's producing to repeat a pattern
+			{
+				if(!decodeNumber(p, end, data) || !relOffset(dstRelOffset, data, outSize))
+					return invalidPatch("bad BPS target copy");
+				size_t distance = outSize - dstRelOffset;
+				auto start = patchData.size();
+				patchData.resize(start + size);
+				auto out = &patchData[start];
+				size_t existingBytes = std::min(size, distance);
+				if(!readExtents(out, existingBytes, dstRelOffset))
+					return {EIO, std::system_category()};
+				for(size_t i = existingBytes; i < size; i++)
+				{
+					out[i] = out[i - distance];
+				}
+				addExtent(outSize, {size, start, Source::PATCH});
+				dstRelOffset += size;
+			}
+		}
+		outSize += size;
+	}
+	if(outSize != dstSize)
+		return invalidPatch("BPS output size mismatch");
+	return {};
+}
+
+bool PatchIO::readExtents(char *buff, size_t bytes, size_t offset)
+{
+	auto it = std::prev(extent.upper_bound(offset));
+	while(bytes)
+	{
+		auto &e = it->second;
+		size_t within = offset - it->first;
+		size_t size = std::min(bytes, e.size - within);
+		switch(e.src)
+		{
+			bcase Source::ORIGINAL:
+				if(src.readAtPos(buff, size, e.offset + within) != (ssize_t)size)
+					return false;
+			bcase Source::PATCH:
+				memcpy(buff, &patchData[e.offset + within], size);
+			bcase Source::ZERO:
+				memset(buff, 0, size);
+		}
+		buff += size;
+		offset += size;
+		bytes -= size;
+		++it;
+	}
+	return true;
+}
+
+ssize_t PatchIO::read(void *buff, size_t bytes, std::error_code *ecOut)
+{
+	auto bytesRead = readAtPos(buff, bytes, pos, ecOut);
+	if(bytesRead > 0)
+		pos += bytesRead;
+	return bytesRead;
+}
+
+ssize_t PatchIO::readAtPos(void *buff, size_t bytes, off_t offset, std::error_code *ecOut)
+{
+	if(!*this)
+	{
+		if(ecOut)
+			*ecOut = {EBADF, std::system_category()};
+		return -1;
+	}
+	if(offset < 0 || (size_t)offset >= outSize)
+		return 0;
+	bytes = std::min(bytes, outSize - offset);
+	if(!readExtents((char*)buff, bytes, offset))
+	{
+		if(ecOut)
+			*ecOut = {EIO, std::system_category()};
+		return -1;
+	}
+	return bytes;
+}
+
+ssize_t PatchIO::write(const void *buff, size_t bytes, std::error_code *ecOut)
+{
+	if(ecOut)
+		*ecOut = {ENOSYS, std::system_category()};
+	return -1;
+}
+
+off_t PatchIO::seek(off_t offset, IO::SeekMode mode, std::error_code *ecOut)
+{
+	if(!isSeekModeValid(mode))
+	{
+		logErr("invalid seek parameter: %d", (int)mode);
+		if(ecOut)
+			*ecOut = {EINVAL, std::system_category()};
+		return -1;
+	}
+	auto newPos = transformOffsetToAbsolute(mode, offset, 0, outSize, pos);
+	if(newPos < 0 || (size_t)newPos > outSize)
+	{
+		logErr("illegal seek position");
+		if(ecOut)
+			*ecOut = {EINVAL, std::system_category()};
+		return -1;
+	}
+	pos = newPos;
+	return pos;
+}
+
+void PatchIO::close()
+{
+	if(!*this)
+		return;
+	src.close();
+	src = {};
+	reset();
+}
+
+size_t PatchIO::size()
+{
+	return outSize;
+}
+
+bool PatchIO::eof()
+{
+	return pos >= outSize;
+}
+
+void PatchIO::advise(off_t offset_, size_t bytes, Advice advice)
+{
+	size_t offset = offset_;
+	if(!*this || offset >= outSize)
+		return;
+	if(!bytes || bytes > outSize - offset)
+		bytes = outSize - offset;
+	// pass the advice on for the ranges still read from the source
+	for(auto it = std::prev(extent.upper_bound(offset)); it != extent.end() && it->first < offset + bytes; ++it)
+	{
+		auto &e = it->second;
+		if(e.src != Source::ORIGINAL)
+			continue;
+		size_t start = std::max(offset, it->first);
+		size_t end = std::min(offset + bytes, it->first + e.size);
+		src.advise(e.offset + (start - it->first), end - start, advice);
+	}
+}
+
+PatchIO::operator bool()
+{
+	return format_ != Format::NONE;
+}
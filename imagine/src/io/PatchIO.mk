@@ -0,0 +1,13 @@
+ifndef inc_io_patch
+inc_io_patch := 1
+
+include $(IMAGINE_PATH)/src/io/IO.mk
+include $(IMAGINE_PATH)/src/io/MapIO.mk
+
+include $(IMAGINE_PATH)/make/package/zlib.mk
+
+configDefs += CONFIG_IO_PATCH
+
+SRC += io/PatchIO.cc
+
+endif
@@ -3,6 +3,7 @@ inc_io_fd := 1
 
 include $(IMAGINE_PATH)/src/io/IO.mk
 include $(IMAGINE_PATH)/src/io/MapIO.mk
+include $(IMAGINE_PATH)/src/io/AsyncReader.mk
 
 SRC += io/PosixIO.cc io/PosixFileIO.cc
 
@@ -7,4 +7,9 @@ ifeq ($(ENV), android)
  LDLIBS += -llog
 endif
 
+ifneq ($(ENV), win32)
+ configDefs += CONFIG_LOGGER_ASYNC
+ include $(imagineSrcDir)/thread/system.mk
+endif
+
 endif
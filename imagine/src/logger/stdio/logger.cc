@@ -19,6 +19,15 @@
 #include <imagine/logger/logger.h>
 #include <imagine/util/string.h>
 #include <cstdio>
+#ifdef CONFIG_LOGGER_ASYNC
+#include <imagine/thread/Thread.hh>
+#include <imagine/util/algorithm.h>
+#include <imagine/thread/Semaphore.hh>
+#include <imagine/time/Time.hh>
+#include <atomic>
+#include <cstdlib>
+#include <unistd.h>
+#endif
 
 #ifdef __ANDROID__
 #include <android/log.h>
@@ -36,6 +45,37 @@ static const bool useExternalLogFile = false;
 static FILE *logExternalFile{};
 static bool logEnabled = Config::DEBUG_BUILD; // default logging off in release builds
 
+#ifdef CONFIG_LOGGER_ASYNC
+// Messages are formatted by the caller into a fixed size record of a
+// bounded lock-free queue and written out by a background thread, so logging
+// costs a vsnprintf and never blocks on the console or log file. When the
+// queue is full, messages are dropped and counted rather than waited on.
+struct LogRecord
+{
+	std::atomic_uint seq{};
+	char text[252]{};
+};
+
+struct LogRateLimit
+{
+	std::atomic<const char*> site{};
+	std::atomic_uint sec{};
+	std::atomic_uint count{};
+	std::atomic_uint suppressed{};
+};
+
+static constexpr uint LOG_RING_SIZE = 512; // power of 2
+static constexpr uint LOG_RATE_SITES = 256;
+static constexpr uint LOG_SITE_MAX_PER_SEC = 50;
+static LogRecord logRing[LOG_RING_SIZE]{};
+static LogRateLimit logRate[LOG_RATE_SITES]{};
+static std::atomic_uint logRingHead{}, logRingTail{};
+static std::atomic_uint logDropped{};
+static std::atomic_bool logAsync{};
+static std::atomic_bool logThreadSleeping{};
+static IG::Semaphore *logThreadSem{};
+#endif
+
 static FS::PathString externalLogPath()
 {
 	FS::PathString path{};
@@ -50,10 +90,17 @@ static FS::PathString externalLogPath()
 	return path;
 }
 
+#ifdef CONFIG_LOGGER_ASYNC
+static void startLogThread();
+#endif
+
 void logger_init()
 {
 	if(!logEnabled)
 		return;
+	#ifdef CONFIG_LOGGER_ASYNC
+	startLogThread();
+	#endif
 	#if defined __APPLE__ && (defined __i386__ || defined __x86_64__)
 	asl_add_log_file(nullptr, STDERR_FILENO); // output to stderr
 	#endif
@@ -85,12 +132,8 @@ static void printToLogLineBuffer(const char* msg, va_list args)
 	vsnprintf(logLineBuffer + strlen(logLineBuffer), sizeof(logLineBuffer) - strlen(logLineBuffer), msg, args);
 }
 
-void logger_vprintf(LoggerSeverity severity, const char* msg, va_list args)
+static void printLog(const char* msg, va_list args, bool endsLine)
 {
-	if(!logEnabled)
-		return;
-	if(severity > loggerVerbosity) return;
-
 	if(logExternalFile)
 	{
 		va_list args2;
@@ -100,7 +143,7 @@ void logger_vprintf(LoggerSeverity severity, const char* msg, va_list args)
 		fflush(logExternalFile);
 	}
 
-	if(bufferLogLineOutput && !strchr(msg, '\n'))
+	if(bufferLogLineOutput && !endsLine)
 	{
 		printToLogLineBuffer(msg, args);
 		return;
@@ -129,6 +172,160 @@ void logger_vprintf(LoggerSeverity severity, const char* msg, va_list args)
 	#endif
 }
 
+#ifdef CONFIG_LOGGER_ASYNC
+static void printLogText(bool endsLine, const char* msg, ...)
+{
+	va_list args;
+	va_start(args, msg);
+	printLog(msg, args, endsLine);
+	va_end(args);
+}
+
+static bool ringHasRecords()
+{
+	auto tail = logRingTail.load(std::memory_order_relaxed);
+	return logRing[tail % LOG_RING_SIZE].seq.load(std::memory_order_acquire) == tail + 1;
+}
+
+static bool pushRecord(const char* msg, va_list args)
+{
+	auto pos = logRingHead.load(std::memory_order_relaxed);
+	LogRecord *rec;
+	for(;;)
+	{
+		rec = &logRing[pos % LOG_RING_SIZE];
+		int diff = (int)(rec->seq.load(std::memory_order_acquire) - pos);
+		if(diff == 0)
+		{
+			if(logRingHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if(diff < 0)
+		{
+			logDropped++;
+			return false;
+		}
+		else
+			pos = logRingHead.load(std::memory_order_relaxed);
+	}
+	vsnprintf(rec->text, sizeof(rec->text), msg, args);
+	if(strchr(msg, '\n') && !strchr(rec->text, '\n'))
+	{
+		// keep the line break of a truncated message
+		rec->text[sizeof(rec->text) - 2] = '\n';
+	}
+	rec->seq.store(pos + 1, std::memory_order_release);
+	// pairs with the fence in runLogThread() so either the log thread sees
+	// this record before sleeping or this sees it sleeping and wakes it
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(logThreadSleeping.load() && logThreadSleeping.exchange(false))
+		logThreadSem->notify();
+	return true;
+}
+
+static void pushRecordf(const char* msg, ...)
+{
+	va_list args;
+	va_start(args, msg);
+	pushRecord(msg, args);
+	va_end(args);
+}
+
+// returns false if the call site logged too often in the current second
+static bool passesRateLimit(const char* site)
+{
+	auto &limit = logRate[((uintptr_t)site >> 2) % LOG_RATE_SITES];
+	uint sec = IG::Time::now().secs();
+	if(limit.site.load(std::memory_order_relaxed) != site)
+	{
+		// slot taken by another site, the limit is approximate so just restart it
+		limit.site.store(site, std::memory_order_relaxed);
+		limit.sec = sec;
+		limit.count = 0;
+		limit.suppressed = 0;
+	}
+	else if(limit.sec.load(std::memory_order_relaxed) != sec)
+	{
+		limit.sec = sec;
+		limit.count = 0;
+		if(uint suppressed = limit.suppressed.exchange(0); suppressed)
+		{
+			pushRecordf("LoggerStdio: suppressed %u messages from: %.64s\n", suppressed, site);
+		}
+	}
+	if(limit.count++ >= LOG_SITE_MAX_PER_SEC)
+	{
+		limit.suppressed++;
+		return false;
+	}
+	return true;
+}
+
+static void runLogThread()
+{
+	for(;;)
+	{
+		if(!ringHasRecords())
+		{
+			if(uint dropped = logDropped.exchange(0); dropped)
+			{
+				printLogText(true, "LoggerStdio: dropped %u messages\n", dropped);
+			}
+			logThreadSleeping.store(true);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(!ringHasRecords())
+				logThreadSem->wait();
+			logThreadSleeping.store(false);
+			continue;
+		}
+		auto tail = logRingTail.load(std::memory_order_relaxed);
+		auto &rec = logRing[tail % LOG_RING_SIZE];
+		printLogText(strchr(rec.text, '\n'), "%s", rec.text);
+		rec.seq.store(tail + LOG_RING_SIZE, std::memory_order_release);
+		logRingTail.store(tail + 1, std::memory_order_release);
+	}
+}
+
+static void flushLogThread()
+{
+	// give the log thread up to a second to write out pending messages
+	for(uint i = 0; i < 1000 && logRingTail.load() != logRingHead.load(); i++)
+	{
+		usleep(1000);
+	}
+}
+
+static void startLogThread()
+{
+	if(logAsync)
+		return;
+	iterateTimes(LOG_RING_SIZE, i)
+	{
+		logRing[i].seq.store(i, std::memory_order_relaxed);
+	}
+	logThreadSem = new IG::Semaphore{0};
+	IG::makeDetachedThread(runLogThread);
+	std::atexit(flushLogThread);
+	logAsync = true;
+}
+#endif
+
+void logger_vprintf(LoggerSeverity severity, const char* msg, va_list args)
+{
+	if(!logEnabled)
+		return;
+	if(severity > loggerVerbosity) return;
+	#ifdef CONFIG_LOGGER_ASYNC
+	if(logAsync.load(std::memory_order_relaxed))
+	{
+		if(passesRateLimit(msg))
+			pushRecord(msg, args);
+		return;
+	}
+	#endif
+	printLog(msg, args, strchr(msg, '\n'));
+}
+
 void logger_printf(LoggerSeverity severity, const char* msg, ...)
 {
 	if(!logEnabled)
@@ -16,6 +16,8 @@
 #include <imagine/logger/logger.h>
 #include <imagine/thread/Thread.hh>
 #include <assert.h>
+#include <cstring>
+#include <sched.h>
 
 namespace IG
 {
@@ -34,6 +36,14 @@ thread::thread(thread&& other)
 	other.id_ = {};
 }
 
+thread &thread::operator=(thread&& other)
+{
+	assert(!joinable());
+	id_ = other.id_;
+	other.id_ = {};
+	return *this;
+}
+
 bool thread::joinable() const
 {
 	return get_id() != thread::id{};
@@ -66,6 +76,20 @@ void thread::detach()
 		return pthread_self();
 	}
 
+	bool setRealtimePriority()
+	{
+		sched_param param{};
+		param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+		if(int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+			err)
+		{
+			logWarn("unable to use real-time scheduling: %s", strerror(err));
+			return false;
+		}
+		logMsg("using real-time scheduling with priority %d", param.sched_priority);
+		return true;
+	}
+
 	}
 
 }
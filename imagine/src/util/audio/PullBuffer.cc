@@ -0,0 +1,210 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "PullBuffer"
+#include <imagine/util/audio/PullBuffer.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/utility.h>
+#include <algorithm>
+#include <cstring>
+
+namespace Audio
+{
+
+template <class T>
+static void concealSamples(T *out, uint frames, uint channels, const T *last, uint lastFrames,
+	uint &gain, uint fullGain, int center)
+{
+	iterateTimes(frames, i)
+	{
+		iterateTimes(channels, ch)
+		{
+			int s = lastFrames ? last[(i % lastFrames) * channels + ch] : center;
+			out[i * channels + ch] = center + (s - center) * (int)gain / (int)fullGain;
+		}
+		if(gain)
+			gain--;
+	}
+}
+
+template <class T>
+static void fadeInSamples(T *out, uint frames, uint channels, uint &gain, uint fullGain, int center)
+{
+	for(uint i = 0; i < frames && gain < fullGain; i++, gain++)
+	{
+		iterateTimes(channels, ch)
+		{
+			int s = out[i * channels + ch];
+			out[i * channels + ch] = center + (s - center) * (int)gain / (int)fullGain;
+		}
+	}
+}
+
+bool PullBuffer::init(PcmFormat format_, uint frames)
+{
+	assert(format_.sample.toBits() == 8 || format_.sample.toBits() == 16);
+	format = format_;
+	if(!rBuff.init(format.framesToBytes(frames)))
+	{
+		deinit();
+		return false;
+	}
+	capacityFrames = frames;
+	fadeFrames = std::max(format.rate / 100, 1); // 10ms
+	lastSamples.resize(format.framesToBytes(fadeFrames));
+	reset();
+	resetStats();
+	return true;
+}
+
+void PullBuffer::deinit()
+{
+	rBuff.deinit();
+	lastSamples.clear();
+	lastSamples.shrink_to_fit();
+	capacityFrames = 0;
+}
+
+void PullBuffer::reset()
+{
+	rBuff.reset();
+	lastFrames = 0;
+	gain = 0;
+	// the first read after a reset usually comes before the buffer fills
+	underrun = true;
+}
+
+uint PullBuffer::write(const void *samples, uint frames)
+{
+	uint bytes = format.framesToBytes(frames);
+	if(bytes > rBuff.freeSpace())
+	{
+		uint freeFrames = framesFree();
+		droppedFrames += frames - freeFrames;
+		frames = freeFrames;
+		bytes = format.framesToBytes(frames);
+	}
+	auto src = (const char*)samples;
+	while(bytes)
+	{
+		uint copyBytes = std::min(bytes, std::min(rBuff.freeSpace(), rBuff.freeContiguousSpace()));
+		memcpy(rBuff.writeAddr(), src, copyBytes);
+		rBuff.commitWrite(copyBytes);
+		src += copyBytes;
+		bytes -= copyBytes;
+	}
+	return frames;
+}
+
+void PullBuffer::read(void *samples, uint frames)
+{
+	uint queued = framesQueued();
+	if(queued < minQueuedFrames)
+		minQueuedFrames = queued;
+	uint readFrames = std::min(frames, queued);
+	uint bytes = format.framesToBytes(readFrames);
+	auto dest = (char*)samples;
+	while(bytes)
+	{
+		uint copyBytes = std::min(bytes, rBuff.writtenContiguousSize());
+		memcpy(dest, rBuff.readAddr(), copyBytes);
+		rBuff.commitRead(copyBytes);
+		dest += copyBytes;
+		bytes -= copyBytes;
+	}
+	if(readFrames)
+	{
+		fadeIn((char*)samples, readFrames);
+		lastFrames = std::min(readFrames, fadeFrames);
+		memcpy(lastSamples.data(), dest - format.framesToBytes(lastFrames), format.framesToBytes(lastFrames));
+		underrun = false;
+	}
+	if(readFrames < frames)
+	{
+		if(!underrun)
+		{
+			underrun = true;
+			underruns++;
+		}
+		uint missingFrames = frames - readFrames;
+		concealedFrames += missingFrames;
+		conceal(dest, missingFrames);
+	}
+}
+
+void PullBuffer::conceal(char *samples, uint frames)
+{
+	auto channels = format.channels;
+	switch(format.sample.toBits())
+	{
+		case 16:
+			return concealSamples((int16*)samples, frames, channels, (const int16*)lastSamples.data(),
+				lastFrames, gain, fadeFrames, 0);
+		default:
+			if(format.sample.isSigned)
+				return concealSamples((int8*)samples, frames, channels, (const int8*)lastSamples.data(),
+					lastFrames, gain, fadeFrames, 0);
+			else
+				return concealSamples((uint8*)samples, frames, channels, (const uint8*)lastSamples.data(),
+					lastFrames, gain, fadeFrames, 128);
+	}
+}
+
+void PullBuffer::fadeIn(char *samples, uint frames)
+{
+	if(gain == fadeFrames)
+		return;
+	auto channels = format.channels;
+	switch(format.sample.toBits())
+	{
+		case 16:
+			return fadeInSamples((int16*)samples, frames, channels, gain, fadeFrames, 0);
+		default:
+			if(format.sample.isSigned)
+				return fadeInSamples((int8*)samples, frames, channels, gain, fadeFrames, 0);
+			else
+				return fadeInSamples((uint8*)samples, frames, channels, gain, fadeFrames, 128);
+	}
+}
+
+uint PullBuffer::framesQueued() const
+{
+	return format.bytesToFrames(rBuff.writtenSize());
+}
+
+uint PullBuffer::framesFree() const
+{
+	return format.bytesToFrames(rBuff.freeSpace());
+}
+
+PullStats PullBuffer::stats() const
+{
+	PullStats s;
+	s.underruns = underruns;
+	s.concealedFrames = concealedFrames;
+	s.droppedFrames = droppedFrames;
+	s.minQueuedFrames = minQueuedFrames;
+	return s;
+}
+
+void PullBuffer::resetStats()
+{
+	underruns = 0;
+	concealedFrames = 0;
+	droppedFrames = 0;
+	minQueuedFrames = capacityFrames;
+}
+
+}
@@ -0,0 +1,215 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "Resampler"
+#include <imagine/util/audio/Resampler.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/algorithm.h>
+#include <imagine/util/utility.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if defined __SSE2__
+#include <emmintrin.h>
+#elif defined __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Audio
+{
+
+// phases per input sample, the position's fraction is truncated to this resolution
+static constexpr uint PHASE_BITS = 8;
+static constexpr uint PHASES = 1 << PHASE_BITS;
+
+static double besselI0(double x)
+{
+	double sum = 1, term = 1;
+	for(uint k = 1; k < 32; k++)
+	{
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+static int16 clampSample(int32 s)
+{
+	return std::min(std::max(s, -32768), 32767);
+}
+
+// dot product of taps samples and Q15 coefficients, taps is a multiple of 8
+static int32 dotProduct(const int16 *x, const int16 *c, uint taps)
+{
+	#if defined __SSE2__
+	__m128i acc = _mm_setzero_si128();
+	for(uint i = 0; i < taps; i += 8)
+	{
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(x + i)),
+			_mm_loadu_si128((const __m128i*)(c + i))));
+	}
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(acc);
+	#elif defined __ARM_NEON
+	int32x4_t acc = vdupq_n_s32(0);
+	for(uint i = 0; i < taps; i += 8)
+	{
+		int16x8_t xv = vld1q_s16(x + i);
+		int16x8_t cv = vld1q_s16(c + i);
+		acc = vmlal_s16(acc, vget_low_s16(xv), vget_low_s16(cv));
+		acc = vmlal_s16(acc, vget_high_s16(xv), vget_high_s16(cv));
+	}
+	#if defined __aarch64__
+	return vaddvq_s32(acc);
+	#else
+	int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+	return vget_lane_s32(vpadd_s32(sum, sum), 0);
+	#endif
+	#else
+	int32 sum = 0;
+	iterateTimes(taps, i)
+	{
+		sum += x[i] * c[i];
+	}
+	return sum;
+	#endif
+}
+
+void Resampler::init(double inputRate, double outputRate, uint channels_, Quality quality)
+{
+	assert(channels_ && channels_ <= MAX_CHANNELS);
+	assert(inputRate > 0 && outputRate > 0);
+	uint newTaps;
+	double beta;
+	switch(quality)
+	{
+		case Quality::LOW: newTaps = 8; beta = 5.; break;
+		default:
+		case Quality::MEDIUM: newTaps = 16; beta = 7.; break;
+		case Quality::HIGH: newTaps = 32; beta = 9.; break;
+	}
+	double newCutoff = std::min(1., outputRate / inputRate) * .95;
+	if(*this && newTaps == taps && channels_ == channels
+		&& std::min(1., outRate / inRate) * .95 == newCutoff)
+	{
+		// only the ratio changed, keep the filter and history
+		inRate = inputRate;
+		outRate = outputRate;
+		setRatioAdjust(1.);
+		return;
+	}
+	taps = newTaps;
+	channels = channels_;
+	inRate = inputRate;
+	outRate = outputRate;
+	coeff.resize(PHASES * taps);
+	double center = taps / 2 - 1;
+	iterateTimes(PHASES, p)
+	{
+		double frac = (double)p / PHASES;
+		double c[taps];
+		double sum = 0;
+		iterateTimes(taps, t)
+		{
+			double x = (t - center - frac);
+			double sinc = x == 0. ? 1. : std::sin(M_PI * x * newCutoff) / (M_PI * x * newCutoff);
+			double w = x / (taps / 2.);
+			double window = std::abs(w) >= 1. ? 0. : besselI0(beta * std::sqrt(1. - w * w)) / besselI0(beta);
+			c[t] = sinc * window;
+			sum += c[t];
+		}
+		// normalize each phase to unity gain so DC passes unchanged
+		iterateTimes(taps, t)
+		{
+			coeff[p * taps + t] = std::lround(c[t] / sum * 32767.);
+		}
+	}
+	setRatioAdjust(1.);
+	reset();
+	logMsg("resampling %.2fHz -> %.2fHz with %u taps", inRate, outRate, taps);
+}
+
+void Resampler::deinit()
+{
+	coeff.clear();
+	coeff.shrink_to_fit();
+	for(auto &h : history)
+	{
+		h.clear();
+		h.shrink_to_fit();
+	}
+	taps = 0;
+}
+
+void Resampler::reset()
+{
+	iterateTimes(channels, ch)
+	{
+		history[ch].assign(taps - 1, 0);
+	}
+	pos = 0;
+}
+
+void Resampler::setRatioAdjust(double adjust)
+{
+	step = std::llround(inRate / (outRate * adjust) * 4294967296.);
+}
+
+uint Resampler::maxOutputFrames(uint inputFrames) const
+{
+	if(unlikely(!step))
+		return 0;
+	return std::ceil(inputFrames * 4294967296. / step) + 1;
+}
+
+uint Resampler::resample(int16 *out, const int16 *in, uint inputFrames)
+{
+	assumeExpr(taps);
+	auto histFrames = history[0].size();
+	iterateTimes(channels, ch)
+	{
+		auto &h = history[ch];
+		h.resize(histFrames + inputFrames);
+		iterateTimes(inputFrames, i)
+		{
+			h[histFrames + i] = in[i * channels + ch];
+		}
+	}
+	histFrames += inputFrames;
+	uint outFrames = 0;
+	for(uint idx = pos >> 32; idx + taps <= histFrames; idx = pos >> 32)
+	{
+		uint phase = (uint32)pos >> (32 - PHASE_BITS);
+		auto c = &coeff[phase * taps];
+		iterateTimes(channels, ch)
+		{
+			*out++ = clampSample((dotProduct(&history[ch][idx], c, taps) + (1 << 14)) >> 15);
+		}
+		outFrames++;
+		pos += step;
+	}
+	// drop consumed input, keeping what the next outputs need
+	uint consumed = std::min((uint)(pos >> 32), (uint)histFrames);
+	iterateTimes(channels, ch)
+	{
+		auto &h = history[ch];
+		h.erase(h.begin(), h.begin() + consumed);
+	}
+	pos -= (uint64_t)consumed << 32;
+	return outFrames;
+}
+
+}
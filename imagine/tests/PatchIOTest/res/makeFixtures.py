@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+# Writes the PatchIOTest fixtures: a ROM, the same ROM deflated in a zip,
+# IPS/UPS/BPS patches from it to one target, and the expected target.
+
+import struct, zipfile, zlib
+
+def makeRom(size):
+	rom = bytearray(size)
+	x = 12345
+	for i in range(size):
+		x = (x * 1103515245 + 12345) & 0x7fffffff
+		# mostly repeating so the zip entry really is compressed
+		rom[i] = (i >> 4) & 0xff if x & 0x300 else (x >> 16) & 0xff
+	return bytes(rom)
+
+src = makeRom(48 * 1024)
+dst = bytearray(src)
+dst[0x100:0x110] = b'PATCHED HEADER!!'
+dst[0x2000:0x2400] = bytes([0x5a]) * 0x400
+dst[0x8000:0x9000] = src[0x1000:0x2000] # copied from earlier in the source
+dst[0xbff0:0xc000] = bytes(range(16))
+dst += b'appended past the original end' * 4
+dst = bytes(dst)
+
+def ips():
+	out = bytearray(b'PATCH')
+	i = 0
+	while i < len(dst):
+		if i < len(src) and src[i] == dst[i]:
+			i += 1
+			continue
+		start = i
+		while i < len(dst) and i - start < 0xffff and not (i < len(src) and src[i] == dst[i]):
+			i += 1
+		run = dst[start:i]
+		if len(set(run)) == 1 and len(run) > 8:
+			out += struct.pack('>I', start)[1:] + b'\0\0' + struct.pack('>H', len(run)) + run[:1]
+		else:
+			out += struct.pack('>I', start)[1:] + struct.pack('>H', len(run)) + run
+	return bytes(out + b'EOF')
+
+def number(n):
+	out = bytearray()
+	while True:
+		x = n & 0x7f
+		n >>= 7
+		if not n:
+			out.append(0x80 | x)
+			return out
+		out.append(x)
+		n -= 1
+
+def footer(patch):
+	patch += struct.pack('<II', zlib.crc32(src), zlib.crc32(dst))
+	return bytes(patch + struct.pack('<I', zlib.crc32(patch)))
+
+def ups():
+	out = bytearray(b'UPS1') + number(len(src)) + number(len(dst))
+	byteAt = lambda data, i: data[i] if i < len(data) else 0
+	pos = last = 0
+	while pos < len(dst):
+		if byteAt(src, pos) == dst[pos]:
+			pos += 1
+			continue
+		out += number(pos - last)
+		while pos < len(dst) and byteAt(src, pos) != dst[pos]:
+			out.append(byteAt(src, pos) ^ dst[pos])
+			pos += 1
+		out.append(0)
+		pos += 1
+		last = pos
+	return footer(out)
+
+def bps():
+	out = bytearray(b'BPS1') + number(len(src)) + number(len(dst)) + number(0)
+	def action(cmd, size):
+		out.extend(number(((size - 1) << 2) | cmd))
+	srcRel = 0
+	def sourceCopy(offset, size):
+		nonlocal srcRel
+		action(2, size)
+		delta = offset - srcRel
+		out.extend(number((abs(delta) << 1) | (delta < 0)))
+		srcRel = offset + size
+	action(0, 0x100)
+	action(1, 0x10); out.extend(dst[0x100:0x110])
+	action(0, 0x2000 - 0x110)
+	action(1, 1); out.extend(dst[0x2000:0x2001])
+	action(3, 0x3ff); out.extend(number(0x2000 << 1)) # repeats the 0x5a byte
+	sourceCopy(0x2400, 0x8000 - 0x2400)
+	sourceCopy(0x1000, 0x1000) # backwards seek in the source
+	sourceCopy(0x9000, 0xbff0 - 0x9000)
+	action(1, len(dst) - 0xbff0); out.extend(dst[0xbff0:])
+	return footer(out)
+
+def applyBPS(patch):
+	# reference decoder to check the encoder above
+	p = 4
+	def num():
+		nonlocal p
+		data, shift = 0, 1
+		while True:
+			x = patch[p]; p += 1
+			data += (x & 0x7f) * shift
+			if x & 0x80:
+				return data
+			shift <<= 7
+			data += shift
+	num(); num()
+	metadataSize = num()
+	p += metadataSize
+	out = bytearray()
+	srcRel = dstRel = 0
+	while p < len(patch) - 12:
+		data = num()
+		cmd, size = data & 3, (data >> 2) + 1
+		if cmd == 0:
+			out += src[len(out):len(out) + size]
+		elif cmd == 1:
+			out += patch[p:p + size]; p += size
+		else:
+			d = num()
+			delta = -(d >> 1) if d & 1 else d >> 1
+			if cmd == 2:
+				srcRel += delta
+				out += src[srcRel:srcRel + size]; srcRel += size
+			else:
+				dstRel += delta
+				for i in range(size):
+					out.append(out[dstRel]); dstRel += 1
+	return bytes(out)
+
+bpsPatch = bps()
+assert applyBPS(bpsPatch) == dst
+open('rom.bin', 'wb').write(src)
+with zipfile.ZipFile('rom.zip', 'w', zipfile.ZIP_DEFLATED) as z:
+	z.write('rom.bin')
+open('rom.ips', 'wb').write(ips())
+open('rom.ups', 'wb').write(ups())
+open('rom.bps', 'wb').write(bpsPatch)
+open('expected.bin', 'wb').write(dst)
@@ -0,0 +1,141 @@
+/*  This file is part of Imagine.
+
+	Imagine is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Imagine is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Imagine.  If not, see <http://www.gnu.org/licenses/> */
+
+#define LOGTAG "PatchIOTest"
+#include <imagine/base/Base.hh>
+#include <imagine/fs/FS.hh>
+#include <imagine/fs/ArchiveFS.hh>
+#include <imagine/io/FileIO.hh>
+#include <imagine/io/PatchIO.hh>
+#include <imagine/logger/logger.h>
+#include <imagine/util/string.h>
+#include <cstring>
+#include <vector>
+
+// Applies the patches in res/ (see res/makeFixtures.py) to rom.bin, both
+// directly and as a deflated zip entry, and compares the output with
+// expected.bin. Run with the res directory as the argument, the exit
+// status is the number of failed cases.
+
+static const char *fixtureDir = "res";
+
+static FS::PathString fixturePath(const char *name)
+{
+	return FS::makePathStringPrintf("%s/%s", fixtureDir, name);
+}
+
+static GenericIO openSource(bool zipped)
+{
+	if(!zipped)
+	{
+		FileIO io;
+		io.open(fixturePath("rom.bin"));
+		return io.makeGeneric();
+	}
+	std::error_code ec{};
+	for(auto &entry : FS::ArchiveIterator{fixturePath("rom.zip"), ec})
+	{
+		if(string_equal(entry.name(), "rom.bin"))
+		{
+			auto io = entry.moveIO();
+			return io.makeGeneric();
+		}
+	}
+	return {};
+}
+
+static bool runCase(const char *patchName, bool zipped, const std::vector<char> &expected)
+{
+	auto source = openSource(zipped);
+	FileIO patchFile;
+	patchFile.open(fixturePath(patchName));
+	if(!source || !patchFile)
+	{
+		logErr("%s%s: missing fixture", patchName, zipped ? " (zip)" : "");
+		return false;
+	}
+	PatchIO patchIO;
+	if(auto ec = patchIO.open(source, patchFile);
+		ec)
+	{
+		logErr("%s%s: open failed: %s", patchName, zipped ? " (zip)" : "", ec.message().c_str());
+		return false;
+	}
+	if(patchIO.size() != expected.size())
+	{
+		logErr("%s%s: size %zu != %zu", patchName, zipped ? " (zip)" : "", patchIO.size(), expected.size());
+		return false;
+	}
+	// sequential reads in chunks that straddle the patched ranges
+	std::vector<char> out(expected.size());
+	for(size_t pos = 0; pos < out.size();)
+	{
+		auto bytes = patchIO.read(&out[pos], std::min((size_t)1000, out.size() - pos));
+		if(bytes <= 0)
+		{
+			logErr("%s%s: read failed at %zu", patchName, zipped ? " (zip)" : "", pos);
+			return false;
+		}
+		pos += bytes;
+	}
+	if(out != expected)
+	{
+		logErr("%s%s: output differs", patchName, zipped ? " (zip)" : "");
+		return false;
+	}
+	// random access, going backwards through the source
+	for(off_t offset : {0xbff8, 0x8800, 0x2000, 0x100})
+	{
+		char buff[64];
+		if(patchIO.readAtPos(buff, sizeof(buff), offset) != (ssize_t)sizeof(buff)
+			|| memcmp(buff, &expected[offset], sizeof(buff)) != 0)
+		{
+			logErr("%s%s: readAtPos differs at 0x%X", patchName, zipped ? " (zip)" : "", (uint)offset);
+			return false;
+		}
+	}
+	logMsg("%s%s: passed", patchName, zipped ? " (zip)" : "");
+	return true;
+}
+
+namespace Base
+{
+
+void onInit(int argc, char** argv)
+{
+	if(argc > 1)
+		fixtureDir = argv[1];
+	FileIO expectedFile;
+	expectedFile.open(fixturePath("expected.bin"));
+	std::vector<char> expected(expectedFile.size());
+	if(!expectedFile || expectedFile.read(expected.data(), expected.size()) != (ssize_t)expected.size())
+	{
+		Base::exitWithErrorMessagePrintf(-1, "Error reading fixtures from %s", fixtureDir);
+		return;
+	}
+	int failures = 0;
+	for(auto patchName : {"rom.ips", "rom.ups", "rom.bps"})
+	{
+		for(bool zipped : {false, true})
+		{
+			if(!runCase(patchName, zipped, expected))
+				failures++;
+		}
+	}
+	logMsg("%d failures", failures);
+	Base::exit(failures);
+}
+
+}